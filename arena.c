@@ -0,0 +1,189 @@
+#include "m3d/m3d.h"
+#include "internal.h"
+#include <stdlib.h>
+
+// offset of the next multiple of align from address base + used, align is a power of two
+static inline size_t alignUpInternal(const unsigned char *base, size_t used, size_t align)
+{
+    uintptr_t address = (uintptr_t)(base + used);
+    return used + (size_t)((align - (address & (align - 1))) & (align - 1));
+}
+
+M3D_API char m3dArenaInit(M3dArena *a, size_t size)
+{
+    M3D_PROFILE_FUNCTION();
+    // malloc only promises the alignment of the largest scalar type, so the block is
+    // over allocated and its start moved up instead of relying on posix_memalign
+    unsigned char *allocation = size <= SIZE_MAX - M3D_ARENA_ALIGN ? (unsigned char *)malloc(size + M3D_ARENA_ALIGN) : NULL;
+
+    if(!allocation)
+    {
+        *a = (M3dArena){NULL, 0, 0, 0, NULL};
+        return 0;
+    }
+
+    a->allocation = allocation;
+    a->base = allocation + alignUpInternal(allocation, 0, M3D_ARENA_ALIGN);
+    a->size = size;
+    a->used = 0;
+    a->peak = 0;
+
+    return 1;
+}
+
+M3D_API void m3dArenaInitBuffer(M3dArena *a, void *buffer, size_t size)
+{
+    M3D_PROFILE_FUNCTION();
+    unsigned char *bytes = (unsigned char *)buffer;
+    size_t skip = alignUpInternal(bytes, 0, M3D_ARENA_ALIGN);
+
+    a->allocation = NULL;
+    a->base = bytes + skip;
+    a->size = size > skip ? size - skip : 0;
+    a->used = 0;
+    a->peak = 0;
+}
+
+M3D_API void m3dArenaFree(M3dArena *a)
+{
+    M3D_PROFILE_FUNCTION();
+    free(a->allocation);
+    *a = (M3dArena){NULL, 0, 0, 0, NULL};
+}
+
+M3D_API void *m3dArenaAllocAligned(M3dArena *a, size_t size, size_t align)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t begin = alignUpInternal(a->base, a->used, align);
+
+    if(begin > a->size || size > a->size - begin)
+    {
+        return NULL;
+    }
+
+    a->used = begin + size;
+    a->peak = a->used > a->peak ? a->used : a->peak;
+
+    return a->base + begin;
+}
+
+M3D_API void *m3dArenaAlloc(M3dArena *a, size_t size)
+{
+    M3D_PROFILE_FUNCTION();
+    return m3dArenaAllocAligned(a, size, M3D_ARENA_ALIGN);
+}
+
+M3D_API size_t m3dArenaMark(const M3dArena *a)
+{
+    M3D_PROFILE_FUNCTION();
+    return a->used;
+}
+
+M3D_API void m3dArenaRelease(M3dArena *a, size_t mark)
+{
+    M3D_PROFILE_FUNCTION();
+    if(mark < a->used)
+    {
+        a->used = mark;
+    }
+}
+
+M3D_API void m3dArenaReset(M3dArena *a)
+{
+    M3D_PROFILE_FUNCTION();
+    a->used = 0;
+}
+
+/** ---------------- typed blocks */
+
+// count elements of size bytes, NULL when the byte count doesn't fit in a size_t
+static inline void *allocArrayInternal(M3dArena *a, size_t count, size_t size)
+{
+    if(count > SIZE_MAX / size)
+    {
+        return NULL;
+    }
+
+    return m3dArenaAlloc(a, count * size);
+}
+
+M3D_API Vec3 *m3dArenaAllocVec3(M3dArena *a, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    return (Vec3 *)allocArrayInternal(a, count, sizeof(Vec3));
+}
+
+M3D_API Quat *m3dArenaAllocQuat(M3dArena *a, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    return (Quat *)allocArrayInternal(a, count, sizeof(Quat));
+}
+
+M3D_API Mat4x4 *m3dArenaAllocMat4x4(M3dArena *a, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    return (Mat4x4 *)allocArrayInternal(a, count, sizeof(Mat4x4));
+}
+
+// every component starts on its own boundary, so the gaps let simd loops read whole vectors past count
+static char allocComponentsInternal(M3dArena *a, size_t count, int components, M3dValue **res)
+{
+    if(count > (SIZE_MAX - (M3D_ARENA_ALIGN - 1)) / sizeof(M3dValue))
+    {
+        return 0;
+    }
+
+    size_t stride = (count * sizeof(M3dValue) + M3D_ARENA_ALIGN - 1) & ~(size_t)(M3D_ARENA_ALIGN - 1);
+    unsigned char *block = stride <= SIZE_MAX / (size_t)components ? (unsigned char *)m3dArenaAlloc(a, stride * (size_t)components) : NULL;
+
+    if(!block)
+    {
+        return 0;
+    }
+
+    for(int c = 0; c < components; c++)
+    {
+        res[c] = (M3dValue *)(block + stride * (size_t)c);
+    }
+
+    return 1;
+}
+
+M3D_API Vec3Soa m3dArenaAllocVec3Soa(M3dArena *a, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    M3dValue *c[3] = {NULL, NULL, NULL};
+
+    if(!allocComponentsInternal(a, count, 3, c))
+    {
+        return (Vec3Soa){NULL, NULL, NULL, 0};
+    }
+
+    return (Vec3Soa){c[0], c[1], c[2], count};
+}
+
+M3D_API Vec4Soa m3dArenaAllocVec4Soa(M3dArena *a, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    M3dValue *c[4] = {NULL, NULL, NULL, NULL};
+
+    if(!allocComponentsInternal(a, count, 4, c))
+    {
+        return (Vec4Soa){NULL, NULL, NULL, NULL, 0};
+    }
+
+    return (Vec4Soa){c[0], c[1], c[2], c[3], count};
+}
+
+M3D_API QuatSoa m3dArenaAllocQuatSoa(M3dArena *a, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    M3dValue *c[4] = {NULL, NULL, NULL, NULL};
+
+    if(!allocComponentsInternal(a, count, 4, c))
+    {
+        return (QuatSoa){NULL, NULL, NULL, NULL, 0};
+    }
+
+    return (QuatSoa){c[0], c[1], c[2], c[3], count};
+}
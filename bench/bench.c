@@ -0,0 +1,839 @@
+/** m3d micro benchmarks
+
+    times every public function as a dependent chain of single calls (latency) and as
+    independent calls over an array (throughput), then prints ns/op and cycles/op.
+
+    build next to the library sources, float, double or fixed point:
+        cc -O2 -I. bench/bench.c $(ls *.c | grep -v main.c) -lm -o m3dbench
+        cc -O2 -I. -DM3D_DOUBLE bench/bench.c $(ls *.c | grep -v main.c) -lm -o m3dbench_double
+        cc -O2 -I. -DM3D_FIXED bench/bench.c $(ls *.c | grep -v main.c) -lm -o m3dbench_fixed
+    fixed builds only time the functions m3d.h keeps in fixed point, the scalar vectors,
+    quaternions and arenas
+    header only, with the library inlined into the benchmarks, which should build without warnings:
+        cc -O2 -I. -DM3D_INLINE bench/bench.c -lm -o m3dbench_inline
+    add -DM3D_FAST_MATH to time the approximate sqrt and trig paths, -fopenmp for the threaded updates
+
+    usage: m3dbench [--json file] [--filter text] [--quick]
+    --json writes the results as machine readable json for comparing runs across commits */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include "m3d/m3d.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define BENCH_HAS_TSC
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define BENCH_HAS_TSC
+#endif
+
+#if defined(M3D_DOUBLE)
+#define BENCH_PRECISION "double"
+#elif defined(M3D_FIXED)
+#define BENCH_PRECISION "fixed"
+#else
+#define BENCH_PRECISION "float"
+#endif // M3D_DOUBLE
+
+/** ---------------- inputs */
+
+// a power of two so the index wraps with a mask, small enough to stay in cache
+#define BENCH_N 1024
+#define BENCH_MASK (BENCH_N - 1)
+#define BENCH_PAD 4
+
+static M3dValue s[BENCH_N + BENCH_PAD];
+static Vec2 v2[BENCH_N + BENCH_PAD];
+static Vec3 v3[BENCH_N + BENCH_PAD];
+static Vec4 v4[BENCH_N + BENCH_PAD];
+static Quat q[BENCH_N + BENCH_PAD];
+static Vec3 v3r[BENCH_N];
+static Quat qr[BENCH_N];
+
+// scratch the in place functions are allowed to overwrite
+static Quat qw[BENCH_N + BENCH_PAD];
+
+static M3dValue soaData[12][BENCH_N];
+static M3dValue soaRes[BENCH_N];
+
+static unsigned char arenaBuffer[1 << 16];
+static M3dArena arena;
+// for the init functions, so they don't replace the arena the allocation benchmarks use
+static M3dArena arenaHeap;
+
+static M3dProfileEntry profileEntries[64];
+static char profileText[1 << 14];
+
+#ifndef M3D_FIXED
+static Mat3x3 m3[BENCH_N + BENCH_PAD];
+static Mat4x4 m4[BENCH_N + BENCH_PAD];
+static Mat3x3 m3w[BENCH_N + BENCH_PAD];
+static Mat4x4 m4w[BENCH_N + BENCH_PAD];
+
+static Vec2Soa soa2a, soa2b, soa2r;
+static Vec3Soa soa3a, soa3b, soa3r;
+static Vec4Soa soa4a, soa4b, soa4r;
+static QuatSoa soaq;
+
+static Vec2 v2r[BENCH_N];
+static Vec4 v4r[BENCH_N];
+
+static PackedQuat32 pq32[BENCH_N];
+static PackedQuat48 pq48[BENCH_N];
+static PackedVec3 pv3[BENCH_N];
+
+static size_t hierParent[BENCH_N];
+static size_t hierLevels[BENCH_N + 1];
+static M3dHierarchy hier;
+
+static Aabb aabbs[BENCH_N];
+static uint32_t bvhIndices[BENCH_N];
+static M3dBvhNode bvhNodes[2 * BENCH_N];
+static M3dBvh bvh;
+static M3dValue bvhT;
+
+static Frustum frustum;
+static uint32_t cullMask[BENCH_N / 32];
+static uint32_t cullIndices[BENCH_N];
+static Mat4x4 m4r[BENCH_N];
+
+static Vec3A v3a[BENCH_N + BENCH_PAD];
+static Vec3A v3ar[BENCH_N];
+static Mat3x4 m34[BENCH_N + BENCH_PAD];
+static Mat3x4 m34r[BENCH_N];
+static M3D_ALIGN(16) float exportBuffer[16 * BENCH_N];
+static Vec2 spriteQuads[4 * BENCH_N];
+static const Vec2 spriteCorners[4] = {{-0.5f, -0.5f}, {0.5f, -0.5f}, {0.5f, 0.5f}, {-0.5f, 0.5f}};
+
+#define BENCH_BONES 64
+static DualQuat dq[BENCH_N + BENCH_PAD];
+// rotation and translation only, the input of the conversions back to quaternions
+static Mat4x4 m4rigid[BENCH_N + BENCH_PAD];
+static uint16_t skinBones[4 * BENCH_N];
+static M3dValue skinWeights[4 * BENCH_N];
+static Vec3 skinNormals[BENCH_N];
+static M3dSkin skin;
+#endif // M3D_FIXED
+
+// always 0, but the compiler can't prove it, used to chain calls through their results
+static volatile unsigned char opaqueZeroSource = 0;
+static unsigned char opaqueZero;
+
+static M3dValue randomValue(double low, double high)
+{
+    double v = low + (high - low) * (double)rand() / (double)RAND_MAX;
+
+    return M3D_VALUE(v);
+}
+
+static void initInputs()
+{
+    srand(1234);
+
+    for(size_t i = 0; i < BENCH_N + BENCH_PAD; i++)
+    {
+        s[i] = randomValue(0.1, 1);
+        v2[i] = (Vec2){randomValue(-1, 1), randomValue(-1, 1)};
+        v3[i] = (Vec3){randomValue(-1, 1), randomValue(-1, 1), randomValue(-1, 1)};
+        v4[i] = (Vec4){randomValue(-1, 1), randomValue(-1, 1), randomValue(-1, 1), randomValue(-1, 1)};
+        q[i] = m3dQuatNormalized((Quat){randomValue(-1, 1), randomValue(-1, 1), randomValue(-1, 1), randomValue(-1, 1)});
+        qw[i] = q[i];
+
+#ifndef M3D_FIXED
+        for(int r = 0; r < 4; r++)
+        {
+            for(int c = 0; c < 4; c++)
+            {
+                m4[i].m[r][c] = randomValue(-1, 1) + (r == c ? 2 : 0);
+            }
+        }
+
+        m3[i] = m3dMat3x3FromMat4x4(m4[i]);
+        v3a[i] = m3dVec3AFromVec3(v3[i]);
+        m34[i] = m3dMat3x4FromMat4x4(m4[i]);
+        dq[i] = m3dDualQuatFromTr(v3[i], q[i]);
+        m4rigid[i] = m3dDualQuatToMat4x4(dq[i]);
+        m3w[i] = m3[i];
+        m4w[i] = m4[i];
+#endif // M3D_FIXED
+    }
+
+    for(int a = 0; a < 12; a++)
+    {
+        for(size_t i = 0; i < BENCH_N; i++)
+        {
+            soaData[a][i] = randomValue(-1, 1);
+        }
+    }
+
+    m3dArenaInitBuffer(&arena, arenaBuffer, sizeof(arenaBuffer));
+
+#ifndef M3D_FIXED
+    soa2a = (Vec2Soa){soaData[0], soaData[1], BENCH_N};
+    soa2b = (Vec2Soa){soaData[4], soaData[5], BENCH_N};
+    soa2r = (Vec2Soa){soaData[8], soaData[9], BENCH_N};
+    soa3a = (Vec3Soa){soaData[0], soaData[1], soaData[2], BENCH_N};
+    soa3b = (Vec3Soa){soaData[4], soaData[5], soaData[6], BENCH_N};
+    soa3r = (Vec3Soa){soaData[8], soaData[9], soaData[10], BENCH_N};
+    soa4a = (Vec4Soa){soaData[0], soaData[1], soaData[2], soaData[3], BENCH_N};
+    soa4b = (Vec4Soa){soaData[4], soaData[5], soaData[6], soaData[7], BENCH_N};
+    soa4r = (Vec4Soa){soaData[8], soaData[9], soaData[10], soaData[11], BENCH_N};
+    soaq = (QuatSoa){soaData[0], soaData[1], soaData[2], soaData[3], BENCH_N};
+
+    // 4 roots and 4 children per node, breadth first so it is sorted by depth
+    for(size_t i = 0; i < BENCH_N; i++)
+    {
+        hierParent[i] = i < 4 ? M3D_HIERARCHY_NO_PARENT : (i - 4) / 4;
+    }
+
+    // 2 to 4 influences per vertex with weights summing to 1
+    for(size_t i = 0; i < BENCH_N; i++)
+    {
+        M3dValue sum = 0;
+
+        for(int k = 0; k < 4; k++)
+        {
+            skinBones[4 * i + k] = (uint16_t)(rand() % BENCH_BONES);
+            skinWeights[4 * i + k] = k < 2 + (int)(i % 3) ? s[i + k] : 0;
+            sum += skinWeights[4 * i + k];
+        }
+
+        for(int k = 0; k < 4; k++)
+        {
+            skinWeights[4 * i + k] /= sum;
+        }
+    }
+
+    skin = (M3dSkin){m4, NULL, skinBones, skinWeights, v3, v3 + 1, v3r, skinNormals, BENCH_N};
+
+    m3dQuatEncode32Array(pq32, q, BENCH_N);
+    m3dQuatEncode48Array(pq48, q, BENCH_N);
+    m3dVec3Encode48Array(pv3, v3, BENCH_N, (Vec3){-1, -1, -1}, (Vec3){1, 1, 1});
+
+    // small boxes scattered through the unit cube
+    for(size_t i = 0; i < BENCH_N; i++)
+    {
+        Vec3 e = {s[i] * 0.05f, s[i + 1] * 0.05f, s[i + 2] * 0.05f};
+        aabbs[i] = (Aabb){m3dVec3SubVec3(v3[i], e), m3dVec3AddVec3(v3[i], e)};
+    }
+
+    bvh = (M3dBvh){aabbs, bvhIndices, bvhNodes, 0, BENCH_N};
+    m3dBvhBuild(&bvh);
+
+    frustum = m3dFrustumFromMat4x4(m3dMat4x4InitPerspective(16, 9, 1.2f, 0.1f, 100));
+
+    hier = (M3dHierarchy){v3, q, v3 + 1, hierParent, m4r, hierLevels, 0, BENCH_N};
+    m3dHierarchyBuildLevels(&hier);
+#endif // M3D_FIXED
+
+    opaqueZero = opaqueZeroSource;
+}
+
+/** ---------------- benchmark list
+
+    X(kind, type, name, call), call can use the index i (inputs are padded for i + 3)
+    VALUE  call returns type, results are stored and chained for latency
+    OUT    call writes o[i], an array of type
+    BATCH  call processes BENCH_N elements at once
+    VOID   call has no result to chain
+    BENCHMARKS_FLOAT holds the functions m3d.h leaves out of fixed point builds */
+
+#define BENCHMARKS_COMMON(X) \
+    X(VALUE, unsigned int, m3dCpuFeatures, m3dCpuFeatures()) \
+    X(VOID, void, m3dCpuSetFeatures, m3dCpuSetFeatures(~0u)) \
+    X(VALUE, M3dValue, m3d1DClamp, m3d1DClamp(s[i], s[i + 1], s[i + 2])) \
+    X(VALUE, M3dValue, m3d1DLerp, m3d1DLerp(s[i], s[i + 1], s[i + 2])) \
+    X(BATCH, void, m3d1DSinCosArray, m3d1DSinCosArray(soaRes, soaData[8], s, BENCH_N)) \
+    \
+    X(VALUE, M3dValue, m3dVec2Angle, m3dVec2Angle(v2[i], v2[i + 1])) \
+    X(VALUE, M3dValue, m3dVec2Distance, m3dVec2Distance(v2[i], v2[i + 1])) \
+    X(VALUE, M3dValue, m3dVec2Dot, m3dVec2Dot(v2[i], v2[i + 1])) \
+    X(VALUE, M3dValue, m3dVec2Length, m3dVec2Length(v2[i])) \
+    X(VALUE, M3dValue, m3dVec2LengthSqr, m3dVec2LengthSqr(v2[i])) \
+    X(VALUE, Vec2, m3dVec2Lerp, m3dVec2Lerp(v2[i], v2[i + 1], s[i])) \
+    X(VALUE, Vec2, m3dVec2Max, m3dVec2Max(v2[i], v2[i + 1])) \
+    X(VALUE, Vec2, m3dVec2Min, m3dVec2Min(v2[i], v2[i + 1])) \
+    X(VALUE, Vec2, m3dVec2Normalized, m3dVec2Normalized(v2[i])) \
+    X(VALUE, Vec2, m3dVec2Reflect, m3dVec2Reflect(v2[i], v2[i + 1])) \
+    X(VALUE, Vec2, m3dVec2Slerp, m3dVec2Slerp(v2[i], v2[i + 1], s[i])) \
+    X(VALUE, Vec2, m3dVec2AddVec2, m3dVec2AddVec2(v2[i], v2[i + 1])) \
+    X(VALUE, Vec2, m3dVec2AddValue, m3dVec2AddValue(v2[i], s[i])) \
+    X(VALUE, Vec2, m3dVec2SubVec2, m3dVec2SubVec2(v2[i], v2[i + 1])) \
+    X(VALUE, Vec2, m3dVec2SubValue, m3dVec2SubValue(v2[i], s[i])) \
+    X(VALUE, Vec2, m3dVec2MulVec2, m3dVec2MulVec2(v2[i], v2[i + 1])) \
+    X(VALUE, Vec2, m3dVec2MulValue, m3dVec2MulValue(v2[i], s[i])) \
+    X(VALUE, Vec2, m3dVec2DivVec2, m3dVec2DivVec2(v2[i], v2[i + 1])) \
+    X(VALUE, Vec2, m3dVec2DivValue, m3dVec2DivValue(v2[i], s[i])) \
+    X(VALUE, char, m3dVec2Equal, m3dVec2Equal(v2[i], v2[i + 1])) \
+    \
+    X(VALUE, M3dValue, m3dVec3Angle, m3dVec3Angle(v3[i], v3[i + 1])) \
+    X(VALUE, Vec3, m3dVec3Cross, m3dVec3Cross(v3[i], v3[i + 1])) \
+    X(VALUE, M3dValue, m3dVec3Distance, m3dVec3Distance(v3[i], v3[i + 1])) \
+    X(VALUE, M3dValue, m3dVec3Dot, m3dVec3Dot(v3[i], v3[i + 1])) \
+    X(VALUE, M3dValue, m3dVec3Length, m3dVec3Length(v3[i])) \
+    X(VALUE, M3dValue, m3dVec3LengthSqr, m3dVec3LengthSqr(v3[i])) \
+    X(VALUE, Vec3, m3dVec3Lerp, m3dVec3Lerp(v3[i], v3[i + 1], s[i])) \
+    X(VALUE, Vec3, m3dVec3Max, m3dVec3Max(v3[i], v3[i + 1])) \
+    X(VALUE, Vec3, m3dVec3Min, m3dVec3Min(v3[i], v3[i + 1])) \
+    X(VALUE, Vec3, m3dVec3Normalized, m3dVec3Normalized(v3[i])) \
+    X(VALUE, Vec3, m3dVec3Reflect, m3dVec3Reflect(v3[i], v3[i + 1])) \
+    X(VALUE, Vec3, m3dVec3Slerp, m3dVec3Slerp(v3[i], v3[i + 1], s[i])) \
+    X(VALUE, Vec3, m3dVec3AddVec3, m3dVec3AddVec3(v3[i], v3[i + 1])) \
+    X(VALUE, Vec3, m3dVec3AddValue, m3dVec3AddValue(v3[i], s[i])) \
+    X(VALUE, Vec3, m3dVec3SubVec3, m3dVec3SubVec3(v3[i], v3[i + 1])) \
+    X(VALUE, Vec3, m3dVec3SubValue, m3dVec3SubValue(v3[i], s[i])) \
+    X(VALUE, Vec3, m3dVec3MulVec3, m3dVec3MulVec3(v3[i], v3[i + 1])) \
+    X(VALUE, Vec3, m3dVec3MulValue, m3dVec3MulValue(v3[i], s[i])) \
+    X(VALUE, Vec3, m3dVec3DivVec3, m3dVec3DivVec3(v3[i], v3[i + 1])) \
+    X(VALUE, Vec3, m3dVec3DivValue, m3dVec3DivValue(v3[i], s[i])) \
+    X(VALUE, char, m3dVec3Equal, m3dVec3Equal(v3[i], v3[i + 1])) \
+    \
+    X(VALUE, Vec4, m3dVec4AddVec4, m3dVec4AddVec4(v4[i], v4[i + 1])) \
+    X(VALUE, Vec4, m3dVec4AddValue, m3dVec4AddValue(v4[i], s[i])) \
+    X(VALUE, Vec4, m3dVec4SubVec4, m3dVec4SubVec4(v4[i], v4[i + 1])) \
+    X(VALUE, Vec4, m3dVec4SubValue, m3dVec4SubValue(v4[i], s[i])) \
+    X(VALUE, Vec4, m3dVec4MulVec4, m3dVec4MulVec4(v4[i], v4[i + 1])) \
+    X(VALUE, Vec4, m3dVec4MulValue, m3dVec4MulValue(v4[i], s[i])) \
+    X(VALUE, Vec4, m3dVec4DivVec4, m3dVec4DivVec4(v4[i], v4[i + 1])) \
+    X(VALUE, Vec4, m3dVec4DivValue, m3dVec4DivValue(v4[i], s[i])) \
+    X(VALUE, char, m3dVec4Equal, m3dVec4Equal(v4[i], v4[i + 1])) \
+    \
+    X(VALUE, M3dValue, m3dQuatAngle, m3dQuatAngle(q[i], q[i + 1])) \
+    X(VALUE, Quat, m3dQuatAngleVec3, m3dQuatAngleVec3(v3[i], v3[i + 1], v3[i + 2])) \
+    X(VALUE, Quat, m3dQuatAngleAxis, m3dQuatAngleAxis(s[i], v3[i])) \
+    X(VALUE, Quat, m3dQuatConjugate, m3dQuatConjugate(q[i])) \
+    X(VALUE, Vec3, m3dQuatEuler, m3dQuatEuler(q[i])) \
+    X(VALUE, Quat, m3dQuatFace, m3dQuatFace(v3[i], v3[i + 1])) \
+    X(VALUE, Quat, m3dQuatFromEuler, m3dQuatFromEuler(v3[i])) \
+    X(VALUE, M3dValue, m3dQuatLength, m3dQuatLength(q[i])) \
+    X(VALUE, Quat, m3dQuatLerp, m3dQuatLerp(q[i], q[i + 1], s[i])) \
+    X(VALUE, Quat, m3dQuatNormalized, m3dQuatNormalized(q[i])) \
+    X(VALUE, Vec3, m3dQuatRotateVec3, m3dQuatRotateVec3(q[i], v3[i])) \
+    X(VALUE, Quat, m3dQuatSlerp, m3dQuatSlerp(q[i], q[i + 1], s[i])) \
+    X(VALUE, Quat, m3dQuatSlerpFast, m3dQuatSlerpFast(q[i], q[i + 1], s[i])) \
+    X(VALUE, Quat, m3dQuatAddQuat, m3dQuatAddQuat(q[i], q[i + 1])) \
+    X(VALUE, Quat, m3dQuatSubQuat, m3dQuatSubQuat(q[i], q[i + 1])) \
+    X(VALUE, Quat, m3dQuatMulQuat, m3dQuatMulQuat(q[i], q[i + 1])) \
+    X(VALUE, Quat, m3dQuatMulValue, m3dQuatMulValue(q[i], s[i])) \
+    X(VALUE, Quat, m3dQuatDivValue, m3dQuatDivValue(q[i], s[i])) \
+    X(VALUE, char, m3dQuatEqual, m3dQuatEqual(q[i], q[i + 1])) \
+    X(OUT, Quat, m3dQuatMulQuatPtr, m3dQuatMulQuatPtr(&o[i], &q[i], &q[i + 1])) \
+    X(OUT, Quat, m3dQuatMulQuatInPlace, (o[i] = q[i], m3dQuatMulQuatInPlace(&o[i], &q[i + 1]))) \
+    X(OUT, Quat, m3dQuatPreMulQuatInPlace, (o[i] = q[i], m3dQuatPreMulQuatInPlace(&q[i + 1], &o[i]))) \
+    X(OUT, Quat, m3dQuatConjugateInPlace, m3dQuatConjugateInPlace(&o[i])) \
+    X(OUT, Quat, m3dQuatNormalizeInPlace, (o[i] = q[i], m3dQuatNormalizeInPlace(&o[i]))) \
+    X(OUT, Quat, m3dQuatSlerpPtr, m3dQuatSlerpPtr(&o[i], &q[i], &q[i + 1], s[i])) \
+    X(OUT, Quat, m3dQuatSlerpFastPtr, m3dQuatSlerpFastPtr(&o[i], &q[i], &q[i + 1], s[i])) \
+    X(OUT, Vec3, m3dQuatRotateVec3Ptr, m3dQuatRotateVec3Ptr(&o[i], &q[i], &v3[i])) \
+    \
+    X(BATCH, void, m3dQuatMulQuatArray, m3dQuatMulQuatArray(qr, q, q + 1, BENCH_N)) \
+    X(BATCH, void, m3dQuatRotateVec3Array, m3dQuatRotateVec3Array(v3r, q[0], v3, BENCH_N)) \
+    X(BATCH, void, m3dQuatArrayRotateVec3Array, m3dQuatArrayRotateVec3Array(v3r, q, v3, BENCH_N)) \
+    X(BATCH, void, m3dQuatSlerpArray, m3dQuatSlerpArray(qr, q, q + 1, s, BENCH_N)) \
+    X(BATCH, void, m3dQuatSlerpFastArray, m3dQuatSlerpFastArray(qr, q, q + 1, s, BENCH_N)) \
+    X(BATCH, void, m3dQuatAngleAxisArray, m3dQuatAngleAxisArray(qr, s, v3, BENCH_N)) \
+    X(BATCH, void, m3dQuatFromEulerArray, m3dQuatFromEulerArray(qr, v3, BENCH_N)) \
+    \
+    X(VOID, void, m3dArenaInit, (m3dArenaInit(&arenaHeap, sizeof(arenaBuffer)), m3dArenaFree(&arenaHeap))) \
+    X(VOID, void, m3dArenaInitBuffer, m3dArenaInitBuffer(&arenaHeap, arenaBuffer + 1, sizeof(arenaBuffer) - 1)) \
+    X(VOID, void, m3dArenaFree, (m3dArenaInitBuffer(&arenaHeap, arenaBuffer, sizeof(arenaBuffer)), m3dArenaFree(&arenaHeap))) \
+    X(VOID, void, m3dArenaAlloc, (m3dArenaReset(&arena), m3dArenaAlloc(&arena, 48), m3dArenaAlloc(&arena, 100))) \
+    X(VOID, void, m3dArenaAllocAligned, (m3dArenaReset(&arena), m3dArenaAllocAligned(&arena, 48, 16), m3dArenaAllocAligned(&arena, 100, 256))) \
+    X(VALUE, size_t, m3dArenaMark, m3dArenaMark(&arena)) \
+    X(VOID, void, m3dArenaRelease, (m3dArenaReset(&arena), m3dArenaAlloc(&arena, 48), m3dArenaRelease(&arena, 0))) \
+    X(VOID, void, m3dArenaReset, m3dArenaReset(&arena)) \
+    X(VOID, void, m3dArenaAllocVec3, (m3dArenaReset(&arena), m3dArenaAllocVec3(&arena, 256))) \
+    X(VOID, void, m3dArenaAllocQuat, (m3dArenaReset(&arena), m3dArenaAllocQuat(&arena, 256))) \
+    X(VOID, void, m3dArenaAllocMat4x4, (m3dArenaReset(&arena), m3dArenaAllocMat4x4(&arena, 256))) \
+    X(VOID, void, m3dArenaAllocVec3Soa, (m3dArenaReset(&arena), m3dArenaAllocVec3Soa(&arena, 256))) \
+    X(VOID, void, m3dArenaAllocVec4Soa, (m3dArenaReset(&arena), m3dArenaAllocVec4Soa(&arena, 256))) \
+    X(VOID, void, m3dArenaAllocQuatSoa, (m3dArenaReset(&arena), m3dArenaAllocQuatSoa(&arena, 256))) \
+    \
+    X(VALUE, size_t, m3dProfileSnapshot, m3dProfileSnapshot(profileEntries, 64)) \
+    X(VOID, void, m3dProfileReset, m3dProfileReset()) \
+    X(VALUE, size_t, m3dProfileFormatText, m3dProfileFormatText(profileText, sizeof(profileText))) \
+    X(VALUE, size_t, m3dProfileFormatJson, m3dProfileFormatJson(profileText, sizeof(profileText)))
+
+#ifndef M3D_FIXED
+#define BENCHMARKS_FLOAT(X) \
+    X(VALUE, Vec3A, m3dVec3AFromVec3, m3dVec3AFromVec3(v3[i])) \
+    X(VALUE, Vec3, m3dVec3AToVec3, m3dVec3AToVec3(v3a[i])) \
+    X(VALUE, Vec3A, m3dVec3AAddVec3A, m3dVec3AAddVec3A(v3a[i], v3a[i + 1])) \
+    X(VALUE, Vec3A, m3dVec3AAddValue, m3dVec3AAddValue(v3a[i], s[i])) \
+    X(VALUE, Vec3A, m3dVec3ASubVec3A, m3dVec3ASubVec3A(v3a[i], v3a[i + 1])) \
+    X(VALUE, Vec3A, m3dVec3ASubValue, m3dVec3ASubValue(v3a[i], s[i])) \
+    X(VALUE, Vec3A, m3dVec3AMulVec3A, m3dVec3AMulVec3A(v3a[i], v3a[i + 1])) \
+    X(VALUE, Vec3A, m3dVec3AMulValue, m3dVec3AMulValue(v3a[i], s[i])) \
+    X(VALUE, Vec3A, m3dVec3ADivVec3A, m3dVec3ADivVec3A(v3a[i], v3a[i + 1])) \
+    X(VALUE, Vec3A, m3dVec3ADivValue, m3dVec3ADivValue(v3a[i], s[i])) \
+    X(VALUE, Vec3A, m3dVec3AMin, m3dVec3AMin(v3a[i], v3a[i + 1])) \
+    X(VALUE, Vec3A, m3dVec3AMax, m3dVec3AMax(v3a[i], v3a[i + 1])) \
+    X(VALUE, Vec3A, m3dVec3ALerp, m3dVec3ALerp(v3a[i], v3a[i + 1], s[i])) \
+    X(VALUE, Vec3A, m3dVec3ACross, m3dVec3ACross(v3a[i], v3a[i + 1])) \
+    X(VALUE, M3dValue, m3dVec3ADot, m3dVec3ADot(v3a[i], v3a[i + 1])) \
+    X(VALUE, M3dValue, m3dVec3ALengthSqr, m3dVec3ALengthSqr(v3a[i])) \
+    X(VALUE, M3dValue, m3dVec3ALength, m3dVec3ALength(v3a[i])) \
+    X(VALUE, M3dValue, m3dVec3ADistance, m3dVec3ADistance(v3a[i], v3a[i + 1])) \
+    X(VALUE, Vec3A, m3dVec3ANormalized, m3dVec3ANormalized(v3a[i])) \
+    X(VALUE, M3dValue, m3dVec3AAngle, m3dVec3AAngle(v3a[i], v3a[i + 1])) \
+    X(VALUE, Vec3A, m3dVec3AReflect, m3dVec3AReflect(v3a[i], v3a[i + 1])) \
+    X(VALUE, Vec3A, m3dVec3ASlerp, m3dVec3ASlerp(v3a[i], v3a[i + 1], s[i])) \
+    X(VALUE, char, m3dVec3AEqual, m3dVec3AEqual(v3a[i], v3a[i + 1])) \
+    X(OUT, Vec3A, m3dVec3AAddVec3APtr, m3dVec3AAddVec3APtr(&o[i], &v3a[i], &v3a[i + 1])) \
+    X(OUT, Vec3A, m3dVec3ASubVec3APtr, m3dVec3ASubVec3APtr(&o[i], &v3a[i], &v3a[i + 1])) \
+    X(OUT, Vec3A, m3dVec3AMulVec3APtr, m3dVec3AMulVec3APtr(&o[i], &v3a[i], &v3a[i + 1])) \
+    X(OUT, Vec3A, m3dVec3AMulValuePtr, m3dVec3AMulValuePtr(&o[i], &v3a[i], s[i])) \
+    X(OUT, Vec3A, m3dVec3AMinPtr, m3dVec3AMinPtr(&o[i], &v3a[i], &v3a[i + 1])) \
+    X(OUT, Vec3A, m3dVec3AMaxPtr, m3dVec3AMaxPtr(&o[i], &v3a[i], &v3a[i + 1])) \
+    X(OUT, Vec3A, m3dVec3ALerpPtr, m3dVec3ALerpPtr(&o[i], &v3a[i], &v3a[i + 1], s[i])) \
+    X(OUT, Vec3A, m3dVec3ACrossPtr, m3dVec3ACrossPtr(&o[i], &v3a[i], &v3a[i + 1])) \
+    X(VALUE, M3dValue, m3dVec3ADotPtr, m3dVec3ADotPtr(&v3a[i], &v3a[i + 1])) \
+    X(OUT, Vec3A, m3dVec3ANormalizedPtr, m3dVec3ANormalizedPtr(&o[i], &v3a[i])) \
+    X(BATCH, void, m3dVec3AFromVec3Array, m3dVec3AFromVec3Array(v3ar, v3, BENCH_N)) \
+    X(BATCH, void, m3dVec3AToVec3Array, m3dVec3AToVec3Array(v3r, v3a, BENCH_N)) \
+    \
+    X(VALUE, PackedVec3, m3dVec3Encode48, m3dVec3Encode48(v3[i], v3[i + 1], v3[i + 2])) \
+    X(VALUE, Vec3, m3dVec3Decode48, m3dVec3Decode48(pv3[i & BENCH_MASK], v3[i + 1], v3[i + 2])) \
+    X(BATCH, void, m3dVec3Encode48Array, m3dVec3Encode48Array(pv3, v3, BENCH_N, (Vec3){-1, -1, -1}, (Vec3){1, 1, 1})) \
+    X(BATCH, void, m3dVec3Decode48Array, m3dVec3Decode48Array(v3r, pv3, BENCH_N, (Vec3){-1, -1, -1}, (Vec3){1, 1, 1})) \
+    \
+    X(BATCH, void, m3dVec2SoaFromArray, m3dVec2SoaFromArray(soa2r, v2)) \
+    X(BATCH, void, m3dVec2SoaToArray, m3dVec2SoaToArray(v2r, soa2a)) \
+    X(BATCH, void, m3dVec2SoaAddVec2Soa, m3dVec2SoaAddVec2Soa(soa2r, soa2a, soa2b)) \
+    X(BATCH, void, m3dVec2SoaSubVec2Soa, m3dVec2SoaSubVec2Soa(soa2r, soa2a, soa2b)) \
+    X(BATCH, void, m3dVec2SoaMulVec2Soa, m3dVec2SoaMulVec2Soa(soa2r, soa2a, soa2b)) \
+    X(BATCH, void, m3dVec2SoaMulValue, m3dVec2SoaMulValue(soa2r, soa2a, s[0])) \
+    X(BATCH, void, m3dVec2SoaDivValue, m3dVec2SoaDivValue(soa2r, soa2a, s[0])) \
+    X(BATCH, void, m3dVec2SoaLerp, m3dVec2SoaLerp(soa2r, soa2a, soa2b, s[0])) \
+    X(BATCH, void, m3dVec2SoaDot, m3dVec2SoaDot(soaRes, soa2a, soa2b)) \
+    X(BATCH, void, m3dVec2SoaLengthSqr, m3dVec2SoaLengthSqr(soaRes, soa2a)) \
+    X(BATCH, void, m3dVec2SoaLength, m3dVec2SoaLength(soaRes, soa2a)) \
+    X(BATCH, void, m3dVec2SoaNormalized, m3dVec2SoaNormalized(soa2r, soa2a)) \
+    X(BATCH, void, m3dVec3SoaFromArray, m3dVec3SoaFromArray(soa3r, v3)) \
+    X(BATCH, void, m3dVec3SoaToArray, m3dVec3SoaToArray(v3r, soa3a)) \
+    X(BATCH, void, m3dVec3SoaAddVec3Soa, m3dVec3SoaAddVec3Soa(soa3r, soa3a, soa3b)) \
+    X(BATCH, void, m3dVec3SoaSubVec3Soa, m3dVec3SoaSubVec3Soa(soa3r, soa3a, soa3b)) \
+    X(BATCH, void, m3dVec3SoaMulVec3Soa, m3dVec3SoaMulVec3Soa(soa3r, soa3a, soa3b)) \
+    X(BATCH, void, m3dVec3SoaMulValue, m3dVec3SoaMulValue(soa3r, soa3a, s[0])) \
+    X(BATCH, void, m3dVec3SoaDivValue, m3dVec3SoaDivValue(soa3r, soa3a, s[0])) \
+    X(BATCH, void, m3dVec3SoaLerp, m3dVec3SoaLerp(soa3r, soa3a, soa3b, s[0])) \
+    X(BATCH, void, m3dVec3SoaCross, m3dVec3SoaCross(soa3r, soa3a, soa3b)) \
+    X(BATCH, void, m3dVec3SoaDot, m3dVec3SoaDot(soaRes, soa3a, soa3b)) \
+    X(BATCH, void, m3dVec3SoaLengthSqr, m3dVec3SoaLengthSqr(soaRes, soa3a)) \
+    X(BATCH, void, m3dVec3SoaLength, m3dVec3SoaLength(soaRes, soa3a)) \
+    X(BATCH, void, m3dVec3SoaNormalized, m3dVec3SoaNormalized(soa3r, soa3a)) \
+    X(BATCH, void, m3dVec4SoaFromArray, m3dVec4SoaFromArray(soa4r, v4)) \
+    X(BATCH, void, m3dVec4SoaToArray, m3dVec4SoaToArray(v4r, soa4a)) \
+    X(BATCH, void, m3dVec4SoaAddVec4Soa, m3dVec4SoaAddVec4Soa(soa4r, soa4a, soa4b)) \
+    X(BATCH, void, m3dVec4SoaSubVec4Soa, m3dVec4SoaSubVec4Soa(soa4r, soa4a, soa4b)) \
+    X(BATCH, void, m3dVec4SoaMulVec4Soa, m3dVec4SoaMulVec4Soa(soa4r, soa4a, soa4b)) \
+    X(BATCH, void, m3dVec4SoaMulValue, m3dVec4SoaMulValue(soa4r, soa4a, s[0])) \
+    X(BATCH, void, m3dVec4SoaDivValue, m3dVec4SoaDivValue(soa4r, soa4a, s[0])) \
+    X(BATCH, void, m3dVec4SoaLerp, m3dVec4SoaLerp(soa4r, soa4a, soa4b, s[0])) \
+    X(BATCH, void, m3dVec4SoaDot, m3dVec4SoaDot(soaRes, soa4a, soa4b)) \
+    X(BATCH, void, m3dVec4SoaLengthSqr, m3dVec4SoaLengthSqr(soaRes, soa4a)) \
+    X(BATCH, void, m3dVec4SoaLength, m3dVec4SoaLength(soaRes, soa4a)) \
+    X(BATCH, void, m3dVec4SoaNormalized, m3dVec4SoaNormalized(soa4r, soa4a)) \
+    \
+    X(VALUE, PackedQuat32, m3dQuatEncode32, m3dQuatEncode32(q[i])) \
+    X(VALUE, Quat, m3dQuatDecode32, m3dQuatDecode32(pq32[i & BENCH_MASK])) \
+    X(VALUE, PackedQuat48, m3dQuatEncode48, m3dQuatEncode48(q[i])) \
+    X(VALUE, Quat, m3dQuatDecode48, m3dQuatDecode48(pq48[i & BENCH_MASK])) \
+    X(BATCH, void, m3dQuatEncode32Array, m3dQuatEncode32Array(pq32, q, BENCH_N)) \
+    X(BATCH, void, m3dQuatDecode32Array, m3dQuatDecode32Array(qr, pq32, BENCH_N)) \
+    X(BATCH, void, m3dQuatEncode48Array, m3dQuatEncode48Array(pq48, q, BENCH_N)) \
+    X(BATCH, void, m3dQuatDecode48Array, m3dQuatDecode48Array(qr, pq48, BENCH_N)) \
+    \
+    X(VALUE, Mat3x3, m3dMat3x3InitIdentity, m3dMat3x3InitIdentity()) \
+    X(VALUE, Mat3x3, m3dMat3x3InitOrtho, m3dMat3x3InitOrtho(s[i] + 1, -s[i + 1], s[i + 2] + 1, -s[i + 3])) \
+    X(VALUE, Mat3x3, m3dMat3x3InitOrthoCentered, m3dMat3x3InitOrthoCentered(s[i], s[i + 1])) \
+    X(VALUE, Mat3x3, m3dMat3x3InitRotationFromQuat, m3dMat3x3InitRotationFromQuat(q[i])) \
+    X(VALUE, Mat3x3, m3dMat3x3Rotate, m3dMat3x3Rotate(&m3w[i], s[i])) \
+    X(VALUE, Mat3x3, m3dMat3x3Scale, m3dMat3x3Scale(&m3w[i], v2[i])) \
+    X(VALUE, Mat3x3, m3dMat3x3Translate, m3dMat3x3Translate(&m3w[i], v2[i])) \
+    X(VALUE, Mat3x3, m3dMat3x3FromMat4x4, m3dMat3x3FromMat4x4(m4[i])) \
+    X(VALUE, Mat3x3, m3dMat3x3MulMat3x3, m3dMat3x3MulMat3x3(m3[i], m3[i + 1])) \
+    X(VALUE, Vec3, m3dMat3x3MulVec3, m3dMat3x3MulVec3(m3[i], v3[i])) \
+    X(OUT, Mat3x3, m3dMat3x3InitIdentityPtr, m3dMat3x3InitIdentityPtr(&o[i])) \
+    X(OUT, Mat3x3, m3dMat3x3RotatePtr, m3dMat3x3RotatePtr(&o[i], s[i])) \
+    X(OUT, Mat3x3, m3dMat3x3ScalePtr, m3dMat3x3ScalePtr(&o[i], &v2[i])) \
+    X(OUT, Mat3x3, m3dMat3x3TranslatePtr, m3dMat3x3TranslatePtr(&o[i], &v2[i])) \
+    X(OUT, Mat3x3, m3dMat3x3MulMat3x3Ptr, m3dMat3x3MulMat3x3Ptr(&o[i], &m3[i], &m3[i + 1])) \
+    X(OUT, Mat3x3, m3dMat3x3MulMat3x3InPlace, (o[i] = m3[i], m3dMat3x3MulMat3x3InPlace(&o[i], &m3[i + 1]))) \
+    X(OUT, Mat3x3, m3dMat3x3PreMulMat3x3InPlace, (o[i] = m3[i], m3dMat3x3PreMulMat3x3InPlace(&m3[i + 1], &o[i]))) \
+    X(OUT, Vec3, m3dMat3x3MulVec3Ptr, m3dMat3x3MulVec3Ptr(&o[i], &m3[i], &v3[i])) \
+    \
+    X(VALUE, Mat4x4, m3dMat4x4InitIdentity, m3dMat4x4InitIdentity()) \
+    X(VALUE, Mat4x4, m3dMat4x4InitOrtho, m3dMat4x4InitOrtho(s[i] + 1, -s[i + 1], s[i + 2] + 1, -s[i + 3], s[i], s[i] + 10)) \
+    X(VALUE, Mat4x4, m3dMat4x4InitOrthoCentered, m3dMat4x4InitOrthoCentered(s[i], s[i + 1], s[i + 2], s[i + 2] + 10)) \
+    X(VALUE, Mat4x4, m3dMat4x4InitPerspective, m3dMat4x4InitPerspective(s[i], s[i + 1], s[i + 2], s[i + 3], s[i + 3] + 10)) \
+    X(VALUE, Mat4x4, m3dMat4x4InverseHomogeneous, m3dMat4x4InverseHomogeneous(m4[i])) \
+    X(VALUE, Mat4x4, m3dMat4x4InverseAffine, m3dMat4x4InverseAffine(m4[i])) \
+    X(VALUE, Mat4x4, m3dMat4x4Inverse, m3dMat4x4Inverse(m4[i])) \
+    X(VALUE, Mat4x4, m3dMat4x4Rotate, m3dMat4x4Rotate(&m4w[i], q[i])) \
+    X(VALUE, Mat4x4, m3dMat4x4RotateY, m3dMat4x4RotateY(&m4w[i], s[i])) \
+    X(VALUE, Mat4x4, m3dMat4x4Scale, m3dMat4x4Scale(&m4w[i], v3[i])) \
+    X(VALUE, Mat4x4, m3dMat4x4Translate, m3dMat4x4Translate(&m4w[i], v3[i])) \
+    X(VALUE, Mat4x4, m3dMat4x4FromMat3x3, m3dMat4x4FromMat3x3(m3[i])) \
+    X(VALUE, Mat4x4, m3dMat4x4MulMat4x4, m3dMat4x4MulMat4x4(m4[i], m4[i + 1])) \
+    X(VALUE, Vec4, m3dMat4x4MulVec4, m3dMat4x4MulVec4(m4[i], v4[i])) \
+    X(OUT, Mat4x4, m3dMat4x4InitIdentityPtr, m3dMat4x4InitIdentityPtr(&o[i])) \
+    X(OUT, Mat4x4, m3dMat4x4RotatePtr, m3dMat4x4RotatePtr(&o[i], &q[i])) \
+    X(OUT, Mat4x4, m3dMat4x4ScalePtr, m3dMat4x4ScalePtr(&o[i], &v3[i])) \
+    X(OUT, Mat4x4, m3dMat4x4TranslatePtr, m3dMat4x4TranslatePtr(&o[i], &v3[i])) \
+    X(OUT, Mat4x4, m3dMat4x4MulMat4x4Ptr, m3dMat4x4MulMat4x4Ptr(&o[i], &m4[i], &m4[i + 1])) \
+    X(OUT, Mat4x4, m3dMat4x4MulMat4x4InPlace, (o[i] = m4[i], m3dMat4x4MulMat4x4InPlace(&o[i], &m4[i + 1]))) \
+    X(OUT, Mat4x4, m3dMat4x4PreMulMat4x4InPlace, (o[i] = m4[i], m3dMat4x4PreMulMat4x4InPlace(&m4[i + 1], &o[i]))) \
+    X(OUT, Vec4, m3dMat4x4MulVec4Ptr, m3dMat4x4MulVec4Ptr(&o[i], &m4[i], &v4[i])) \
+    X(OUT, Mat4x4, m3dMat4x4InverseHomogeneousPtr, m3dMat4x4InverseHomogeneousPtr(&o[i], &m4[i])) \
+    X(OUT, Mat4x4, m3dMat4x4InverseAffinePtr, m3dMat4x4InverseAffinePtr(&o[i], &m4[i])) \
+    X(OUT, Mat4x4, m3dMat4x4InversePtr, m3dMat4x4InversePtr(&o[i], &m4[i])) \
+    \
+    X(VALUE, Mat3x4, m3dMat3x4InitIdentity, m3dMat3x4InitIdentity()) \
+    X(VALUE, Mat3x4, m3dMat3x4FromMat4x4, m3dMat3x4FromMat4x4(m4[i])) \
+    X(VALUE, Mat4x4, m3dMat4x4FromMat3x4, m3dMat4x4FromMat3x4(m34[i])) \
+    X(VALUE, Mat3x4, m3dMat3x4MulMat3x4, m3dMat3x4MulMat3x4(m34[i], m34[i + 1])) \
+    X(VALUE, Vec3A, m3dMat3x4TransformPoint, m3dMat3x4TransformPoint(m34[i], v3a[i])) \
+    X(VALUE, Vec3A, m3dMat3x4TransformDirection, m3dMat3x4TransformDirection(m34[i], v3a[i])) \
+    X(OUT, Vec3A, m3dMat3x4TransformPointPtr, m3dMat3x4TransformPointPtr(&o[i], &m34[i], &v3a[i])) \
+    X(OUT, Vec3A, m3dMat3x4TransformDirectionPtr, m3dMat3x4TransformDirectionPtr(&o[i], &m34[i], &v3a[i])) \
+    X(OUT, Mat3x4, m3dMat3x4MulMat3x4Ptr, m3dMat3x4MulMat3x4Ptr(&o[i], &m34[i], &m34[i + 1])) \
+    X(VALUE, Mat3x4, m3dMat3x4Inverse, m3dMat3x4Inverse(m34[i])) \
+    X(OUT, Mat3x4, m3dMat3x4InversePtr, m3dMat3x4InversePtr(&o[i], &m34[i])) \
+    X(BATCH, void, m3dMat3x4TransformPointArray, m3dMat3x4TransformPointArray(v3ar, m34[0], v3a, BENCH_N)) \
+    X(BATCH, void, m3dMat3x4MulMat3x4Array, m3dMat3x4MulMat3x4Array(m34r, m34, m34 + 1, BENCH_N)) \
+    \
+    X(BATCH, void, m3dMat4x4TransformVec3Array, m3dMat4x4TransformVec3Array(m4[0], v3r, 0, v3, 0, BENCH_N, M3D_TRANSFORM_POINT)) \
+    X(BATCH, void, m3dMat4x4TransformVec4Array, m3dMat4x4TransformVec4Array(m4[0], v4r, 0, v4, 0, BENCH_N, 0)) \
+    X(BATCH, void, m3dMat3x3TransformVec3Array, m3dMat3x3TransformVec3Array(m3[0], v3r, 0, v3, 0, BENCH_N, 0)) \
+    X(VALUE, Mat4x4, m3dMat4x4FromTrs, m3dMat4x4FromTrs(v3[i], q[i], v3[i + 1])) \
+    X(OUT, Mat4x4, m3dMat4x4FromTrsPtr, m3dMat4x4FromTrsPtr(&o[i], &v3[i], &q[i], &v3[i + 1])) \
+    X(VALUE, Mat3x4, m3dMat3x4FromTrs, m3dMat3x4FromTrs(v3[i], q[i], v3[i + 1])) \
+    X(OUT, Mat3x4, m3dMat3x4FromTrsPtr, m3dMat3x4FromTrsPtr(&o[i], &v3[i], &q[i], &v3[i + 1])) \
+    X(BATCH, void, m3dMat4x4FromTrsSoa, m3dMat4x4FromTrsSoa(m4r, soa3a, soaq, soa3b)) \
+    X(BATCH, void, m3dMat3x4FromTrsSoa, m3dMat3x4FromTrsSoa(m34r, soa3a, soaq, soa3b)) \
+    X(VALUE, Quat, m3dQuatFromMat4x4, m3dQuatFromMat4x4(m4rigid[i])) \
+    X(VALUE, DualQuat, m3dDualQuatInitIdentity, m3dDualQuatInitIdentity()) \
+    X(VALUE, DualQuat, m3dDualQuatFromTr, m3dDualQuatFromTr(v3[i], q[i])) \
+    X(VALUE, DualQuat, m3dDualQuatFromMat4x4, m3dDualQuatFromMat4x4(m4rigid[i])) \
+    X(VALUE, Mat4x4, m3dDualQuatToMat4x4, m3dDualQuatToMat4x4(dq[i])) \
+    X(VALUE, Vec3, m3dDualQuatTranslation, m3dDualQuatTranslation(dq[i])) \
+    X(VALUE, DualQuat, m3dDualQuatMulDualQuat, m3dDualQuatMulDualQuat(dq[i], dq[i + 1])) \
+    X(OUT, DualQuat, m3dDualQuatMulDualQuatPtr, m3dDualQuatMulDualQuatPtr(&o[i], &dq[i], &dq[i + 1])) \
+    X(VALUE, DualQuat, m3dDualQuatNormalized, m3dDualQuatNormalized(dq[i])) \
+    X(VALUE, DualQuat, m3dDualQuatBlend, m3dDualQuatBlend(&dq[i], &s[i], 4)) \
+    X(VALUE, DualQuat, m3dDualQuatLerp, m3dDualQuatLerp(dq[i], dq[i + 1], s[i])) \
+    X(VALUE, Vec3, m3dDualQuatTransformPoint, m3dDualQuatTransformPoint(dq[i], v3[i])) \
+    X(OUT, Vec3, m3dDualQuatTransformPointPtr, m3dDualQuatTransformPointPtr(&o[i], &dq[i], &v3[i])) \
+    X(VALUE, Vec3, m3dDualQuatTransformDirection, m3dDualQuatTransformDirection(dq[i], v3[i])) \
+    X(BATCH, void, m3dDualQuatSkinVec3Array, m3dDualQuatSkinVec3Array(v3r, v3, skinBones, skinWeights, dq, BENCH_N, M3D_TRANSFORM_POINT)) \
+    X(BATCH, void, m3dMat4x4InverseHomogeneousArray, m3dMat4x4InverseHomogeneousArray(m4r, m4, BENCH_N)) \
+    X(BATCH, void, m3dMat4x4InverseAffineArray, m3dMat4x4InverseAffineArray(m4r, m4, BENCH_N)) \
+    X(BATCH, void, m3dMat4x4InverseArray, m3dMat4x4InverseArray(m4r, m4, BENCH_N)) \
+    X(VALUE, Mat3x3, m3dMat3x3Transpose, m3dMat3x3Transpose(m3[i])) \
+    X(VALUE, Mat4x4, m3dMat4x4Transpose, m3dMat4x4Transpose(m4[i])) \
+    X(OUT, Mat4x4, m3dMat4x4TransposePtr, m3dMat4x4TransposePtr(&o[i], &m4[i])) \
+    X(BATCH, void, m3dMat4x4TransposeArray, m3dMat4x4TransposeArray(m4r, m4, BENCH_N)) \
+    X(BATCH, void, m3dMat4x4ExportRowMajor, m3dMat4x4ExportRowMajor(exportBuffer, m4, BENCH_N, 0)) \
+    X(BATCH, void, m3dMat4x4ExportColumnMajor, m3dMat4x4ExportColumnMajor(exportBuffer, m4, BENCH_N, 0)) \
+    X(BATCH, void, m3dMat4x4ExportRows3x4, m3dMat4x4ExportRows3x4(exportBuffer, m4, BENCH_N, 0)) \
+    X(BATCH, void, m3dMat3x3TransformVec2Array, m3dMat3x3TransformVec2Array(m3[0], v2r, 0, v2, 0, BENCH_N, M3D_TRANSFORM_POINT)) \
+    X(VALUE, Mat3x3, m3dMat3x3FromTrs, m3dMat3x3FromTrs(v2[i], s[i], v2[i + 1])) \
+    X(BATCH, void, m3dMat3x3FromTrsSoa, m3dMat3x3FromTrsSoa(m3w, soa2a, s, soa2b)) \
+    X(BATCH, void, m3dMat3x3TransformSpriteQuads, m3dMat3x3TransformSpriteQuads(m3[0], spriteQuads, soa2a, s, soa2b, spriteCorners, 0)) \
+    \
+    X(VALUE, Frustum, m3dFrustumFromMat4x4, m3dFrustumFromMat4x4(m4[i])) \
+    X(VALUE, char, m3dFrustumSphereVisible, m3dFrustumSphereVisible(frustum, v3[i], s[i])) \
+    X(VALUE, char, m3dFrustumAabbVisible, m3dFrustumAabbVisible(frustum, v3[i], v3[i + 1])) \
+    X(BATCH, void, m3dFrustumCullSpheres, m3dFrustumCullSpheres(cullMask, frustum, soa3a, soaData[4])) \
+    X(BATCH, void, m3dFrustumCullAabbs, m3dFrustumCullAabbs(cullMask, frustum, soa3a, soa3b)) \
+    X(BATCH, size_t, m3dFrustumCullSpheresIndices, m3dFrustumCullSpheresIndices(cullIndices, frustum, soa3a, soaData[4])) \
+    X(BATCH, size_t, m3dFrustumCullAabbsIndices, m3dFrustumCullAabbsIndices(cullIndices, frustum, soa3a, soa3b)) \
+    \
+    X(VALUE, Aabb, m3dAabbUnion, m3dAabbUnion(aabbs[i & BENCH_MASK], aabbs[(i + 1) & BENCH_MASK])) \
+    X(VALUE, char, m3dAabbContainsVec3, m3dAabbContainsVec3(aabbs[i & BENCH_MASK], v3[i])) \
+    X(VALUE, char, m3dAabbOverlaps, m3dAabbOverlaps(aabbs[i & BENCH_MASK], aabbs[(i + 1) & BENCH_MASK])) \
+    X(VALUE, char, m3dAabbRay, m3dAabbRay(aabbs[i & BENCH_MASK], v3[i], v3[i + 1], 4, NULL)) \
+    X(BATCH, size_t, m3dBvhBuild, m3dBvhBuild(&bvh)) \
+    X(VALUE, uint32_t, m3dBvhRaycast, (bvhT = 4, m3dBvhRaycast(bvh, v3[i], v3[i + 1], &bvhT, NULL, NULL))) \
+    X(VALUE, size_t, m3dBvhQueryVec3, m3dBvhQueryVec3(cullIndices, BENCH_N, bvh, v3[i])) \
+    X(VALUE, size_t, m3dBvhQueryAabb, m3dBvhQueryAabb(cullIndices, BENCH_N, bvh, aabbs[i & BENCH_MASK])) \
+    X(VALUE, size_t, m3dBvhQueryRay, m3dBvhQueryRay(cullIndices, BENCH_N, bvh, v3[i], v3[i + 1], 4)) \
+    \
+    X(BATCH, void, m3dHierarchyBuildLevels, m3dHierarchyBuildLevels(&hier)) \
+    X(BATCH, void, m3dHierarchyUpdate, m3dHierarchyUpdate(hier)) \
+    X(BATCH, void, m3dHierarchyUpdateRange, m3dHierarchyUpdateRange(hier, 0, BENCH_N)) \
+    X(BATCH, void, m3dSkinUpdate, m3dSkinUpdate(skin)) \
+    X(BATCH, void, m3dSkinUpdateRange, m3dSkinUpdateRange(skin, 0, BENCH_N))
+#else
+#define BENCHMARKS_FLOAT(X)
+#endif // M3D_FIXED
+
+#define BENCHMARKS(X) BENCHMARKS_COMMON(X) BENCHMARKS_FLOAT(X)
+
+/** ---------------- benchmark bodies */
+
+// latency feeds one byte of every result into the next index, so calls can't overlap
+#define BENCH_DEFINE_VALUE(type, name, call) \
+    static type out_##name[BENCH_N]; \
+    static void latency_##name(size_t reps) \
+    { \
+        size_t i = 0; \
+        for(size_t r = 0; r < reps; r++) \
+        { \
+            type res = call; \
+            unsigned char dep; \
+            memcpy(&dep, &res, 1); \
+            out_##name[i] = res; \
+            i = (i + 1 + (dep & opaqueZero)) & BENCH_MASK; \
+        } \
+    } \
+    static void throughput_##name(size_t reps) \
+    { \
+        size_t i = 0; \
+        for(size_t r = 0; r < reps; r++) \
+        { \
+            out_##name[i] = call; \
+            i = (i + 1) & BENCH_MASK; \
+        } \
+    }
+
+#define BENCH_DEFINE_OUT(type, name, call) \
+    static type out_##name[BENCH_N + BENCH_PAD]; \
+    static void latency_##name(size_t reps) \
+    { \
+        type *o = out_##name; \
+        size_t i = 0; \
+        for(size_t r = 0; r < reps; r++) \
+        { \
+            unsigned char dep; \
+            call; \
+            memcpy(&dep, &o[i], 1); \
+            i = (i + 1 + (dep & opaqueZero)) & BENCH_MASK; \
+        } \
+    } \
+    static void throughput_##name(size_t reps) \
+    { \
+        type *o = out_##name; \
+        size_t i = 0; \
+        for(size_t r = 0; r < reps; r++) \
+        { \
+            call; \
+            i = (i + 1) & BENCH_MASK; \
+        } \
+    }
+
+#define BENCH_DEFINE_VOID(type, name, call) \
+    static void latency_##name(size_t reps) \
+    { \
+        for(size_t r = 0; r < reps; r++) \
+        { \
+            call; \
+        } \
+    } \
+    static void throughput_##name(size_t reps) \
+    { \
+        latency_##name(reps); \
+    }
+
+#define BENCH_DEFINE_BATCH BENCH_DEFINE_VOID
+
+#define BENCH_ELEMENTS_VALUE 1
+#define BENCH_ELEMENTS_OUT 1
+#define BENCH_ELEMENTS_VOID 1
+#define BENCH_ELEMENTS_BATCH BENCH_N
+
+#define BENCH_DEFINE(kind, type, name, call) BENCH_DEFINE_##kind(type, name, call)
+#define BENCH_ENTRY(kind, type, name, call) {#name, latency_##name, throughput_##name, BENCH_ELEMENTS_##kind},
+
+BENCHMARKS(BENCH_DEFINE)
+
+typedef struct{
+    const char *name;
+    void (*latency)(size_t reps);
+    void (*throughput)(size_t reps);
+    size_t elements;
+}Benchmark;
+
+static const Benchmark benchmarks[] = {
+    BENCHMARKS(BENCH_ENTRY)
+};
+
+/** ---------------- timing */
+
+static double nowNs()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (double)counter.QuadPart * 1e9 / (double)frequency.QuadPart;
+#else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+#endif
+}
+
+static uint64_t nowCycles()
+{
+#ifdef BENCH_HAS_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+typedef struct{
+    double ns;
+    double cycles;
+}Timing;
+
+// best of several trials, each long enough to hide the timer resolution
+static Timing timeBenchmark(void (*fn)(size_t reps), size_t reps, int trials)
+{
+    Timing best = {1e300, 1e300};
+
+    fn(reps / 8 + 1);
+
+    for(int t = 0; t < trials; t++)
+    {
+        double startNs = nowNs();
+        uint64_t startCycles = nowCycles();
+
+        fn(reps);
+
+        uint64_t endCycles = nowCycles();
+        double endNs = nowNs();
+
+        double ns = (endNs - startNs) / (double)reps;
+        double cycles = (double)(endCycles - startCycles) / (double)reps;
+
+        if(ns < best.ns) best.ns = ns;
+        if(cycles < best.cycles) best.cycles = cycles;
+    }
+
+    return best;
+}
+
+// grows reps until one trial takes about targetNs
+static size_t calibrate(void (*fn)(size_t reps), double targetNs)
+{
+    size_t reps = 16;
+
+    for(;;)
+    {
+        double start = nowNs();
+        fn(reps);
+        double elapsed = nowNs() - start;
+
+        if(elapsed >= targetNs || reps >= ((size_t)1 << 30))
+        {
+            return elapsed > 0 ? (size_t)((double)reps * targetNs / elapsed) + 1 : reps;
+        }
+
+        reps *= 4;
+    }
+}
+
+/** ---------------- main */
+
+int main(int argc, char **argv)
+{
+    const char *jsonPath = NULL;
+    const char *filter = NULL;
+    double targetNs = 2e6;
+    int trials = 5;
+
+    for(int a = 1; a < argc; a++)
+    {
+        if(strcmp(argv[a], "--json") == 0 && a + 1 < argc)
+        {
+            jsonPath = argv[++a];
+        }
+        else if(strcmp(argv[a], "--filter") == 0 && a + 1 < argc)
+        {
+            filter = argv[++a];
+        }
+        else if(strcmp(argv[a], "--quick") == 0)
+        {
+            targetNs = 2e5;
+            trials = 2;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--json file] [--filter text] [--quick]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    initInputs();
+
+    FILE *json = NULL;
+    if(jsonPath)
+    {
+        json = fopen(jsonPath, "w");
+        if(!json)
+        {
+            fprintf(stderr, "could not open %s\n", jsonPath);
+            return 1;
+        }
+
+        fprintf(json, "{\n  \"precision\": \"%s\",\n  \"cpu_features\": %u,\n  \"results\": [", BENCH_PRECISION, m3dCpuFeatures());
+    }
+
+    printf("m3d benchmarks, %s precision, cpu features 0x%x%s\n", BENCH_PRECISION, m3dCpuFeatures(),
+#ifdef BENCH_HAS_TSC
+           ""
+#else
+           ", no cycle counter"
+#endif
+           );
+    printf("%-34s %10s %10s %10s %10s %8s\n", "function", "lat ns", "lat cyc", "thr ns", "thr cyc", "elems");
+
+    char first = 1;
+    for(size_t b = 0; b < sizeof(benchmarks) / sizeof(benchmarks[0]); b++)
+    {
+        const Benchmark *bench = &benchmarks[b];
+
+        if(filter && !strstr(bench->name, filter))
+        {
+            continue;
+        }
+
+        Timing latency = timeBenchmark(bench->latency, calibrate(bench->latency, targetNs), trials);
+        Timing throughput = timeBenchmark(bench->throughput, calibrate(bench->throughput, targetNs), trials);
+
+        printf("%-34s %10.2f %10.1f %10.2f %10.1f %8zu\n", bench->name,
+               latency.ns, latency.cycles, throughput.ns, throughput.cycles, bench->elements);
+
+        if(json)
+        {
+            fprintf(json, "%s\n    {\"name\": \"%s\", \"elements\": %zu, \"latency_ns\": %.4f, \"latency_cycles\": %.2f, "
+                    "\"throughput_ns\": %.4f, \"throughput_cycles\": %.2f}",
+                    first ? "" : ",", bench->name, bench->elements,
+                    latency.ns, latency.cycles, throughput.ns, throughput.cycles);
+            first = 0;
+        }
+    }
+
+    if(json)
+    {
+        fprintf(json, "\n  ]\n}\n");
+        fclose(json);
+    }
+
+    return 0;
+}
@@ -0,0 +1,529 @@
+#include "m3d/m3d.h"
+#include "internal.h"
+#include <float.h>
+
+#ifndef M3D_FIXED
+
+#ifdef M3D_DOUBLE
+#define BVH_HUGE DBL_MAX
+#else
+#define BVH_HUGE FLT_MAX
+#endif // M3D_DOUBLE
+
+// centroid bins per axis for the surface area heuristic
+#define BVH_BINS 16
+// leaves never hold more objects than this
+#define BVH_MAX_LEAF 8
+// below this depth nodes are split by the heuristic, deeper ones in half by count,
+// which bounds the depth of the tree for the query stacks
+#define BVH_SAH_DEPTH 64
+#define BVH_STACK 128
+// subtrees with fewer objects are built by the thread that split them
+#define BVH_PARALLEL_MIN 4096
+
+/** ---------------- Aabb functions */
+
+static inline void growInternal(Aabb *a, const Aabb *b)
+{
+    a->min.x = m3dMinInternal(a->min.x, b->min.x);
+    a->min.y = m3dMinInternal(a->min.y, b->min.y);
+    a->min.z = m3dMinInternal(a->min.z, b->min.z);
+    a->max.x = m3dMaxInternal(a->max.x, b->max.x);
+    a->max.y = m3dMaxInternal(a->max.y, b->max.y);
+    a->max.z = m3dMaxInternal(a->max.z, b->max.z);
+}
+
+static inline char overlapsInternal(const Aabb *a, const Aabb *b)
+{
+    return a->min.x <= b->max.x && a->max.x >= b->min.x &&
+           a->min.y <= b->max.y && a->max.y >= b->min.y &&
+           a->min.z <= b->max.z && a->max.z >= b->min.z;
+}
+
+// one axis of the slab test, narrows [tmin, tmax] to where the ray is between lo and hi.
+// a 0 direction component gives an infinite inverse, such a ray is inside the slab for every t
+// or for none, and is decided on the origin since the products would be 0 * inf = NaN on a face
+static inline char slabInternal(M3dValue lo, M3dValue hi, M3dValue o, M3dValue inv, M3dValue *tmin, M3dValue *tmax)
+{
+    if(inv > BVH_HUGE || inv < -BVH_HUGE)
+    {
+        return o >= lo && o <= hi;
+    }
+
+    M3dValue t1 = (lo - o) * inv;
+    M3dValue t2 = (hi - o) * inv;
+    *tmin = m3dMaxInternal(*tmin, m3dMinInternal(t1, t2));
+    *tmax = m3dMinInternal(*tmax, m3dMaxInternal(t1, t2));
+    return 1;
+}
+
+// slab test of the segment o + t * dir, 0 <= t <= maxT, inv = 1 / dir.
+// points on a face count as inside, the same as m3dAabbContainsVec3
+static inline char rayInternal(const Aabb *a, const Vec3 *o, const Vec3 *inv, M3dValue maxT, M3dValue *t)
+{
+    M3dValue tmin = 0;
+    M3dValue tmax = maxT;
+
+    if(!slabInternal(a->min.x, a->max.x, o->x, inv->x, &tmin, &tmax) ||
+       !slabInternal(a->min.y, a->max.y, o->y, inv->y, &tmin, &tmax) ||
+       !slabInternal(a->min.z, a->max.z, o->z, inv->z, &tmin, &tmax))
+    {
+        return 0;
+    }
+
+    *t = tmin;
+    return tmin <= tmax;
+}
+
+M3D_API Aabb m3dAabbUnion(Aabb a, Aabb b)
+{
+    M3D_PROFILE_FUNCTION();
+    growInternal(&a, &b);
+    return a;
+}
+
+M3D_API char m3dAabbContainsVec3(Aabb a, Vec3 p)
+{
+    M3D_PROFILE_FUNCTION();
+    return p.x >= a.min.x && p.x <= a.max.x &&
+           p.y >= a.min.y && p.y <= a.max.y &&
+           p.z >= a.min.z && p.z <= a.max.z;
+}
+
+M3D_API char m3dAabbOverlaps(Aabb a, Aabb b)
+{
+    M3D_PROFILE_FUNCTION();
+    return overlapsInternal(&a, &b);
+}
+
+M3D_API char m3dAabbRay(Aabb a, Vec3 origin, Vec3 dir, M3dValue maxT, M3dValue *t)
+{
+    M3D_PROFILE_FUNCTION();
+    Vec3 inv = {1 / dir.x, 1 / dir.y, 1 / dir.z};
+    M3dValue entry;
+    char hit = rayInternal(&a, &origin, &inv, maxT, &entry);
+
+    if(hit && t)
+    {
+        *t = entry;
+    }
+
+    return hit;
+}
+
+/** ---------------- building */
+
+typedef struct{
+    M3dBvh *bvh;
+    uint32_t next;
+}BvhBuildInternal;
+
+typedef struct{
+    Aabb bounds;
+    uint32_t count;
+}BvhBinInternal;
+
+// half the surface area, only ever compared
+static inline M3dValue areaInternal(const Aabb *a)
+{
+    M3dValue x = a->max.x - a->min.x;
+    M3dValue y = a->max.y - a->min.y;
+    M3dValue z = a->max.z - a->min.z;
+
+    return x * y + y * z + z * x;
+}
+
+// centroids are kept doubled, min + max, it only changes the scale of the bins
+static inline M3dValue centroidInternal(const Aabb *a, int axis)
+{
+    return axis == 0 ? a->min.x + a->max.x : axis == 1 ? a->min.y + a->max.y : a->min.z + a->max.z;
+}
+
+// the partition must compute the exact same bins as the heuristic
+static inline int binInternal(M3dValue c, M3dValue cmin, M3dValue scale, int binCount)
+{
+    int bin = (int)((c - cmin) * scale);
+    return bin < binCount - 1 ? bin : binCount - 1;
+}
+
+static void buildNodeInternal(BvhBuildInternal *b, uint32_t node, uint32_t first, uint32_t count, unsigned int depth)
+{
+    const Aabb *objects = b->bvh->bounds;
+    uint32_t *indices = b->bvh->indices;
+    M3dBvhNode *n = &b->bvh->nodes[node];
+
+    Aabb bounds = {{BVH_HUGE, BVH_HUGE, BVH_HUGE}, {-BVH_HUGE, -BVH_HUGE, -BVH_HUGE}};
+    M3dValue cmin[3] = {BVH_HUGE, BVH_HUGE, BVH_HUGE};
+    M3dValue cmax[3] = {-BVH_HUGE, -BVH_HUGE, -BVH_HUGE};
+
+    for(uint32_t i = first; i < first + count; i++)
+    {
+        const Aabb *o = &objects[indices[i]];
+        growInternal(&bounds, o);
+
+        for(int a = 0; a < 3; a++)
+        {
+            M3dValue c = centroidInternal(o, a);
+            cmin[a] = m3dMinInternal(cmin[a], c);
+            cmax[a] = m3dMaxInternal(cmax[a], c);
+        }
+    }
+
+    n->bounds = bounds;
+
+    // binned surface area heuristic over all three axes at once, splitting after bin splitBin
+    int axis = -1;
+    int splitBin = 0;
+    M3dValue scale[3] = {0, 0, 0};
+    M3dValue bestCost = BVH_HUGE;
+    // small nodes get fewer bins, setting them up would cost more than the objects
+    int binCount = count < BVH_BINS ? (int)count : BVH_BINS;
+
+    if(count > 1 && depth < BVH_SAH_DEPTH)
+    {
+        BvhBinInternal bins[3][BVH_BINS];
+
+        for(int a = 0; a < 3; a++)
+        {
+            M3dValue extent = cmax[a] - cmin[a];
+            scale[a] = extent > 0 ? binCount / extent : 0;
+
+            for(int k = 0; k < binCount; k++)
+            {
+                bins[a][k].bounds = (Aabb){{BVH_HUGE, BVH_HUGE, BVH_HUGE}, {-BVH_HUGE, -BVH_HUGE, -BVH_HUGE}};
+                bins[a][k].count = 0;
+            }
+        }
+
+        for(uint32_t i = first; i < first + count; i++)
+        {
+            const Aabb *o = &objects[indices[i]];
+
+            for(int a = 0; a < 3; a++)
+            {
+                BvhBinInternal *bin = &bins[a][binInternal(centroidInternal(o, a), cmin[a], scale[a], binCount)];
+
+                growInternal(&bin->bounds, o);
+                bin->count++;
+            }
+        }
+
+        for(int a = 0; a < 3; a++)
+        {
+            if(scale[a] == 0)
+            {
+                continue;
+            }
+
+            // left to right sums, then right to left sums against them
+            M3dValue leftCost[BVH_BINS - 1];
+            uint32_t leftCount[BVH_BINS - 1];
+            Aabb sum = bins[a][0].bounds;
+            uint32_t sumCount = bins[a][0].count;
+
+            for(int k = 0; k < binCount - 1; k++)
+            {
+                if(k > 0)
+                {
+                    growInternal(&sum, &bins[a][k].bounds);
+                    sumCount += bins[a][k].count;
+                }
+
+                leftCount[k] = sumCount;
+                leftCost[k] = sumCount ? areaInternal(&sum) * (M3dValue)sumCount : 0;
+            }
+
+            sum = bins[a][binCount - 1].bounds;
+            sumCount = bins[a][binCount - 1].count;
+
+            for(int k = binCount - 2; k >= 0; k--)
+            {
+                if(leftCount[k] > 0 && sumCount > 0)
+                {
+                    M3dValue cost = leftCost[k] + areaInternal(&sum) * (M3dValue)sumCount;
+
+                    if(cost < bestCost)
+                    {
+                        bestCost = cost;
+                        axis = a;
+                        splitBin = k;
+                    }
+                }
+
+                growInternal(&sum, &bins[a][k].bounds);
+                sumCount += bins[a][k].count;
+            }
+        }
+    }
+
+    // a traversal step and an object test are counted as equally expensive
+    M3dValue area = areaInternal(&bounds);
+
+    if(count == 1 || (count <= BVH_MAX_LEAF && (axis < 0 || area + bestCost >= area * (M3dValue)count)))
+    {
+        n->first = first;
+        n->count = count;
+        return;
+    }
+
+    uint32_t mid = first + count / 2;
+
+    if(axis >= 0)
+    {
+        uint32_t i = first;
+        uint32_t j = first + count;
+
+        while(i < j)
+        {
+            if(binInternal(centroidInternal(&objects[indices[i]], axis), cmin[axis], scale[axis], binCount) <= splitBin)
+            {
+                i++;
+            }
+            else
+            {
+                uint32_t swap = indices[i];
+                indices[i] = indices[--j];
+                indices[j] = swap;
+            }
+        }
+
+        mid = i;
+    }
+
+    // both children are allocated together so a pair always shares a cache line
+    uint32_t children;
+#ifdef _OPENMP
+    #pragma omp atomic capture
+#endif
+    {
+        children = b->next;
+        b->next += 2;
+    }
+
+    n->first = children;
+    n->count = 0;
+
+#ifdef _OPENMP
+    if(count >= BVH_PARALLEL_MIN)
+    {
+        #pragma omp task
+        buildNodeInternal(b, children, first, mid - first, depth + 1);
+        buildNodeInternal(b, children + 1, mid, first + count - mid, depth + 1);
+        return;
+    }
+#endif // _OPENMP
+
+    buildNodeInternal(b, children, first, mid - first, depth + 1);
+    buildNodeInternal(b, children + 1, mid, first + count - mid, depth + 1);
+}
+
+M3D_API size_t m3dBvhBuild(M3dBvh *bvh)
+{
+    M3D_PROFILE_FUNCTION();
+    bvh->nodeCount = 0;
+
+    if(bvh->count == 0)
+    {
+        return 0;
+    }
+
+    for(uint32_t i = 0; i < (uint32_t)bvh->count; i++)
+    {
+        bvh->indices[i] = i;
+    }
+
+    // node 1 stays unused so every child pair starts on an even node
+    BvhBuildInternal b = {bvh, 2};
+    bvh->nodes[1] = (M3dBvhNode){{{0, 0, 0}, {0, 0, 0}}, 0, 0};
+
+#ifdef _OPENMP
+    #pragma omp parallel if(bvh->count >= BVH_PARALLEL_MIN)
+    #pragma omp single
+#endif // _OPENMP
+    buildNodeInternal(&b, 0, 0, (uint32_t)bvh->count, 0);
+
+    bvh->nodeCount = b.next;
+    return bvh->nodeCount;
+}
+
+/** ---------------- queries */
+
+M3D_API uint32_t m3dBvhRaycast(M3dBvh bvh, Vec3 origin, Vec3 dir, M3dValue *maxT, M3dBvhRayFunc hit, void *user)
+{
+    M3D_PROFILE_FUNCTION();
+    uint32_t best = M3D_BVH_NONE;
+    Vec3 inv = {1 / dir.x, 1 / dir.y, 1 / dir.z};
+    M3dValue t;
+
+    if(bvh.nodeCount == 0 || !rayInternal(&bvh.nodes[0].bounds, &origin, &inv, *maxT, &t))
+    {
+        return best;
+    }
+
+    // the farther child waits on the stack with its entry distance,
+    // so it is skipped once a closer hit has been found
+    uint32_t stack[BVH_STACK];
+    M3dValue stackT[BVH_STACK];
+    size_t top = 0;
+    uint32_t node = 0;
+
+    for(;;)
+    {
+        const M3dBvhNode *n = &bvh.nodes[node];
+
+        if(n->count)
+        {
+            for(uint32_t i = n->first; i < n->first + n->count; i++)
+            {
+                uint32_t index = bvh.indices[i];
+
+                if(!rayInternal(&bvh.bounds[index], &origin, &inv, *maxT, &t))
+                {
+                    continue;
+                }
+
+                if(hit)
+                {
+                    t = hit(user, index, origin, dir, *maxT);
+                }
+
+                if(t < *maxT)
+                {
+                    *maxT = t;
+                    best = index;
+                }
+            }
+        }
+        else
+        {
+            M3dValue tl, tr;
+            char hl = rayInternal(&bvh.nodes[n->first].bounds, &origin, &inv, *maxT, &tl);
+            char hr = rayInternal(&bvh.nodes[n->first + 1].bounds, &origin, &inv, *maxT, &tr);
+
+            if(hl && hr)
+            {
+                char rightFirst = tr < tl;
+
+                stack[top] = n->first + !rightFirst;
+                stackT[top++] = rightFirst ? tl : tr;
+                node = n->first + rightFirst;
+                continue;
+            }
+
+            if(hl || hr)
+            {
+                node = n->first + hr;
+                continue;
+            }
+        }
+
+        do
+        {
+            if(top == 0)
+            {
+                return best;
+            }
+
+            node = stack[--top];
+        }
+        while(!(stackT[top] < *maxT));
+    }
+}
+
+// the ray and box queries share one traversal, a point is a box of size 0
+typedef struct{
+    Aabb box;
+    Vec3 origin;
+    Vec3 inv;
+    M3dValue maxT;
+    char ray;
+}BvhQueryInternal;
+
+static inline char queryHitsInternal(const BvhQueryInternal *q, const Aabb *a)
+{
+    M3dValue t;
+    return q->ray ? rayInternal(a, &q->origin, &q->inv, q->maxT, &t) : overlapsInternal(&q->box, a);
+}
+
+static size_t queryInternal(uint32_t *res, size_t capacity, const M3dBvh *bvh, const BvhQueryInternal *q)
+{
+    size_t count = 0;
+
+    if(bvh->nodeCount == 0 || !queryHitsInternal(q, &bvh->nodes[0].bounds))
+    {
+        return 0;
+    }
+
+    uint32_t stack[BVH_STACK];
+    size_t top = 0;
+    uint32_t node = 0;
+
+    for(;;)
+    {
+        const M3dBvhNode *n = &bvh->nodes[node];
+
+        if(n->count)
+        {
+            for(uint32_t i = n->first; i < n->first + n->count; i++)
+            {
+                uint32_t index = bvh->indices[i];
+
+                if(queryHitsInternal(q, &bvh->bounds[index]))
+                {
+                    if(count < capacity)
+                    {
+                        res[count] = index;
+                    }
+
+                    count++;
+                }
+            }
+        }
+        else
+        {
+            char hl = queryHitsInternal(q, &bvh->nodes[n->first].bounds);
+            char hr = queryHitsInternal(q, &bvh->nodes[n->first + 1].bounds);
+
+            if(hl && hr)
+            {
+                stack[top++] = n->first + 1;
+            }
+
+            if(hl || hr)
+            {
+                node = n->first + !hl;
+                continue;
+            }
+        }
+
+        if(top == 0)
+        {
+            return count;
+        }
+
+        node = stack[--top];
+    }
+}
+
+M3D_API size_t m3dBvhQueryVec3(uint32_t *M3D_RESTRICT res, size_t capacity, M3dBvh bvh, Vec3 p)
+{
+    M3D_PROFILE_FUNCTION();
+    BvhQueryInternal q = {{p, p}, {0, 0, 0}, {0, 0, 0}, 0, 0};
+    return queryInternal(res, capacity, &bvh, &q);
+}
+
+M3D_API size_t m3dBvhQueryAabb(uint32_t *M3D_RESTRICT res, size_t capacity, M3dBvh bvh, Aabb box)
+{
+    M3D_PROFILE_FUNCTION();
+    BvhQueryInternal q = {box, {0, 0, 0}, {0, 0, 0}, 0, 0};
+    return queryInternal(res, capacity, &bvh, &q);
+}
+
+M3D_API size_t m3dBvhQueryRay(uint32_t *M3D_RESTRICT res, size_t capacity, M3dBvh bvh, Vec3 origin, Vec3 dir, M3dValue maxT)
+{
+    M3D_PROFILE_FUNCTION();
+    BvhQueryInternal q = {{{0, 0, 0}, {0, 0, 0}}, origin, {1 / dir.x, 1 / dir.y, 1 / dir.z}, maxT, 1};
+    return queryInternal(res, capacity, &bvh, &q);
+}
+
+#endif // M3D_FIXED
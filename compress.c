@@ -0,0 +1,428 @@
+#include "m3d/m3d.h"
+#include "internal.h"
+
+#ifndef M3D_FIXED
+
+// the three smaller components of a unit quaternion lie in [-1 / sqrt(2), 1 / sqrt(2)]
+#define SQRT2 1.41421356237309505
+#define HALF_SQRT2 0.70710678118654752
+
+// an even number of steps so 0 is exact, the top code of each field is unused
+#define QUAT32_MAX 1022
+#define QUAT48_MAX 32766
+#define QUAT32_MASK 1023
+#define QUAT48_MASK 32767
+#define VEC3_MAX 65535
+
+/** ---------------- quaternion, smallest three */
+
+// index of the largest absolute component, the first one wins ties so the sse2 path matches.
+// the other three come out in i, j, k, w order with the sign flipped so the largest is positive
+static unsigned int smallestThreeInternal(const Quat *q, M3dValue *a, M3dValue *b, M3dValue *c)
+{
+    M3dValue v[4] = {q->i, q->j, q->k, q->w};
+    unsigned int largest = 0;
+    M3dValue largestAbs = v[0] < 0 ? -v[0] : v[0];
+
+    for(unsigned int n = 1; n < 4; n++)
+    {
+        M3dValue abs = v[n] < 0 ? -v[n] : v[n];
+
+        if(abs > largestAbs)
+        {
+            largest = n;
+            largestAbs = abs;
+        }
+    }
+
+    M3dValue sign = v[largest] < 0 ? -1 : 1;
+    M3dValue *out[3] = {a, b, c};
+
+    for(unsigned int n = 0, o = 0; n < 4; n++)
+    {
+        if(n != largest)
+        {
+            *out[o++] = v[n] * sign;
+        }
+    }
+
+    return largest;
+}
+
+static unsigned int quantizeSmallInternal(M3dValue v, unsigned int max)
+{
+    M3dValue q = (v * (M3dValue)SQRT2 + 1) * (M3dValue)0.5 * (M3dValue)max + (M3dValue)0.5;
+    q = m3dMaxInternal(m3dMinInternal(q, (M3dValue)max), 0);
+
+    return (unsigned int)q;
+}
+
+static M3dValue dequantizeSmallInternal(unsigned int q, unsigned int max)
+{
+    return ((M3dValue)q * ((M3dValue)2 / (M3dValue)max) - 1) * (M3dValue)HALF_SQRT2;
+}
+
+static Quat rebuildInternal(unsigned int largest, M3dValue a, M3dValue b, M3dValue c)
+{
+    M3dValue l = m3dSqrtInternal(m3dMaxInternal(1 - a * a - b * b - c * c, 0));
+    Quat res;
+
+    res.i = largest == 0 ? l : a;
+    res.j = largest == 0 ? a : (largest == 1 ? l : b);
+    res.k = largest <= 1 ? b : (largest == 2 ? l : c);
+    res.w = largest == 3 ? l : c;
+
+    return res;
+}
+
+M3D_API PackedQuat32 m3dQuatEncode32(Quat q)
+{
+    M3D_PROFILE_FUNCTION();
+    M3dValue a, b, c;
+    unsigned int largest = smallestThreeInternal(&q, &a, &b, &c);
+
+    return (PackedQuat32)largest << 30 | (PackedQuat32)quantizeSmallInternal(a, QUAT32_MAX) << 20 |
+           (PackedQuat32)quantizeSmallInternal(b, QUAT32_MAX) << 10 | (PackedQuat32)quantizeSmallInternal(c, QUAT32_MAX);
+}
+
+M3D_API Quat m3dQuatDecode32(PackedQuat32 q)
+{
+    M3D_PROFILE_FUNCTION();
+    return rebuildInternal(q >> 30,
+                           dequantizeSmallInternal((q >> 20) & QUAT32_MASK, QUAT32_MAX),
+                           dequantizeSmallInternal((q >> 10) & QUAT32_MASK, QUAT32_MAX),
+                           dequantizeSmallInternal(q & QUAT32_MASK, QUAT32_MAX));
+}
+
+M3D_API PackedQuat48 m3dQuatEncode48(Quat q)
+{
+    M3D_PROFILE_FUNCTION();
+    M3dValue a, b, c;
+    unsigned int largest = smallestThreeInternal(&q, &a, &b, &c);
+    PackedQuat48 res;
+
+    // 15 bits per component, the largest index in the top bits of the first two
+    res.v[0] = (uint16_t)(quantizeSmallInternal(a, QUAT48_MAX) | (largest & 2) << 14);
+    res.v[1] = (uint16_t)(quantizeSmallInternal(b, QUAT48_MAX) | (largest & 1) << 15);
+    res.v[2] = (uint16_t)quantizeSmallInternal(c, QUAT48_MAX);
+
+    return res;
+}
+
+M3D_API Quat m3dQuatDecode48(PackedQuat48 q)
+{
+    M3D_PROFILE_FUNCTION();
+    unsigned int largest = (q.v[0] >> 14 & 2) | q.v[1] >> 15;
+
+    return rebuildInternal(largest,
+                           dequantizeSmallInternal(q.v[0] & QUAT48_MASK, QUAT48_MAX),
+                           dequantizeSmallInternal(q.v[1] & QUAT48_MASK, QUAT48_MAX),
+                           dequantizeSmallInternal(q.v[2] & QUAT48_MASK, QUAT48_MAX));
+}
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+
+static inline __m128 selectSse2(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// smallest three of 4 quaternions, the same choices and rounding as the scalar code.
+// writes the largest index and the three quantized components of each lane
+static void encodeQuatx4Sse2(const Quat *q, __m128i *largest, __m128i *a, __m128i *b, __m128i *c, float max)
+{
+    __m128 i = _mm_loadu_ps(&q[0].i);
+    __m128 j = _mm_loadu_ps(&q[1].i);
+    __m128 k = _mm_loadu_ps(&q[2].i);
+    __m128 w = _mm_loadu_ps(&q[3].i);
+
+    _MM_TRANSPOSE4_PS(i, j, k, w);
+
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    __m128 ai = _mm_andnot_ps(signBit, i);
+    __m128 aj = _mm_andnot_ps(signBit, j);
+    __m128 ak = _mm_andnot_ps(signBit, k);
+    __m128 aw = _mm_andnot_ps(signBit, w);
+
+    // the scalar scan only moves on when a later component is strictly larger
+    __m128 isJ = _mm_cmpgt_ps(aj, ai);
+    __m128 best = _mm_max_ps(ai, aj);
+    __m128 isK = _mm_cmpgt_ps(ak, best);
+    best = _mm_max_ps(best, ak);
+    __m128 isW = _mm_cmpgt_ps(aw, best);
+
+    // the largest index as 0 to 3, and masks of idx == 0, idx <= 1, idx <= 2
+    __m128i idx = _mm_and_si128(_mm_castps_si128(isJ), _mm_set1_epi32(1));
+    idx = _mm_or_si128(_mm_andnot_si128(_mm_castps_si128(isK), idx), _mm_and_si128(_mm_castps_si128(isK), _mm_set1_epi32(2)));
+    idx = _mm_or_si128(_mm_andnot_si128(_mm_castps_si128(isW), idx), _mm_and_si128(_mm_castps_si128(isW), _mm_set1_epi32(3)));
+
+    __m128 is0 = _mm_castsi128_ps(_mm_cmpeq_epi32(idx, _mm_setzero_si128()));
+    __m128 le1 = _mm_castsi128_ps(_mm_cmplt_epi32(idx, _mm_set1_epi32(2)));
+    __m128 le2 = _mm_castsi128_ps(_mm_cmplt_epi32(idx, _mm_set1_epi32(3)));
+
+    __m128 l = selectSse2(is0, i, selectSse2(le1, j, selectSse2(le2, k, w)));
+    __m128 sign = _mm_and_ps(_mm_cmplt_ps(l, _mm_setzero_ps()), signBit);
+
+    __m128 va = _mm_xor_ps(selectSse2(is0, j, i), sign);
+    __m128 vb = _mm_xor_ps(selectSse2(le1, k, j), sign);
+    __m128 vc = _mm_xor_ps(selectSse2(le2, w, k), sign);
+
+    const __m128 scale = _mm_set1_ps((float)SQRT2);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 vmax = _mm_set1_ps(max);
+
+    va = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(va, scale), one), half), vmax), half);
+    vb = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(vb, scale), one), half), vmax), half);
+    vc = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(vc, scale), one), half), vmax), half);
+
+    *largest = idx;
+    *a = _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(va, vmax), _mm_setzero_ps()));
+    *b = _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(vb, vmax), _mm_setzero_ps()));
+    *c = _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(vc, vmax), _mm_setzero_ps()));
+}
+
+// rebuilds 4 quaternions from the largest index and three quantized components
+static void decodeQuatx4Sse2(Quat *res, __m128i idx, __m128i a, __m128i b, __m128i c, float max)
+{
+    const __m128 scale = _mm_set1_ps(2.0f / max);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 halfSqrt2 = _mm_set1_ps((float)HALF_SQRT2);
+
+    __m128 va = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(a), scale), one), halfSqrt2);
+    __m128 vb = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(b), scale), one), halfSqrt2);
+    __m128 vc = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(c), scale), one), halfSqrt2);
+
+    __m128 l = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(one, _mm_mul_ps(va, va)), _mm_mul_ps(vb, vb)), _mm_mul_ps(vc, vc));
+    l = _mm_sqrt_ps(_mm_max_ps(l, _mm_setzero_ps()));
+
+    __m128 is0 = _mm_castsi128_ps(_mm_cmpeq_epi32(idx, _mm_setzero_si128()));
+    __m128 is1 = _mm_castsi128_ps(_mm_cmpeq_epi32(idx, _mm_set1_epi32(1)));
+    __m128 is2 = _mm_castsi128_ps(_mm_cmpeq_epi32(idx, _mm_set1_epi32(2)));
+    __m128 is3 = _mm_castsi128_ps(_mm_cmpeq_epi32(idx, _mm_set1_epi32(3)));
+    __m128 le1 = _mm_or_ps(is0, is1);
+
+    m3dStoreQuatx4Internal(res,
+                           selectSse2(is0, l, va),
+                           selectSse2(is0, va, selectSse2(is1, l, vb)),
+                           selectSse2(le1, vb, selectSse2(is2, l, vc)),
+                           selectSse2(is3, l, vc));
+}
+
+#endif // M3D_SSE2
+
+M3D_API void m3dQuatEncode32Array(PackedQuat32 *M3D_RESTRICT res, const Quat *q, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t n = 0;
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    for(size_t last = m3dGroupEndInternal(n, count, 4); n < last; n += 4)
+    {
+        __m128i largest, a, b, c;
+        encodeQuatx4Sse2(q + n, &largest, &a, &b, &c, QUAT32_MAX);
+
+        __m128i packed = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(largest, 30), _mm_slli_epi32(a, 20)),
+                                      _mm_or_si128(_mm_slli_epi32(b, 10), c));
+        _mm_storeu_si128((__m128i *)(res + n), packed);
+    }
+#endif
+
+    for(; n < count; n++)
+    {
+        res[n] = m3dQuatEncode32(q[n]);
+    }
+}
+
+M3D_API void m3dQuatDecode32Array(Quat *M3D_RESTRICT res, const PackedQuat32 *q, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t n = 0;
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    const __m128i mask = _mm_set1_epi32(QUAT32_MASK);
+
+    for(size_t last = m3dGroupEndInternal(n, count, 4); n < last; n += 4)
+    {
+        __m128i packed = _mm_loadu_si128((const __m128i *)(q + n));
+
+        decodeQuatx4Sse2(res + n, _mm_srli_epi32(packed, 30),
+                         _mm_and_si128(_mm_srli_epi32(packed, 20), mask),
+                         _mm_and_si128(_mm_srli_epi32(packed, 10), mask),
+                         _mm_and_si128(packed, mask), QUAT32_MAX);
+    }
+#endif
+
+    for(; n < count; n++)
+    {
+        res[n] = m3dQuatDecode32(q[n]);
+    }
+}
+
+M3D_API void m3dQuatEncode48Array(PackedQuat48 *M3D_RESTRICT res, const Quat *q, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t n = 0;
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    for(size_t last = m3dGroupEndInternal(n, count, 4); n < last; n += 4)
+    {
+        __m128i largest, a, b, c;
+        encodeQuatx4Sse2(q + n, &largest, &a, &b, &c, QUAT48_MAX);
+
+        // 6 byte records don't line up with the lanes, so they are written out one by one
+        uint32_t v0[4], v1[4], v2[4];
+        _mm_storeu_si128((__m128i *)v0, _mm_or_si128(a, _mm_slli_epi32(_mm_and_si128(largest, _mm_set1_epi32(2)), 14)));
+        _mm_storeu_si128((__m128i *)v1, _mm_or_si128(b, _mm_slli_epi32(largest, 15)));
+        _mm_storeu_si128((__m128i *)v2, c);
+
+        for(int l = 0; l < 4; l++)
+        {
+            res[n + l].v[0] = (uint16_t)v0[l];
+            res[n + l].v[1] = (uint16_t)v1[l];
+            res[n + l].v[2] = (uint16_t)v2[l];
+        }
+    }
+#endif
+
+    for(; n < count; n++)
+    {
+        res[n] = m3dQuatEncode48(q[n]);
+    }
+}
+
+M3D_API void m3dQuatDecode48Array(Quat *M3D_RESTRICT res, const PackedQuat48 *q, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t n = 0;
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    const __m128i mask = _mm_set1_epi32(QUAT48_MASK);
+
+    for(size_t last = m3dGroupEndInternal(n, count, 4); n < last; n += 4)
+    {
+        const PackedQuat48 *p = q + n;
+        __m128i v0 = _mm_setr_epi32(p[0].v[0], p[1].v[0], p[2].v[0], p[3].v[0]);
+        __m128i v1 = _mm_setr_epi32(p[0].v[1], p[1].v[1], p[2].v[1], p[3].v[1]);
+        __m128i v2 = _mm_setr_epi32(p[0].v[2], p[1].v[2], p[2].v[2], p[3].v[2]);
+
+        __m128i largest = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v0, 14), _mm_set1_epi32(2)), _mm_srli_epi32(v1, 15));
+
+        decodeQuatx4Sse2(res + n, largest, _mm_and_si128(v0, mask), _mm_and_si128(v1, mask),
+                         _mm_and_si128(v2, mask), QUAT48_MAX);
+    }
+#endif
+
+    for(; n < count; n++)
+    {
+        res[n] = m3dQuatDecode48(q[n]);
+    }
+}
+
+/** ---------------- Vec3 within a box */
+
+static uint16_t quantizeBoxInternal(M3dValue v, M3dValue min, M3dValue scale)
+{
+    M3dValue q = (v - min) * scale + (M3dValue)0.5;
+    q = m3dMaxInternal(m3dMinInternal(q, (M3dValue)VEC3_MAX), 0);
+
+    return (uint16_t)q;
+}
+
+M3D_API PackedVec3 m3dVec3Encode48(Vec3 v, Vec3 min, Vec3 max)
+{
+    M3D_PROFILE_FUNCTION();
+    PackedVec3 res;
+
+    res.x = quantizeBoxInternal(v.x, min.x, (M3dValue)VEC3_MAX / (max.x - min.x));
+    res.y = quantizeBoxInternal(v.y, min.y, (M3dValue)VEC3_MAX / (max.y - min.y));
+    res.z = quantizeBoxInternal(v.z, min.z, (M3dValue)VEC3_MAX / (max.z - min.z));
+
+    return res;
+}
+
+M3D_API Vec3 m3dVec3Decode48(PackedVec3 v, Vec3 min, Vec3 max)
+{
+    M3D_PROFILE_FUNCTION();
+    Vec3 res;
+
+    res.x = min.x + (M3dValue)v.x * ((max.x - min.x) / (M3dValue)VEC3_MAX);
+    res.y = min.y + (M3dValue)v.y * ((max.y - min.y) / (M3dValue)VEC3_MAX);
+    res.z = min.z + (M3dValue)v.z * ((max.z - min.z) / (M3dValue)VEC3_MAX);
+
+    return res;
+}
+
+M3D_API void m3dVec3Encode48Array(PackedVec3 *M3D_RESTRICT res, const Vec3 *v, size_t count, Vec3 min, Vec3 max)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t n = 0;
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    const __m128 minX = _mm_set1_ps(min.x), minY = _mm_set1_ps(min.y), minZ = _mm_set1_ps(min.z);
+    const __m128 scaleX = _mm_set1_ps((float)VEC3_MAX / (max.x - min.x));
+    const __m128 scaleY = _mm_set1_ps((float)VEC3_MAX / (max.y - min.y));
+    const __m128 scaleZ = _mm_set1_ps((float)VEC3_MAX / (max.z - min.z));
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 vmax = _mm_set1_ps((float)VEC3_MAX);
+    const __m128 zero = _mm_setzero_ps();
+
+    for(size_t last = m3dGroupEndInternal(n, count, 4); n < last; n += 4)
+    {
+        __m128 x, y, z;
+        m3dLoadVec3x4Internal(&v[n].x, &x, &y, &z);
+
+        x = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(x, minX), scaleX), half);
+        y = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(y, minY), scaleY), half);
+        z = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(z, minZ), scaleZ), half);
+
+        uint32_t qx[4], qy[4], qz[4];
+        _mm_storeu_si128((__m128i *)qx, _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(x, vmax), zero)));
+        _mm_storeu_si128((__m128i *)qy, _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(y, vmax), zero)));
+        _mm_storeu_si128((__m128i *)qz, _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(z, vmax), zero)));
+
+        for(int l = 0; l < 4; l++)
+        {
+            res[n + l].x = (uint16_t)qx[l];
+            res[n + l].y = (uint16_t)qy[l];
+            res[n + l].z = (uint16_t)qz[l];
+        }
+    }
+#endif
+
+    for(; n < count; n++)
+    {
+        res[n] = m3dVec3Encode48(v[n], min, max);
+    }
+}
+
+M3D_API void m3dVec3Decode48Array(Vec3 *M3D_RESTRICT res, const PackedVec3 *v, size_t count, Vec3 min, Vec3 max)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t n = 0;
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    const __m128 minX = _mm_set1_ps(min.x), minY = _mm_set1_ps(min.y), minZ = _mm_set1_ps(min.z);
+    const __m128 stepX = _mm_set1_ps((max.x - min.x) / (float)VEC3_MAX);
+    const __m128 stepY = _mm_set1_ps((max.y - min.y) / (float)VEC3_MAX);
+    const __m128 stepZ = _mm_set1_ps((max.z - min.z) / (float)VEC3_MAX);
+
+    for(size_t last = m3dGroupEndInternal(n, count, 4); n < last; n += 4)
+    {
+        const PackedVec3 *p = v + n;
+        __m128 x = _mm_cvtepi32_ps(_mm_setr_epi32(p[0].x, p[1].x, p[2].x, p[3].x));
+        __m128 y = _mm_cvtepi32_ps(_mm_setr_epi32(p[0].y, p[1].y, p[2].y, p[3].y));
+        __m128 z = _mm_cvtepi32_ps(_mm_setr_epi32(p[0].z, p[1].z, p[2].z, p[3].z));
+
+        m3dStoreVec3x4Internal(&res[n].x, _mm_add_ps(minX, _mm_mul_ps(x, stepX)), _mm_add_ps(minY, _mm_mul_ps(y, stepY)),
+                               _mm_add_ps(minZ, _mm_mul_ps(z, stepZ)), 0);
+    }
+#endif
+
+    for(; n < count; n++)
+    {
+        res[n] = m3dVec3Decode48(v[n], min, max);
+    }
+}
+
+#endif // M3D_FIXED
@@ -0,0 +1,76 @@
+#include "m3d/m3d.h"
+#include "internal.h"
+
+#if defined(_MSC_VER) && defined(M3D_X86_DISPATCH)
+#include <intrin.h>
+#endif
+
+// no cpu has every flag, so all bits set marks the features as not detected yet.
+// one variable, so a thread can't see the detected mark without the flags
+#define CPU_UNDETECTED (~0u)
+
+static unsigned int cpuFeatures = CPU_UNDETECTED;
+static unsigned int cpuMask = ~0u;
+
+static unsigned int detectCpuFeaturesInternal()
+{
+    unsigned int res = 0;
+
+#if defined(M3D_X86_DISPATCH) && (defined(__GNUC__) || defined(__clang__))
+    // the builtins also check that the os saves the wide registers
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("sse2")) res |= M3D_CPU_SSE2;
+    if(__builtin_cpu_supports("avx"))  res |= M3D_CPU_AVX;
+    if(__builtin_cpu_supports("avx2")) res |= M3D_CPU_AVX2;
+    if(__builtin_cpu_supports("fma"))  res |= M3D_CPU_FMA;
+    if(__builtin_cpu_supports("avx512f")) res |= M3D_CPU_AVX512;
+#elif defined(M3D_X86_DISPATCH) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    if(info[3] & (1 << 26)) res |= M3D_CPU_SSE2;
+
+    // avx needs both the cpu bit and the os saving ymm state (xcr0 bits 1 and 2)
+    char osxsave = (info[2] & (1 << 27)) != 0;
+    char ymmSaved = osxsave && (_xgetbv(0) & 0x6) == 0x6;
+    // avx-512 also needs the opmask and upper zmm state (xcr0 bits 5 to 7)
+    char zmmSaved = osxsave && (_xgetbv(0) & 0xE6) == 0xE6;
+
+    if(ymmSaved && (info[2] & (1 << 28))) res |= M3D_CPU_AVX;
+    if(ymmSaved && (info[2] & (1 << 12))) res |= M3D_CPU_FMA;
+
+    if(maxLeaf >= 7)
+    {
+        __cpuidex(info, 7, 0);
+        if(ymmSaved && (info[1] & (1 << 5))) res |= M3D_CPU_AVX2;
+        if(zmmSaved && (info[1] & (1 << 16))) res |= M3D_CPU_AVX512;
+    }
+#elif defined(M3D_SSE2)
+    res |= M3D_CPU_SSE2;
+#endif
+
+    return res;
+}
+
+M3D_API unsigned int m3dCpuFeatures()
+{
+    M3D_PROFILE_FUNCTION();
+    unsigned int features = M3D_LOAD_RELAXED(cpuFeatures);
+
+    if(features == CPU_UNDETECTED)
+    {
+        features = detectCpuFeaturesInternal();
+        M3D_STORE_RELAXED(cpuFeatures, features);
+    }
+
+    return features & M3D_LOAD_RELAXED(cpuMask);
+}
+
+M3D_API void m3dCpuSetFeatures(unsigned int mask)
+{
+    M3D_PROFILE_FUNCTION();
+    M3D_STORE_RELAXED(cpuMask, mask);
+}
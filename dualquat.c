@@ -0,0 +1,369 @@
+#include "m3d/m3d.h"
+#include "internal.h"
+
+#ifndef M3D_FIXED
+
+M3D_API DualQuat m3dDualQuatInitIdentity()
+{
+    M3D_PROFILE_FUNCTION();
+    DualQuat res = {{0, 0, 0, 1}, {0, 0, 0, 0}};
+    return res;
+}
+
+// dual = t * real / 2 with t as a pure quaternion
+M3D_API DualQuat m3dDualQuatFromTr(Vec3 t, Quat r)
+{
+    M3D_PROFILE_FUNCTION();
+    DualQuat res;
+    res.real = r;
+    res.dual.i = (t.x * r.w + t.y * r.k - t.z * r.j) / 2;
+    res.dual.j = (t.y * r.w + t.z * r.i - t.x * r.k) / 2;
+    res.dual.k = (t.z * r.w + t.x * r.j - t.y * r.i) / 2;
+    res.dual.w = -(t.x * r.i + t.y * r.j + t.z * r.k) / 2;
+    return res;
+}
+
+M3D_API DualQuat m3dDualQuatFromMat4x4(Mat4x4 m)
+{
+    M3D_PROFILE_FUNCTION();
+    Vec3 t = {m.m[0][3], m.m[1][3], m.m[2][3]};
+    return m3dDualQuatFromTr(t, m3dQuatFromMat4x4(m));
+}
+
+// the vector part of 2 * dual * conjugate(real)
+static inline void translationInternal(Vec3 *res, const Quat *r, const Quat *d)
+{
+    res->x = (r->w * d->i - d->w * r->i + (r->j * d->k - r->k * d->j)) * 2;
+    res->y = (r->w * d->j - d->w * r->j + (r->k * d->i - r->i * d->k)) * 2;
+    res->z = (r->w * d->k - d->w * r->k + (r->i * d->j - r->j * d->i)) * 2;
+}
+
+M3D_API Vec3 m3dDualQuatTranslation(DualQuat d)
+{
+    M3D_PROFILE_FUNCTION();
+    Vec3 res;
+
+    translationInternal(&res, &d.real, &d.dual);
+
+    return res;
+}
+
+M3D_API Mat4x4 m3dDualQuatToMat4x4(DualQuat d)
+{
+    M3D_PROFILE_FUNCTION();
+    Vec3 t = m3dDualQuatTranslation(d);
+    Vec3 s = {1, 1, 1};
+
+    return m3dMat4x4FromTrs(t, d.real, s);
+}
+
+M3D_API void m3dDualQuatMulDualQuatPtr(DualQuat *M3D_RESTRICT res, const DualQuat *a, const DualQuat *b)
+{
+    M3D_PROFILE_FUNCTION();
+    Quat ab;
+    Quat ba;
+
+    m3dQuatMulQuatPtr(&res->real, &a->real, &b->real);
+    m3dQuatMulQuatPtr(&ab, &a->real, &b->dual);
+    m3dQuatMulQuatPtr(&ba, &a->dual, &b->real);
+
+    res->dual.i = ab.i + ba.i;
+    res->dual.j = ab.j + ba.j;
+    res->dual.k = ab.k + ba.k;
+    res->dual.w = ab.w + ba.w;
+}
+
+M3D_API DualQuat m3dDualQuatMulDualQuat(DualQuat a, DualQuat b)
+{
+    M3D_PROFILE_FUNCTION();
+    DualQuat res;
+
+    m3dDualQuatMulDualQuatPtr(&res, &a, &b);
+
+    return res;
+}
+
+// a unit real part and a dual part orthogonal to it, so the pair is a rigid transform again
+M3D_API DualQuat m3dDualQuatNormalized(DualQuat d)
+{
+    M3D_PROFILE_FUNCTION();
+    M3dValue inv = 1 / m3dQuatLength(d.real);
+
+    d.real = m3dQuatMulValue(d.real, inv);
+    d.dual = m3dQuatMulValue(d.dual, inv);
+
+    M3dValue dot = d.real.i * d.dual.i + d.real.j * d.dual.j + d.real.k * d.dual.k + d.real.w * d.dual.w;
+
+    d.dual.i -= d.real.i * dot;
+    d.dual.j -= d.real.j * dot;
+    d.dual.k -= d.real.k * dot;
+    d.dual.w -= d.real.w * dot;
+
+    return d;
+}
+
+/** ---------------- blending */
+
+static inline M3dValue dotInternal(const Quat *a, const Quat *b)
+{
+    return a->i * b->i + a->j * b->j + a->k * b->k + a->w * b->w;
+}
+
+// res += d * w, with w negated when d is on the other side of the 4d sphere from ref
+static inline void accumulateInternal(DualQuat *res, const DualQuat *d, M3dValue w, const Quat *ref)
+{
+    if(dotInternal(&d->real, ref) < 0)
+    {
+        w = -w;
+    }
+
+    res->real.i += d->real.i * w;
+    res->real.j += d->real.j * w;
+    res->real.k += d->real.k * w;
+    res->real.w += d->real.w * w;
+    res->dual.i += d->dual.i * w;
+    res->dual.j += d->dual.j * w;
+    res->dual.k += d->dual.k * w;
+    res->dual.w += d->dual.w * w;
+}
+
+// divides both parts by the length of the real one, which is all transforming needs
+static inline void scaleToUnitInternal(DualQuat *d)
+{
+    M3dValue inv = 1 / m3dSqrtInternal(dotInternal(&d->real, &d->real));
+
+    d->real = m3dQuatMulValue(d->real, inv);
+    d->dual = m3dQuatMulValue(d->dual, inv);
+}
+
+M3D_API DualQuat m3dDualQuatBlend(const DualQuat *d, const M3dValue *weights, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    DualQuat res = {{0, 0, 0, 0}, {0, 0, 0, 0}};
+
+    for(size_t n = 0; n < count; n++)
+    {
+        accumulateInternal(&res, &d[n], weights[n], &d[0].real);
+    }
+
+    return m3dDualQuatNormalized(res);
+}
+
+M3D_API DualQuat m3dDualQuatLerp(DualQuat a, DualQuat b, M3dValue t)
+{
+    M3D_PROFILE_FUNCTION();
+    DualQuat d[2] = {a, b};
+    M3dValue weights[2] = {1 - t, t};
+
+    return m3dDualQuatBlend(d, weights, 2);
+}
+
+/** ---------------- transforms */
+
+// the rotation of m3dQuatRotateVec3Ptr, then the translation for points
+static inline void transformInternal(Vec3 *res, const Quat *r, const Quat *d, const Vec3 *v, char point)
+{
+    m3dQuatRotateVec3Ptr(res, r, v);
+
+    if(point)
+    {
+        Vec3 t;
+        translationInternal(&t, r, d);
+
+        res->x += t.x;
+        res->y += t.y;
+        res->z += t.z;
+    }
+}
+
+M3D_API void m3dDualQuatTransformPointPtr(Vec3 *M3D_RESTRICT res, const DualQuat *d, const Vec3 *p)
+{
+    M3D_PROFILE_FUNCTION();
+    transformInternal(res, &d->real, &d->dual, p, 1);
+}
+
+M3D_API Vec3 m3dDualQuatTransformPoint(DualQuat d, Vec3 p)
+{
+    M3D_PROFILE_FUNCTION();
+    Vec3 res;
+
+    transformInternal(&res, &d.real, &d.dual, &p, 1);
+
+    return res;
+}
+
+M3D_API Vec3 m3dDualQuatTransformDirection(DualQuat d, Vec3 v)
+{
+    M3D_PROFILE_FUNCTION();
+    Vec3 res;
+
+    transformInternal(&res, &d.real, &d.dual, &v, 0);
+
+    return res;
+}
+
+/** ---------------- skinning */
+
+static void skinScalar(Vec3 *res, const Vec3 *v, const uint16_t *bones, const M3dValue *weights,
+                       const DualQuat *palette, size_t begin, size_t end, char point)
+{
+    for(size_t n = begin; n < end; n++)
+    {
+        const uint16_t *b = bones + 4 * n;
+        const M3dValue *w = weights + 4 * n;
+        const Quat *ref = &palette[b[0]].real;
+
+        DualQuat d = {{0, 0, 0, 0}, {0, 0, 0, 0}};
+
+        for(int k = 0; k < 4; k++)
+        {
+            accumulateInternal(&d, &palette[b[k]], w[k], ref);
+        }
+
+        scaleToUnitInternal(&d);
+
+        // v may be res
+        Vec3 p = v[n];
+        transformInternal(&res[n], &d.real, &d.dual, &p, point);
+    }
+}
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+
+// the 4 quaternions at q[0..3] transposed into i, j, k and w registers
+static inline void loadQuatx4Internal(const Quat *q0, const Quat *q1, const Quat *q2, const Quat *q3,
+                                      __m128 *i, __m128 *j, __m128 *k, __m128 *w)
+{
+    *i = _mm_loadu_ps(&q0->i);
+    *j = _mm_loadu_ps(&q1->i);
+    *k = _mm_loadu_ps(&q2->i);
+    *w = _mm_loadu_ps(&q3->i);
+
+    _MM_TRANSPOSE4_PS(*i, *j, *k, *w);
+}
+
+// 4 vertices per step, every lane is one vertex and the bone dual quaternions are transposed
+// into it, the operations are those of skinScalar in the same order
+static size_t skinSse2(Vec3 *res, const Vec3 *v, const uint16_t *bones, const M3dValue *weights,
+                       const DualQuat *palette, size_t begin, size_t end, char point)
+{
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    size_t n = begin;
+
+    for(size_t last = m3dGroupEndInternal(n, end, 4); n < last; n += 4)
+    {
+        const uint16_t *b = bones + 4 * n;
+
+        // row m of the weights is vertex m, transposed so register k holds influence k
+        __m128 w[4];
+        w[0] = _mm_loadu_ps(weights + 4 * n);
+        w[1] = _mm_loadu_ps(weights + 4 * n + 4);
+        w[2] = _mm_loadu_ps(weights + 4 * n + 8);
+        w[3] = _mm_loadu_ps(weights + 4 * n + 12);
+
+        _MM_TRANSPOSE4_PS(w[0], w[1], w[2], w[3]);
+
+        __m128 refI, refJ, refK, refW;
+        __m128 ri = _mm_setzero_ps(), rj = _mm_setzero_ps(), rk = _mm_setzero_ps(), rw = _mm_setzero_ps();
+        __m128 di = _mm_setzero_ps(), dj = _mm_setzero_ps(), dk = _mm_setzero_ps(), dw = _mm_setzero_ps();
+
+        for(int k = 0; k < 4; k++)
+        {
+            const DualQuat *d0 = &palette[b[k]];
+            const DualQuat *d1 = &palette[b[4 + k]];
+            const DualQuat *d2 = &palette[b[8 + k]];
+            const DualQuat *d3 = &palette[b[12 + k]];
+
+            __m128 qi, qj, qk, qw, ei, ej, ek, ew;
+            loadQuatx4Internal(&d0->real, &d1->real, &d2->real, &d3->real, &qi, &qj, &qk, &qw);
+            loadQuatx4Internal(&d0->dual, &d1->dual, &d2->dual, &d3->dual, &ei, &ej, &ek, &ew);
+
+            if(k == 0)
+            {
+                refI = qi;
+                refJ = qj;
+                refK = qk;
+                refW = qw;
+            }
+
+            __m128 dot = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(qi, refI), _mm_mul_ps(qj, refJ)), _mm_mul_ps(qk, refK)), _mm_mul_ps(qw, refW));
+            __m128 wk = _mm_xor_ps(w[k], _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), signBit));
+
+            ri = _mm_add_ps(ri, _mm_mul_ps(qi, wk));
+            rj = _mm_add_ps(rj, _mm_mul_ps(qj, wk));
+            rk = _mm_add_ps(rk, _mm_mul_ps(qk, wk));
+            rw = _mm_add_ps(rw, _mm_mul_ps(qw, wk));
+            di = _mm_add_ps(di, _mm_mul_ps(ei, wk));
+            dj = _mm_add_ps(dj, _mm_mul_ps(ej, wk));
+            dk = _mm_add_ps(dk, _mm_mul_ps(ek, wk));
+            dw = _mm_add_ps(dw, _mm_mul_ps(ew, wk));
+        }
+
+        __m128 len = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ri, ri), _mm_mul_ps(rj, rj)), _mm_mul_ps(rk, rk)), _mm_mul_ps(rw, rw));
+        __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(len));
+
+        ri = _mm_mul_ps(ri, inv);
+        rj = _mm_mul_ps(rj, inv);
+        rk = _mm_mul_ps(rk, inv);
+        rw = _mm_mul_ps(rw, inv);
+        di = _mm_mul_ps(di, inv);
+        dj = _mm_mul_ps(dj, inv);
+        dk = _mm_mul_ps(dk, inv);
+        dw = _mm_mul_ps(dw, inv);
+
+        __m128 x, y, z;
+        m3dLoadVec3x4Internal(&v[n].x, &x, &y, &z);
+
+        // m3dQuatRotateVec3Ptr
+        __m128 tx = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(rj, z), _mm_mul_ps(rk, y)), two);
+        __m128 ty = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(rk, x), _mm_mul_ps(ri, z)), two);
+        __m128 tz = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(ri, y), _mm_mul_ps(rj, x)), two);
+
+        x = _mm_add_ps(_mm_add_ps(x, _mm_mul_ps(rw, tx)), _mm_sub_ps(_mm_mul_ps(rj, tz), _mm_mul_ps(rk, ty)));
+        y = _mm_add_ps(_mm_add_ps(y, _mm_mul_ps(rw, ty)), _mm_sub_ps(_mm_mul_ps(rk, tx), _mm_mul_ps(ri, tz)));
+        z = _mm_add_ps(_mm_add_ps(z, _mm_mul_ps(rw, tz)), _mm_sub_ps(_mm_mul_ps(ri, ty), _mm_mul_ps(rj, tx)));
+
+        if(point)
+        {
+            // translationInternal
+            __m128 px = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(rw, di), _mm_mul_ps(dw, ri)), _mm_sub_ps(_mm_mul_ps(rj, dk), _mm_mul_ps(rk, dj)));
+            __m128 py = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(rw, dj), _mm_mul_ps(dw, rj)), _mm_sub_ps(_mm_mul_ps(rk, di), _mm_mul_ps(ri, dk)));
+            __m128 pz = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(rw, dk), _mm_mul_ps(dw, rk)), _mm_sub_ps(_mm_mul_ps(ri, dj), _mm_mul_ps(rj, di)));
+
+            x = _mm_add_ps(x, _mm_mul_ps(px, two));
+            y = _mm_add_ps(y, _mm_mul_ps(py, two));
+            z = _mm_add_ps(z, _mm_mul_ps(pz, two));
+        }
+
+        m3dStoreVec3x4Internal(&res[n].x, x, y, z, 0);
+    }
+
+    return n;
+}
+
+#endif // M3D_SSE2
+
+static void skinRangeInternal(Vec3 *res, const Vec3 *v, const uint16_t *bones, const M3dValue *weights,
+                              const DualQuat *palette, size_t begin, size_t end, char point)
+{
+    size_t n = begin;
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    n = skinSse2(res, v, bones, weights, palette, begin, end, point);
+#endif
+
+    skinScalar(res, v, bones, weights, palette, n, end, point);
+}
+
+M3D_API void m3dDualQuatSkinVec3Array(Vec3 *res, const Vec3 *v, const uint16_t *bones, const M3dValue *weights,
+                                      const DualQuat *palette, size_t count, unsigned int flags)
+{
+    M3D_PROFILE_FUNCTION();
+    char point = !(flags & M3D_TRANSFORM_DIRECTION);
+
+    M3D_PARALLEL_BLOCKS(begin, end, 0, count, M3D_SKIN_PARALLEL_MIN, skinRangeInternal(res, v, bones, weights, palette, begin, end, point));
+}
+
+#endif // M3D_FIXED
@@ -0,0 +1,149 @@
+#include "m3d/m3d.h"
+#include "internal.h"
+#include <stdint.h>
+
+#ifndef M3D_FIXED
+
+/** Every export moves whole rows through one register, converted to float on the way in
+    double builds, and the column major form transposes them in registers before the store.
+    Streaming stores need res on a 16 byte boundary, every row of the output then is */
+
+#ifdef M3D_SSE2
+
+static inline __m128 loadRowInternal(const M3dValue *row)
+{
+#ifdef M3D_DOUBLE
+    return _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(row)), _mm_cvtpd_ps(_mm_loadu_pd(row + 2)));
+#else
+    return _mm_loadu_ps(row);
+#endif // M3D_DOUBLE
+}
+
+static inline void storeRowInternal(float *res, __m128 r, int stream)
+{
+    if(stream)
+    {
+        _mm_stream_ps(res, r);
+    }
+    else
+    {
+        _mm_storeu_ps(res, r);
+    }
+}
+
+static inline int streamInternal(const float *res, unsigned int flags)
+{
+    return (flags & M3D_TRANSFORM_STREAM) && ((uintptr_t)res & 15) == 0;
+}
+
+#endif // M3D_SSE2
+
+M3D_API void m3dMat4x4TransposeArray(Mat4x4 *M3D_RESTRICT res, const Mat4x4 *m, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    for(size_t n = 0; n < count; n++)
+    {
+        m3dMat4x4TransposePtr(&res[n], &m[n]);
+    }
+}
+
+M3D_API void m3dMat4x4ExportRowMajor(float *M3D_RESTRICT res, const Mat4x4 *m, size_t count, unsigned int flags)
+{
+    M3D_PROFILE_FUNCTION();
+#ifdef M3D_SSE2
+    int stream = streamInternal(res, flags);
+
+    for(size_t n = 0; n < count; n++)
+    {
+        storeRowInternal(res + 16 * n, loadRowInternal(m[n].m[0]), stream);
+        storeRowInternal(res + 16 * n + 4, loadRowInternal(m[n].m[1]), stream);
+        storeRowInternal(res + 16 * n + 8, loadRowInternal(m[n].m[2]), stream);
+        storeRowInternal(res + 16 * n + 12, loadRowInternal(m[n].m[3]), stream);
+    }
+
+    if(stream)
+    {
+        _mm_sfence();
+    }
+#else
+    (void)flags;
+
+    for(size_t n = 0; n < count; n++)
+    {
+        for(int i = 0; i < 16; i++)
+        {
+            res[16 * n + (size_t)i] = (float)m[n].m[i / 4][i % 4];
+        }
+    }
+#endif // M3D_SSE2
+}
+
+M3D_API void m3dMat4x4ExportColumnMajor(float *M3D_RESTRICT res, const Mat4x4 *m, size_t count, unsigned int flags)
+{
+    M3D_PROFILE_FUNCTION();
+#ifdef M3D_SSE2
+    int stream = streamInternal(res, flags);
+
+    for(size_t n = 0; n < count; n++)
+    {
+        __m128 c0 = loadRowInternal(m[n].m[0]);
+        __m128 c1 = loadRowInternal(m[n].m[1]);
+        __m128 c2 = loadRowInternal(m[n].m[2]);
+        __m128 c3 = loadRowInternal(m[n].m[3]);
+
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+        storeRowInternal(res + 16 * n, c0, stream);
+        storeRowInternal(res + 16 * n + 4, c1, stream);
+        storeRowInternal(res + 16 * n + 8, c2, stream);
+        storeRowInternal(res + 16 * n + 12, c3, stream);
+    }
+
+    if(stream)
+    {
+        _mm_sfence();
+    }
+#else
+    (void)flags;
+
+    for(size_t n = 0; n < count; n++)
+    {
+        for(int i = 0; i < 16; i++)
+        {
+            res[16 * n + (size_t)i] = (float)m[n].m[i % 4][i / 4];
+        }
+    }
+#endif // M3D_SSE2
+}
+
+M3D_API void m3dMat4x4ExportRows3x4(float *M3D_RESTRICT res, const Mat4x4 *m, size_t count, unsigned int flags)
+{
+    M3D_PROFILE_FUNCTION();
+#ifdef M3D_SSE2
+    int stream = streamInternal(res, flags);
+
+    for(size_t n = 0; n < count; n++)
+    {
+        storeRowInternal(res + 12 * n, loadRowInternal(m[n].m[0]), stream);
+        storeRowInternal(res + 12 * n + 4, loadRowInternal(m[n].m[1]), stream);
+        storeRowInternal(res + 12 * n + 8, loadRowInternal(m[n].m[2]), stream);
+    }
+
+    if(stream)
+    {
+        _mm_sfence();
+    }
+#else
+    (void)flags;
+
+    for(size_t n = 0; n < count; n++)
+    {
+        for(int i = 0; i < 12; i++)
+        {
+            res[12 * n + (size_t)i] = (float)m[n].m[i / 4][i % 4];
+        }
+    }
+#endif // M3D_SSE2
+}
+
+#endif // M3D_FIXED
@@ -0,0 +1,434 @@
+#include "m3d/m3d.h"
+#include "internal.h"
+
+#ifndef M3D_FIXED
+
+// objects per mask word, the kernels always work on whole words
+#define CULL_WORD 32
+// objects the index forms cull at once before writing out the indices
+#define CULL_BLOCK 256
+
+static Plane planeFromRowsInternal(const Mat4x4 *m, int row, M3dValue sign)
+{
+    Plane res;
+    res.n.x = m->m[3][0] + sign * m->m[row][0];
+    res.n.y = m->m[3][1] + sign * m->m[row][1];
+    res.n.z = m->m[3][2] + sign * m->m[row][2];
+    res.d = m->m[3][3] + sign * m->m[row][3];
+
+    M3dValue inv = 1 / m3dSqrtInternal(res.n.x * res.n.x + res.n.y * res.n.y + res.n.z * res.n.z);
+    res.n.x *= inv;
+    res.n.y *= inv;
+    res.n.z *= inv;
+    res.d *= inv;
+
+    return res;
+}
+
+// -w <= x, y, z <= w in clip space, so every plane is row 3 plus or minus another row
+M3D_API Frustum m3dFrustumFromMat4x4(Mat4x4 m)
+{
+    M3D_PROFILE_FUNCTION();
+    Frustum res;
+
+    res.p[M3D_FRUSTUM_LEFT] = planeFromRowsInternal(&m, 0, 1);
+    res.p[M3D_FRUSTUM_RIGHT] = planeFromRowsInternal(&m, 0, -1);
+    res.p[M3D_FRUSTUM_BOTTOM] = planeFromRowsInternal(&m, 1, 1);
+    res.p[M3D_FRUSTUM_TOP] = planeFromRowsInternal(&m, 1, -1);
+    res.p[M3D_FRUSTUM_NEAR] = planeFromRowsInternal(&m, 2, 1);
+    res.p[M3D_FRUSTUM_FAR] = planeFromRowsInternal(&m, 2, -1);
+
+    return res;
+}
+
+/** ---------------- single objects, every kernel sums in this order so they agree exactly.
+    an object is kept only when every distance compares >= 0, like the simd cmpge,
+    so NaN positions or sizes are culled on every path */
+
+static inline char sphereVisibleInternal(const Frustum *f, M3dValue x, M3dValue y, M3dValue z, M3dValue r)
+{
+    for(int p = 0; p < 6; p++)
+    {
+        const Plane *pl = &f->p[p];
+
+        if(!(pl->n.x * x + pl->n.y * y + pl->n.z * z + pl->d + r >= 0))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static inline char aabbVisibleInternal(const Frustum *f, M3dValue x, M3dValue y, M3dValue z, M3dValue ex, M3dValue ey, M3dValue ez)
+{
+    for(int p = 0; p < 6; p++)
+    {
+        const Plane *pl = &f->p[p];
+        // the extents projected onto the normal, how far the box reaches towards the plane
+        M3dValue reach = (pl->n.x < 0 ? -pl->n.x : pl->n.x) * ex + (pl->n.y < 0 ? -pl->n.y : pl->n.y) * ey +
+                         (pl->n.z < 0 ? -pl->n.z : pl->n.z) * ez;
+
+        if(!(pl->n.x * x + pl->n.y * y + pl->n.z * z + pl->d + reach >= 0))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+M3D_API char m3dFrustumSphereVisible(Frustum f, Vec3 center, M3dValue radius)
+{
+    M3D_PROFILE_FUNCTION();
+    return sphereVisibleInternal(&f, center.x, center.y, center.z, radius);
+}
+
+M3D_API char m3dFrustumAabbVisible(Frustum f, Vec3 center, Vec3 extents)
+{
+    M3D_PROFILE_FUNCTION();
+    return aabbVisibleInternal(&f, center.x, center.y, center.z, extents.x, extents.y, extents.z);
+}
+
+/** ---------------- mask kernels, picked once by cpu features */
+
+static uint32_t cullSpheresWordScalar(const Frustum *f, Vec3Soa c, const M3dValue *r, size_t begin, size_t end)
+{
+    uint32_t word = 0;
+
+    for(size_t n = begin; n < end; n++)
+    {
+        word |= (uint32_t)sphereVisibleInternal(f, c.x[n], c.y[n], c.z[n], r[n]) << (n - begin);
+    }
+
+    return word;
+}
+
+static uint32_t cullAabbsWordScalar(const Frustum *f, Vec3Soa c, Vec3Soa e, size_t begin, size_t end)
+{
+    uint32_t word = 0;
+
+    for(size_t n = begin; n < end; n++)
+    {
+        word |= (uint32_t)aabbVisibleInternal(f, c.x[n], c.y[n], c.z[n], e.x[n], e.y[n], e.z[n]) << (n - begin);
+    }
+
+    return word;
+}
+
+static void cullSpheresScalar(uint32_t *mask, const Frustum *f, Vec3Soa c, const M3dValue *r)
+{
+    for(size_t w = 0; w * CULL_WORD < c.count; w++)
+    {
+        size_t begin = w * CULL_WORD;
+        size_t end = begin + CULL_WORD < c.count ? begin + CULL_WORD : c.count;
+
+        mask[w] = cullSpheresWordScalar(f, c, r, begin, end);
+    }
+}
+
+static void cullAabbsScalar(uint32_t *mask, const Frustum *f, Vec3Soa c, Vec3Soa e)
+{
+    for(size_t w = 0; w * CULL_WORD < c.count; w++)
+    {
+        size_t begin = w * CULL_WORD;
+        size_t end = begin + CULL_WORD < c.count ? begin + CULL_WORD : c.count;
+
+        mask[w] = cullAabbsWordScalar(f, c, e, begin, end);
+    }
+}
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+
+// 4 objects per step against all 6 planes, the lanes that fail any plane drop out of the movemask
+static void cullSpheresSse2(uint32_t *mask, const Frustum *f, Vec3Soa c, const M3dValue *r)
+{
+    size_t full = c.count / CULL_WORD;
+    const __m128 zero = _mm_setzero_ps();
+
+    for(size_t w = 0; w < full; w++)
+    {
+        uint32_t word = 0;
+
+        for(size_t o = 0; o < CULL_WORD; o += 4)
+        {
+            size_t n = w * CULL_WORD + o;
+            __m128 x = _mm_loadu_ps(c.x + n);
+            __m128 y = _mm_loadu_ps(c.y + n);
+            __m128 z = _mm_loadu_ps(c.z + n);
+            __m128 rad = _mm_loadu_ps(r + n);
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+            for(int p = 0; p < 6; p++)
+            {
+                const Plane *pl = &f->p[p];
+                __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(pl->n.x), x), _mm_mul_ps(_mm_set1_ps(pl->n.y), y)),
+                                         _mm_mul_ps(_mm_set1_ps(pl->n.z), z));
+                dist = _mm_add_ps(_mm_add_ps(dist, _mm_set1_ps(pl->d)), rad);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, zero));
+            }
+
+            word |= (uint32_t)_mm_movemask_ps(inside) << o;
+        }
+
+        mask[w] = word;
+    }
+
+    if(full * CULL_WORD < c.count)
+    {
+        mask[full] = cullSpheresWordScalar(f, c, r, full * CULL_WORD, c.count);
+    }
+}
+
+static void cullAabbsSse2(uint32_t *mask, const Frustum *f, Vec3Soa c, Vec3Soa e)
+{
+    size_t full = c.count / CULL_WORD;
+    const __m128 zero = _mm_setzero_ps();
+
+    for(size_t w = 0; w < full; w++)
+    {
+        uint32_t word = 0;
+
+        for(size_t o = 0; o < CULL_WORD; o += 4)
+        {
+            size_t n = w * CULL_WORD + o;
+            __m128 x = _mm_loadu_ps(c.x + n);
+            __m128 y = _mm_loadu_ps(c.y + n);
+            __m128 z = _mm_loadu_ps(c.z + n);
+            __m128 ex = _mm_loadu_ps(e.x + n);
+            __m128 ey = _mm_loadu_ps(e.y + n);
+            __m128 ez = _mm_loadu_ps(e.z + n);
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+            for(int p = 0; p < 6; p++)
+            {
+                const Plane *pl = &f->p[p];
+                __m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(pl->n.x < 0 ? -pl->n.x : pl->n.x), ex),
+                                                     _mm_mul_ps(_mm_set1_ps(pl->n.y < 0 ? -pl->n.y : pl->n.y), ey)),
+                                          _mm_mul_ps(_mm_set1_ps(pl->n.z < 0 ? -pl->n.z : pl->n.z), ez));
+                __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(pl->n.x), x), _mm_mul_ps(_mm_set1_ps(pl->n.y), y)),
+                                         _mm_mul_ps(_mm_set1_ps(pl->n.z), z));
+                dist = _mm_add_ps(_mm_add_ps(dist, _mm_set1_ps(pl->d)), reach);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, zero));
+            }
+
+            word |= (uint32_t)_mm_movemask_ps(inside) << o;
+        }
+
+        mask[w] = word;
+    }
+
+    if(full * CULL_WORD < c.count)
+    {
+        mask[full] = cullAabbsWordScalar(f, c, e, full * CULL_WORD, c.count);
+    }
+}
+
+#ifdef M3D_X86_DISPATCH
+
+// the sse2 kernels with 8 objects per step
+M3D_TARGET_AVX static void cullSpheresAvx(uint32_t *mask, const Frustum *f, Vec3Soa c, const M3dValue *r)
+{
+    size_t full = c.count / CULL_WORD;
+    const __m256 zero = _mm256_setzero_ps();
+
+    for(size_t w = 0; w < full; w++)
+    {
+        uint32_t word = 0;
+
+        for(size_t o = 0; o < CULL_WORD; o += 8)
+        {
+            size_t n = w * CULL_WORD + o;
+            __m256 x = _mm256_loadu_ps(c.x + n);
+            __m256 y = _mm256_loadu_ps(c.y + n);
+            __m256 z = _mm256_loadu_ps(c.z + n);
+            __m256 rad = _mm256_loadu_ps(r + n);
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+            for(int p = 0; p < 6; p++)
+            {
+                const Plane *pl = &f->p[p];
+                __m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(pl->n.x), x), _mm256_mul_ps(_mm256_set1_ps(pl->n.y), y)),
+                                            _mm256_mul_ps(_mm256_set1_ps(pl->n.z), z));
+                dist = _mm256_add_ps(_mm256_add_ps(dist, _mm256_set1_ps(pl->d)), rad);
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, zero, _CMP_GE_OQ));
+            }
+
+            word |= (uint32_t)_mm256_movemask_ps(inside) << o;
+        }
+
+        mask[w] = word;
+    }
+
+    if(full * CULL_WORD < c.count)
+    {
+        mask[full] = cullSpheresWordScalar(f, c, r, full * CULL_WORD, c.count);
+    }
+}
+
+M3D_TARGET_AVX static void cullAabbsAvx(uint32_t *mask, const Frustum *f, Vec3Soa c, Vec3Soa e)
+{
+    size_t full = c.count / CULL_WORD;
+    const __m256 zero = _mm256_setzero_ps();
+
+    for(size_t w = 0; w < full; w++)
+    {
+        uint32_t word = 0;
+
+        for(size_t o = 0; o < CULL_WORD; o += 8)
+        {
+            size_t n = w * CULL_WORD + o;
+            __m256 x = _mm256_loadu_ps(c.x + n);
+            __m256 y = _mm256_loadu_ps(c.y + n);
+            __m256 z = _mm256_loadu_ps(c.z + n);
+            __m256 ex = _mm256_loadu_ps(e.x + n);
+            __m256 ey = _mm256_loadu_ps(e.y + n);
+            __m256 ez = _mm256_loadu_ps(e.z + n);
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+            for(int p = 0; p < 6; p++)
+            {
+                const Plane *pl = &f->p[p];
+                __m256 reach = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(pl->n.x < 0 ? -pl->n.x : pl->n.x), ex),
+                                                           _mm256_mul_ps(_mm256_set1_ps(pl->n.y < 0 ? -pl->n.y : pl->n.y), ey)),
+                                             _mm256_mul_ps(_mm256_set1_ps(pl->n.z < 0 ? -pl->n.z : pl->n.z), ez));
+                __m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(pl->n.x), x), _mm256_mul_ps(_mm256_set1_ps(pl->n.y), y)),
+                                            _mm256_mul_ps(_mm256_set1_ps(pl->n.z), z));
+                dist = _mm256_add_ps(_mm256_add_ps(dist, _mm256_set1_ps(pl->d)), reach);
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, zero, _CMP_GE_OQ));
+            }
+
+            word |= (uint32_t)_mm256_movemask_ps(inside) << o;
+        }
+
+        mask[w] = word;
+    }
+
+    if(full * CULL_WORD < c.count)
+    {
+        mask[full] = cullAabbsWordScalar(f, c, e, full * CULL_WORD, c.count);
+    }
+}
+
+#endif // M3D_X86_DISPATCH
+
+#endif // M3D_SSE2
+
+static void cullSpheresResolve(uint32_t *mask, const Frustum *f, Vec3Soa c, const M3dValue *r);
+static void cullAabbsResolve(uint32_t *mask, const Frustum *f, Vec3Soa c, Vec3Soa e);
+
+static void (*cullSpheresInternal)(uint32_t *mask, const Frustum *f, Vec3Soa c, const M3dValue *r) = cullSpheresResolve;
+static void (*cullAabbsInternal)(uint32_t *mask, const Frustum *f, Vec3Soa c, Vec3Soa e) = cullAabbsResolve;
+
+static void cullSpheresResolve(uint32_t *mask, const Frustum *f, Vec3Soa c, const M3dValue *r)
+{
+    unsigned int cpu = m3dCpuFeatures();
+
+    void (*kernel)(uint32_t *mask, const Frustum *f, Vec3Soa c, const M3dValue *r) = cullSpheresScalar;
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    if(cpu & M3D_CPU_SSE2) kernel = cullSpheresSse2;
+#endif
+#if defined(M3D_X86_DISPATCH) && !defined(M3D_DOUBLE)
+    if(cpu & M3D_CPU_AVX) kernel = cullSpheresAvx;
+#endif
+    (void)cpu;
+
+    M3D_STORE_RELAXED(cullSpheresInternal, kernel);
+    kernel(mask, f, c, r);
+}
+
+static void cullAabbsResolve(uint32_t *mask, const Frustum *f, Vec3Soa c, Vec3Soa e)
+{
+    unsigned int cpu = m3dCpuFeatures();
+
+    void (*kernel)(uint32_t *mask, const Frustum *f, Vec3Soa c, Vec3Soa e) = cullAabbsScalar;
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    if(cpu & M3D_CPU_SSE2) kernel = cullAabbsSse2;
+#endif
+#if defined(M3D_X86_DISPATCH) && !defined(M3D_DOUBLE)
+    if(cpu & M3D_CPU_AVX) kernel = cullAabbsAvx;
+#endif
+    (void)cpu;
+
+    M3D_STORE_RELAXED(cullAabbsInternal, kernel);
+    kernel(mask, f, c, e);
+}
+
+/** ---------------- batch culling */
+
+// appends begin + the position of every set bit of the mask words
+static size_t maskToIndicesInternal(uint32_t *res, const uint32_t *mask, size_t words, size_t begin)
+{
+    size_t count = 0;
+
+    for(size_t w = 0; w < words; w++)
+    {
+        uint32_t word = mask[w];
+
+        while(word)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            unsigned int bit = (unsigned int)__builtin_ctz(word);
+#else
+            unsigned int bit = 0;
+            while(!(word & (1u << bit))) bit++;
+#endif
+
+            res[count++] = (uint32_t)(begin + w * CULL_WORD + bit);
+            word &= word - 1;
+        }
+    }
+
+    return count;
+}
+
+M3D_API void m3dFrustumCullSpheres(uint32_t *M3D_RESTRICT mask, Frustum f, Vec3Soa centers, const M3dValue *radius)
+{
+    M3D_PROFILE_FUNCTION();
+    M3D_LOAD_RELAXED(cullSpheresInternal)(mask, &f, centers, radius);
+}
+
+M3D_API void m3dFrustumCullAabbs(uint32_t *M3D_RESTRICT mask, Frustum f, Vec3Soa centers, Vec3Soa extents)
+{
+    M3D_PROFILE_FUNCTION();
+    M3D_LOAD_RELAXED(cullAabbsInternal)(mask, &f, centers, extents);
+}
+
+M3D_API size_t m3dFrustumCullSpheresIndices(uint32_t *M3D_RESTRICT res, Frustum f, Vec3Soa centers, const M3dValue *radius)
+{
+    M3D_PROFILE_FUNCTION();
+    uint32_t mask[CULL_BLOCK / CULL_WORD];
+    size_t count = 0;
+
+    for(size_t begin = 0; begin < centers.count; begin += CULL_BLOCK)
+    {
+        size_t size = centers.count - begin < CULL_BLOCK ? centers.count - begin : CULL_BLOCK;
+        Vec3Soa block = {centers.x + begin, centers.y + begin, centers.z + begin, size};
+
+        M3D_LOAD_RELAXED(cullSpheresInternal)(mask, &f, block, radius + begin);
+        count += maskToIndicesInternal(res + count, mask, (size + CULL_WORD - 1) / CULL_WORD, begin);
+    }
+
+    return count;
+}
+
+M3D_API size_t m3dFrustumCullAabbsIndices(uint32_t *M3D_RESTRICT res, Frustum f, Vec3Soa centers, Vec3Soa extents)
+{
+    M3D_PROFILE_FUNCTION();
+    uint32_t mask[CULL_BLOCK / CULL_WORD];
+    size_t count = 0;
+
+    for(size_t begin = 0; begin < centers.count; begin += CULL_BLOCK)
+    {
+        size_t size = centers.count - begin < CULL_BLOCK ? centers.count - begin : CULL_BLOCK;
+        Vec3Soa block = {centers.x + begin, centers.y + begin, centers.z + begin, size};
+        Vec3Soa blockExtents = {extents.x + begin, extents.y + begin, extents.z + begin, size};
+
+        M3D_LOAD_RELAXED(cullAabbsInternal)(mask, &f, block, blockExtents);
+        count += maskToIndicesInternal(res + count, mask, (size + CULL_WORD - 1) / CULL_WORD, begin);
+    }
+
+    return count;
+}
+
+#endif // M3D_FIXED
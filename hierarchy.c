@@ -0,0 +1,97 @@
+#include "m3d/m3d.h"
+#include "internal.h"
+
+#ifndef M3D_FIXED
+
+// nodes per thread block of a level, each node costs a TRS build and a multiply
+#define HIERARCHY_PARALLEL_MIN 1024
+
+M3D_API size_t m3dHierarchyBuildLevels(M3dHierarchy *h)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t level = 0;
+    size_t levelStart = 0;
+    size_t prevStart = 0;
+
+    h->levelCount = 0;
+    h->levelStart[0] = 0;
+
+    for(size_t n = 0; n < h->count; n++)
+    {
+        size_t parent = h->parent[n];
+
+        if(parent == M3D_HIERARCHY_NO_PARENT)
+        {
+            // roots all have to be in the first level
+            if(level > 0)
+            {
+                return 0;
+            }
+
+            continue;
+        }
+
+        if(parent >= n)
+        {
+            return 0;
+        }
+
+        // the first child of a node in the current level starts the next one
+        if(parent >= levelStart)
+        {
+            prevStart = levelStart;
+            levelStart = n;
+            h->levelStart[++level] = n;
+        }
+
+        if(parent < prevStart)
+        {
+            return 0;
+        }
+    }
+
+    if(h->count > 0)
+    {
+        h->levelCount = level + 1;
+        h->levelStart[level + 1] = h->count;
+    }
+
+    return h->levelCount;
+}
+
+M3D_API void m3dHierarchyUpdateRange(M3dHierarchy h, size_t begin, size_t end)
+{
+    M3D_PROFILE_FUNCTION();
+    for(size_t n = begin; n < end; n++)
+    {
+        size_t parent = h.parent[n];
+
+        if(parent == M3D_HIERARCHY_NO_PARENT)
+        {
+            m3dMat4x4FromTrsPtr(&h.world[n], &h.position[n], &h.rotation[n], &h.scale[n]);
+        }
+        else
+        {
+            Mat4x4 local;
+            m3dMat4x4FromTrsPtr(&local, &h.position[n], &h.rotation[n], &h.scale[n]);
+            m3dMat4x4MulMat4x4Ptr(&h.world[n], &h.world[parent], &local);
+        }
+    }
+}
+
+M3D_API void m3dHierarchyUpdate(M3dHierarchy h)
+{
+    M3D_PROFILE_FUNCTION();
+    for(size_t l = 0; l < h.levelCount; l++)
+    {
+        size_t begin = h.levelStart[l];
+        size_t end = h.levelStart[l + 1];
+
+        // every node of a level only reads the finished level above it,
+        // so the nodes can be split between threads in any way
+        M3D_PARALLEL_BLOCKS(blockBegin, blockEnd, begin, end, HIERARCHY_PARALLEL_MIN,
+                            m3dHierarchyUpdateRange(h, blockBegin, blockEnd));
+    }
+}
+
+#endif // M3D_FIXED
@@ -0,0 +1,794 @@
+#ifndef M3D_INTERNAL_H
+#define M3D_INTERNAL_H
+
+/** helpers shared between the library sources, not part of the public api */
+
+#include "m3d/m3d.h"
+#include <math.h>
+
+/** single precision builds should not round trip through double */
+#ifdef M3D_DOUBLE
+#define m3dLibSqrtInternal sqrt
+#define m3dLibSinInternal sin
+#define m3dLibCosInternal cos
+#define m3dLibTanInternal tan
+#define m3dLibAcosInternal acos
+#define m3dLibAsinInternal asin
+#define m3dLibAtan2Internal atan2
+#else
+#define m3dLibSqrtInternal sqrtf
+#define m3dLibSinInternal sinf
+#define m3dLibCosInternal cosf
+#define m3dLibTanInternal tanf
+#define m3dLibAcosInternal acosf
+#define m3dLibAsinInternal asinf
+#define m3dLibAtan2Internal atan2f
+#endif // M3D_DOUBLE
+
+static inline M3dValue m3dMinInternal(M3dValue a, M3dValue b)
+{
+    return b < a ? b : a;
+}
+
+static inline M3dValue m3dMaxInternal(M3dValue a, M3dValue b)
+{
+    return b > a ? b : a;
+}
+
+/** the end of the whole groups of width items in [begin, end), where the simd loops stop and
+    their scalar tails go on. A loop bound of n + width <= end could wrap, then the compiler
+    can't tell the tail starts inside the range and warns about it once the library is inlined */
+static inline size_t m3dGroupEndInternal(size_t begin, size_t end, size_t width)
+{
+    return begin + ((end - begin) & ~(width - 1));
+}
+
+/** sse2 is part of every x86-64 target, define M3D_NO_SIMD to build the plain c paths only.
+    fixed point builds always take the plain c paths */
+#if !defined(M3D_NO_SIMD) && !defined(M3D_FIXED) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define M3D_SSE2
+#include <emmintrin.h>
+#endif
+
+/** wider paths are compiled with per function target attributes and picked
+    at runtime from m3dCpuFeatures, so the library still runs on plain sse2 */
+#if defined(M3D_SSE2) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#define M3D_X86_DISPATCH
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define M3D_TARGET_AVX __attribute__((target("avx")))
+#define M3D_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define M3D_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define M3D_TARGET_AVX
+#define M3D_TARGET_AVX2
+#define M3D_TARGET_AVX512
+#endif
+#endif
+
+/** the kernel pointers and the cpu features are resolved on first use, from whichever threads
+    call in. resolution is idempotent, every thread stores the same value, so relaxed atomic
+    loads and stores are enough. compilers without the atomic builtins use plain accesses,
+    the race is then benign on the x86 targets that dispatch, where aligned pointer and int
+    accesses are single instructions */
+#if defined(__GNUC__) || defined(__clang__)
+#define M3D_LOAD_RELAXED(v) __atomic_load_n(&(v), __ATOMIC_RELAXED)
+#define M3D_STORE_RELAXED(v, x) __atomic_store_n(&(v), (x), __ATOMIC_RELAXED)
+#else
+#define M3D_LOAD_RELAXED(v) (v)
+#define M3D_STORE_RELAXED(v, x) ((v) = (x))
+#endif
+
+/** ---------------- fast math
+
+    approximations used for M3D_FAST_MATH, their errors are listed in m3d.h */
+
+#if defined(M3D_FAST_MATH) && !defined(M3D_FIXED)
+
+static inline M3dValue m3dFastSqrtInternal(M3dValue x)
+{
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    return _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(x)));
+#elif defined(M3D_SSE2)
+    return _mm_cvtsd_f64(_mm_sqrt_sd(_mm_setzero_pd(), _mm_set_sd(x)));
+#else
+    return m3dLibSqrtInternal(x);
+#endif
+}
+
+// rsqrtss only covers the float range, so double builds divide by sqrtsd instead
+// of seeding from a float, which fails for values like 1e-60 or 1e60
+static inline M3dValue m3dFastRsqrtInternal(M3dValue x)
+{
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    const M3dValue half = 0.5f;
+    const M3dValue threeHalves = 1.5f;
+    M3dValue y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+
+    return y * (threeHalves - half * x * y * y);
+#else
+    return 1 / m3dFastSqrtInternal(x);
+#endif
+}
+
+// x = k * pi / 2 + r with |r| <= pi / 4, pi / 2 split in two so k * pi / 2 is exact for small k.
+// only holds for |x| < M3D_FAST_TRIG_MAX, sin and cos take libm beyond it
+#define M3D_FAST_TRIG_MAX 8192
+
+static inline M3dValue m3dFastReduceInternal(M3dValue x, int *k)
+{
+    M3dValue q = x * (M3dValue)0.63661977236758134;
+    int n = (int)(q + (q < 0 ? (M3dValue)-0.5 : (M3dValue)0.5));
+
+    *k = n;
+    return (x - (M3dValue)n * (M3dValue)1.5703125) - (M3dValue)n * (M3dValue)4.8382679489661923e-4;
+}
+
+static inline M3dValue m3dFastSinPolyInternal(M3dValue r)
+{
+    M3dValue z = r * r;
+    return r + r * z * ((M3dValue)-1.6666654611e-1 + z * ((M3dValue)8.3321608736e-3 + z * (M3dValue)-1.9515295891e-4));
+}
+
+static inline M3dValue m3dFastCosPolyInternal(M3dValue r)
+{
+    M3dValue z = r * r;
+    return 1 - (M3dValue)0.5 * z + z * z * ((M3dValue)4.166664568298827e-2 + z * ((M3dValue)-1.388731625493765e-3 + z * (M3dValue)2.443315711809948e-5));
+}
+
+static inline M3dValue m3dFastSinInternal(M3dValue x)
+{
+    if(!(x > -M3D_FAST_TRIG_MAX && x < M3D_FAST_TRIG_MAX))
+    {
+        return m3dLibSinInternal(x);
+    }
+
+    int k;
+    M3dValue r = m3dFastReduceInternal(x, &k);
+    M3dValue res = (k & 1) ? m3dFastCosPolyInternal(r) : m3dFastSinPolyInternal(r);
+
+    return (k & 2) ? -res : res;
+}
+
+static inline M3dValue m3dFastCosInternal(M3dValue x)
+{
+    if(!(x > -M3D_FAST_TRIG_MAX && x < M3D_FAST_TRIG_MAX))
+    {
+        return m3dLibCosInternal(x);
+    }
+
+    int k;
+    M3dValue r = m3dFastReduceInternal(x, &k);
+    M3dValue res = (k & 1) ? m3dFastSinPolyInternal(r) : m3dFastCosPolyInternal(r);
+
+    return ((k + 1) & 2) ? -res : res;
+}
+
+static inline M3dValue m3dFastTanInternal(M3dValue x)
+{
+    return m3dFastSinInternal(x) / m3dFastCosInternal(x);
+}
+
+// abramowitz and stegun 4.4.46, acos(x) = sqrt(1 - x) * p(x) on [0, 1]
+static inline M3dValue m3dFastAcosInternal(M3dValue x)
+{
+    M3dValue a = x < 0 ? -x : x;
+    M3dValue p = (M3dValue)-0.0012624911;
+    p = p * a + (M3dValue)0.0066700901;
+    p = p * a + (M3dValue)-0.0170881256;
+    p = p * a + (M3dValue)0.0308918810;
+    p = p * a + (M3dValue)-0.0501743046;
+    p = p * a + (M3dValue)0.0889789874;
+    p = p * a + (M3dValue)-0.2145988016;
+    p = p * a + (M3dValue)1.5707963050;
+    p *= m3dFastSqrtInternal(1 - a);
+
+    return x < 0 ? (M3dValue)3.14159265358979323 - p : p;
+}
+
+static inline M3dValue m3dFastAsinInternal(M3dValue x)
+{
+    return (M3dValue)1.57079632679489662 - m3dFastAcosInternal(x);
+}
+
+// abramowitz and stegun 4.4.49 for atan on [0, 1], the octant is put back afterwards
+static inline M3dValue m3dFastAtan2Internal(M3dValue y, M3dValue x)
+{
+    M3dValue ax = x < 0 ? -x : x;
+    M3dValue ay = y < 0 ? -y : y;
+    M3dValue hi = m3dMaxInternal(ax, ay);
+
+    if(hi == 0)
+    {
+        return 0;
+    }
+
+    M3dValue a = m3dMinInternal(ax, ay) / hi;
+    M3dValue z = a * a;
+    M3dValue p = (M3dValue)0.0028662257;
+    p = p * z + (M3dValue)-0.0161657367;
+    p = p * z + (M3dValue)0.0429096138;
+    p = p * z + (M3dValue)-0.0752896400;
+    p = p * z + (M3dValue)0.1065626393;
+    p = p * z + (M3dValue)-0.1420889944;
+    p = p * z + (M3dValue)0.1999355085;
+    p = p * z + (M3dValue)-0.3333314528;
+    M3dValue r = a + a * z * p;
+
+    if(ay > ax) r = (M3dValue)1.57079632679489662 - r;
+    if(x < 0) r = (M3dValue)3.14159265358979323 - r;
+
+    return y < 0 ? -r : r;
+}
+
+#define m3dSqrtInternal m3dFastSqrtInternal
+#define m3dRsqrtInternal m3dFastRsqrtInternal
+#define m3dSinInternal m3dFastSinInternal
+#define m3dCosInternal m3dFastCosInternal
+#define m3dTanInternal m3dFastTanInternal
+#define m3dAcosInternal m3dFastAcosInternal
+#define m3dAsinInternal m3dFastAsinInternal
+#define m3dAtan2Internal m3dFastAtan2Internal
+
+#elif !defined(M3D_FIXED)
+
+#define m3dSqrtInternal m3dLibSqrtInternal
+#define m3dRsqrtInternal(x) (1 / m3dLibSqrtInternal(x))
+#define m3dSinInternal m3dLibSinInternal
+#define m3dCosInternal m3dLibCosInternal
+#define m3dTanInternal m3dLibTanInternal
+#define m3dAcosInternal m3dLibAcosInternal
+#define m3dAsinInternal m3dLibAsinInternal
+#define m3dAtan2Internal m3dLibAtan2Internal
+
+#endif // M3D_FAST_MATH
+
+/** ---------------- fixed point
+
+    M3D_FIXED replaces the arithmetic a plain * or / can't do on Q format integers and the
+    libm calls. Products keep 64 bits until they are shifted back and round to nearest,
+    quotients round toward zero and saturate, so a division by 0 gives the largest value
+    of the sign of a. Everything is integer math so the results are the same on every
+    target, as long as >> of a negative value is arithmetic, which every supported
+    compiler does. The float builds expand the same macros to the plain operators */
+
+#ifdef M3D_FIXED
+
+#define m3dMulInternal(a, b) ((M3dValue)(((int64_t)(a) * (b) + ((int64_t)1 << (M3D_FIXED_FRACTION - 1))) >> M3D_FIXED_FRACTION))
+#define m3dDivInternal(a, b) m3dFixedDivInternal(a, b)
+
+static inline M3dValue m3dFixedDivInternal(M3dValue a, M3dValue b)
+{
+    if(b == 0)
+    {
+        return a < 0 ? INT32_MIN : INT32_MAX;
+    }
+
+    int64_t q = (int64_t)a * M3D_FIXED_ONE / b;
+
+    return q > INT32_MAX ? INT32_MAX : q < INT32_MIN ? INT32_MIN : (M3dValue)q;
+}
+
+// digit by digit square root of v rounded to nearest, so a Q format value shifted up by
+// the fraction or a product of two values lands back on the fraction
+static inline M3dValue m3dFixedSqrt64Internal(uint64_t v)
+{
+    uint64_t res = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while(bit > v)
+    {
+        bit >>= 2;
+    }
+
+    while(bit)
+    {
+        if(v >= res + bit)
+        {
+            v -= res + bit;
+            res = (res >> 1) + bit;
+        }
+        else
+        {
+            res >>= 1;
+        }
+
+        bit >>= 2;
+    }
+
+    // v is now what is left of the input over res * res, past res it is closer to res + 1
+    return (M3dValue)(v > res ? res + 1 : res);
+}
+
+static inline M3dValue m3dFixedSqrtInternal(M3dValue x)
+{
+    return x > 0 ? m3dFixedSqrt64Internal((uint64_t)x << M3D_FIXED_FRACTION) : 0;
+}
+
+static inline M3dValue m3dFixedRsqrtInternal(M3dValue x)
+{
+    return m3dFixedDivInternal(M3D_FIXED_ONE, m3dFixedSqrtInternal(x));
+}
+
+static inline int64_t m3dFixedMaxAbsInternal(const M3dValue *v, int count)
+{
+    int64_t res = 0;
+
+    for(int i = 0; i < count; i++)
+    {
+        int64_t a = v[i] < 0 ? -(int64_t)v[i] : v[i];
+        res = a > res ? a : res;
+    }
+
+    return res;
+}
+
+/** length of the count values of v. squaring in Q format would wrap past the root of the
+    range, so the squares are summed as plain 64 bit integers, whose root is the length in
+    the units of v again. components from 2^30 up are halved first so 4 squares still fit,
+    a length past the range saturates */
+static inline M3dValue m3dFixedLengthInternal(const M3dValue *v, int count)
+{
+    int shift = m3dFixedMaxAbsInternal(v, count) >= ((int64_t)1 << 30) ? 1 : 0;
+    uint64_t sum = 0;
+
+    for(int i = 0; i < count; i++)
+    {
+        int64_t c = v[i] / (1 << shift);
+        sum += (uint64_t)(c * c);
+    }
+
+    int64_t res = (int64_t)m3dFixedSqrt64Internal(sum) * (1 << shift);
+
+    return res > INT32_MAX ? INT32_MAX : (M3dValue)res;
+}
+
+/** scales the count values of v to unit length. the direction doesn't depend on the scale,
+    so v is first shifted until its largest component is between 2^29 and 2^30, which keeps
+    the bits of tiny vectors and the squares of large ones in range. a zero vector stays 0 */
+static inline void m3dFixedNormalizeInternal(M3dValue *v, int count)
+{
+    int64_t largest = m3dFixedMaxAbsInternal(v, count);
+    int up = 0;
+    int down = 0;
+
+    if(largest == 0)
+    {
+        return;
+    }
+
+    while((largest << up) < ((int64_t)1 << 29))
+    {
+        up++;
+    }
+
+    while((largest >> down) >= ((int64_t)1 << 30))
+    {
+        down++;
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        v[i] = (M3dValue)((int64_t)v[i] * ((int64_t)1 << up) / ((int64_t)1 << down));
+    }
+
+    int64_t length = m3dFixedLengthInternal(v, count);
+
+    for(int i = 0; i < count; i++)
+    {
+        v[i] = (M3dValue)((int64_t)v[i] * M3D_FIXED_ONE / length);
+    }
+}
+
+/** cordic on 2.30 values independent of the chosen fraction, with atan(2^-i) as the only table.
+    rotation turns (x, y) by z radians towards z = 0, vectoring turns it onto the x axis and
+    sums the angle into z. Either way x and y grow by 1.6468, which rotation cancels by
+    starting x at 1 / 1.6468 */
+static inline void m3dFixedCordicInternal(int64_t *x, int64_t *y, int64_t *z, int vectoring)
+{
+    static const int32_t atanTable[30] = {
+        843314857, 497837829, 263043837, 133525159, 67021687, 33543516, 16775851, 8388437,
+        4194283, 2097149, 1048576, 524288, 262144, 131072, 65536, 32768,
+        16384, 8192, 4096, 2048, 1024, 512, 256, 128, 64, 32, 16, 8, 4, 2
+    };
+
+    for(int i = 0; i < 30; i++)
+    {
+        int64_t xs = *x >> i;
+        int64_t ys = *y >> i;
+
+        if(vectoring ? *y < 0 : *z >= 0)
+        {
+            *x -= ys;
+            *y += xs;
+            *z -= atanTable[i];
+        }
+        else
+        {
+            *x += ys;
+            *y -= xs;
+            *z += atanTable[i];
+        }
+    }
+}
+
+// a 2.30 value rounded to the chosen fraction
+static inline M3dValue m3dFixedFromQ30Internal(int64_t v)
+{
+    return (M3dValue)((v + ((int64_t)1 << (29 - M3D_FIXED_FRACTION))) >> (30 - M3D_FIXED_FRACTION));
+}
+
+// x = k * pi / 2 + r with |r| <= pi / 4 in 32.32, then r is rotated from (1, 0)
+static inline void m3dFixedSinCosInternal(M3dValue x, M3dValue *s, M3dValue *c)
+{
+    const int64_t halfPi = 6746518852; // pi / 2 in 32.32
+    int64_t a = (int64_t)x * ((int64_t)1 << (32 - M3D_FIXED_FRACTION)) + halfPi / 2;
+    int64_t k = (a >= 0 ? a : a - halfPi + 1) / halfPi;
+    int64_t cr = 652032874; // 1 / 1.6468 in 2.30
+    int64_t sr = 0;
+    int64_t r = (a - halfPi / 2 - k * halfPi) >> 2;
+
+    m3dFixedCordicInternal(&cr, &sr, &r, 0);
+
+    M3dValue sv = m3dFixedFromQ30Internal(sr);
+    M3dValue cv = m3dFixedFromQ30Internal(cr);
+
+    switch(k & 3)
+    {
+        case 0: *s = sv; *c = cv; break;
+        case 1: *s = cv; *c = -sv; break;
+        case 2: *s = -sv; *c = -cv; break;
+        default: *s = -cv; *c = sv; break;
+    }
+}
+
+static inline M3dValue m3dFixedSinInternal(M3dValue x)
+{
+    M3dValue s, c;
+    m3dFixedSinCosInternal(x, &s, &c);
+    return s;
+}
+
+static inline M3dValue m3dFixedCosInternal(M3dValue x)
+{
+    M3dValue s, c;
+    m3dFixedSinCosInternal(x, &s, &c);
+    return c;
+}
+
+static inline M3dValue m3dFixedTanInternal(M3dValue x)
+{
+    M3dValue s, c;
+    m3dFixedSinCosInternal(x, &s, &c);
+    return m3dFixedDivInternal(s, c);
+}
+
+// the left half plane is mirrored into the right one first, as cordic only converges
+// for angles up to 1.74 radians. x and y are scaled up so all 30 steps keep their bits
+static inline M3dValue m3dFixedAtan2Internal(M3dValue y, M3dValue x)
+{
+    const int64_t pi = 3373259426; // pi in 2.30
+    int64_t cx = x;
+    int64_t cy = y;
+    int64_t z = 0;
+
+    if(cx == 0 && cy == 0)
+    {
+        return 0;
+    }
+
+    if(cx < 0)
+    {
+        cx = -cx;
+        cy = -cy;
+        z = y < 0 ? -pi : pi;
+    }
+
+    while((cx < 0 ? -cx : cx) < ((int64_t)1 << 29) && (cy < 0 ? -cy : cy) < ((int64_t)1 << 29))
+    {
+        cx *= 2;
+        cy *= 2;
+    }
+
+    m3dFixedCordicInternal(&cx, &cy, &z, 1);
+
+    return m3dFixedFromQ30Internal(z);
+}
+
+// acos and asin through atan2 of the sine and cosine, x is clamped to [-1, 1]. the root is
+// taken of the full 64 bit product, near +-1 a rounded product would cost most of the bits
+static inline M3dValue m3dFixedSinOfCosInternal(M3dValue x)
+{
+    return m3dFixedSqrt64Internal((uint64_t)((int64_t)(M3D_FIXED_ONE - x) * (M3D_FIXED_ONE + x)));
+}
+
+static inline M3dValue m3dFixedAcosInternal(M3dValue x)
+{
+    x = m3dMinInternal(m3dMaxInternal(x, -M3D_FIXED_ONE), M3D_FIXED_ONE);
+    return m3dFixedAtan2Internal(m3dFixedSinOfCosInternal(x), x);
+}
+
+static inline M3dValue m3dFixedAsinInternal(M3dValue x)
+{
+    x = m3dMinInternal(m3dMaxInternal(x, -M3D_FIXED_ONE), M3D_FIXED_ONE);
+    return m3dFixedAtan2Internal(x, m3dFixedSinOfCosInternal(x));
+}
+
+#define m3dSqrtInternal m3dFixedSqrtInternal
+#define m3dRsqrtInternal m3dFixedRsqrtInternal
+#define m3dSinInternal m3dFixedSinInternal
+#define m3dCosInternal m3dFixedCosInternal
+#define m3dTanInternal m3dFixedTanInternal
+#define m3dAcosInternal m3dFixedAcosInternal
+#define m3dAsinInternal m3dFixedAsinInternal
+#define m3dAtan2Internal m3dFixedAtan2Internal
+
+#else
+
+#define m3dMulInternal(a, b) ((a) * (b))
+#define m3dDivInternal(a, b) ((a) / (b))
+
+#endif // M3D_FIXED
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+
+/** loads 4 packed Vec3s (3 registers) and splits them into x, y and z registers */
+static inline void m3dLoadVec3x4Internal(const M3dValue *v, __m128 *x, __m128 *y, __m128 *z)
+{
+    __m128 a = _mm_loadu_ps(v);     // x0 y0 z0 x1
+    __m128 b = _mm_loadu_ps(v + 4); // y1 z1 x2 y2
+    __m128 c = _mm_loadu_ps(v + 8); // z2 x3 y3 z3
+
+    *x = _mm_shuffle_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 3, 0)),
+                        _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 1, 0));
+    *y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+                        _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+    *z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)),
+                        _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 3, 0)), _MM_SHUFFLE(1, 0, 2, 0));
+}
+
+/** interleaves x, y and z registers back into 4 packed Vec3s,
+    stream uses non temporal stores and needs res to be 16 byte aligned */
+static inline void m3dStoreVec3x4Internal(M3dValue *res, __m128 x, __m128 y, __m128 z, int stream)
+{
+    __m128 a = _mm_shuffle_ps(_mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)),
+                              _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 b = _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)),
+                              _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 c = _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)),
+                              _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+
+    if(stream)
+    {
+        _mm_stream_ps(res, a);
+        _mm_stream_ps(res + 4, b);
+        _mm_stream_ps(res + 8, c);
+    }
+    else
+    {
+        _mm_storeu_ps(res, a);
+        _mm_storeu_ps(res + 4, b);
+        _mm_storeu_ps(res + 8, c);
+    }
+}
+
+// the lanes of mask recomputed with the scalar sine and cosine
+static inline void m3dSinCos4ScalarInternal(__m128 x, __m128 *s, __m128 *c, int mask)
+{
+    float xs[4], ss[4], cs[4];
+    _mm_storeu_ps(xs, x);
+    _mm_storeu_ps(ss, *s);
+    _mm_storeu_ps(cs, *c);
+
+    for(int i = 0; i < 4; i++)
+    {
+        if(mask & (1 << i))
+        {
+            ss[i] = m3dSinInternal(xs[i]);
+            cs[i] = m3dCosInternal(xs[i]);
+        }
+    }
+
+    *s = _mm_loadu_ps(ss);
+    *c = _mm_loadu_ps(cs);
+}
+
+/** sine and cosine of 4 values at once with the reduction and polynomials of the fast math
+    scalar versions, within 1.6e-7 of the exact value for |x| < 8192. The reduction loses
+    bits beyond that, so those lanes take m3dSinInternal and m3dCosInternal instead */
+static inline void m3dSinCos4Internal(__m128 x, __m128 *s, __m128 *c)
+{
+    __m128i n = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.63661977236758134f)));
+    __m128 nf = _mm_cvtepi32_ps(n);
+    __m128 r = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(nf, _mm_set1_ps(1.5703125f))),
+                          _mm_mul_ps(nf, _mm_set1_ps(4.8382679489661923e-4f)));
+    __m128 z = _mm_mul_ps(r, r);
+
+    __m128 ps = _mm_add_ps(_mm_set1_ps(8.3321608736e-3f), _mm_mul_ps(z, _mm_set1_ps(-1.9515295891e-4f)));
+    ps = _mm_add_ps(_mm_set1_ps(-1.6666654611e-1f), _mm_mul_ps(z, ps));
+    ps = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, z), ps));
+
+    __m128 pc = _mm_add_ps(_mm_set1_ps(-1.388731625493765e-3f), _mm_mul_ps(z, _mm_set1_ps(2.443315711809948e-5f)));
+    pc = _mm_add_ps(_mm_set1_ps(4.166664568298827e-2f), _mm_mul_ps(z, pc));
+    pc = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_mul_ps(_mm_mul_ps(z, z), pc));
+
+    // odd quadrants swap the polynomials, quadrants 2 and 3 (1 and 2 for cosine) negate them
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(n, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(n, _mm_set1_epi32(2)), 30));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(n, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+
+    *s = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, pc), _mm_andnot_ps(swap, ps)), sinSign);
+    *c = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, ps), _mm_andnot_ps(swap, pc)), cosSign);
+
+    __m128 ax = _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+    int far = _mm_movemask_ps(_mm_cmpge_ps(ax, _mm_set1_ps(8192.0f)));
+
+    if(far)
+    {
+        m3dSinCos4ScalarInternal(x, s, c, far);
+    }
+}
+
+/** transposes 4 quaternion registers (i, j, k and w of 4 quaternions) and stores them */
+static inline void m3dStoreQuatx4Internal(Quat *res, __m128 i, __m128 j, __m128 k, __m128 w)
+{
+    _MM_TRANSPOSE4_PS(i, j, k, w);
+
+    _mm_storeu_ps(&res[0].i, i);
+    _mm_storeu_ps(&res[1].i, j);
+    _mm_storeu_ps(&res[2].i, k);
+    _mm_storeu_ps(&res[3].i, w);
+}
+
+#endif
+
+/** ---------------- threading
+
+    M3D_PARALLEL_BLOCKS(begin, end, first, last, min, call) runs call for blocks of min items
+    of [first, last), with begin and end declared as the bounds of each block. With OpenMP
+    the blocks are spread over the threads, a single block stays on the calling thread since
+    the fork and join would cost more than the work. Without it call runs once over the range */
+
+#if defined(_MSC_VER)
+#define M3D_PRAGMA(x) __pragma(x)
+#else
+#define M3D_PRAGMA(x) _Pragma(#x)
+#endif
+
+#ifdef _OPENMP
+#define M3D_PARALLEL_BLOCKS(begin, end, first, last, min, call) \
+    do \
+    { \
+        size_t m3dBlocksFirst = (first); \
+        size_t m3dBlocksLast = (last); \
+        ptrdiff_t m3dBlocks = (ptrdiff_t)((m3dBlocksLast - m3dBlocksFirst + (min) - 1) / (min)); \
+        M3D_PRAGMA(omp parallel for schedule(static) if(m3dBlocks > 1)) \
+        for(ptrdiff_t m3dBlock = 0; m3dBlock < m3dBlocks; m3dBlock++) \
+        { \
+            size_t begin = m3dBlocksFirst + (size_t)m3dBlock * (min); \
+            size_t end = begin + (min) < m3dBlocksLast ? begin + (min) : m3dBlocksLast; \
+            call; \
+        } \
+    } while(0)
+#else
+#define M3D_PARALLEL_BLOCKS(begin, end, first, last, min, call) \
+    do \
+    { \
+        size_t begin = (first); \
+        size_t end = (last); \
+        call; \
+    } while(0)
+#endif // _OPENMP
+
+/** vertices per block of m3dSkinUpdate and m3dDualQuatSkinVec3Array */
+#define M3D_SKIN_PARALLEL_MIN 4096
+
+/** ---------------- profiling
+
+    M3D_PROFILE_FUNCTION() opens every public function. It is nothing unless the library is
+    built with M3D_PROFILE, then the first call registers the function by its name and
+    every call adds to the counters of the calling thread, see profile.c */
+
+#ifdef M3D_PROFILE
+
+#define M3D_PROFILE_MAX_FUNCTIONS 512
+
+/** cycles need the cleanup attribute to run code when the function returns, and rdtsc */
+#if defined(M3D_PROFILE_CYCLES) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define M3D_PROFILE_TIMED
+#include <x86intrin.h>
+#endif
+
+typedef struct{
+    const char *name;
+    int index; // -1 until the first call, -2 while that call registers it
+}M3dProfileSite;
+
+/** the counters of one thread, only ever written by it. reset keeps them running and
+    moves the baseline the snapshots subtract instead, so the owner never needs a lock */
+typedef struct M3dProfileThread{
+    uint64_t calls[M3D_PROFILE_MAX_FUNCTIONS];
+    uint64_t cycles[M3D_PROFILE_MAX_FUNCTIONS];
+    uint64_t baseCalls[M3D_PROFILE_MAX_FUNCTIONS];
+    uint64_t baseCycles[M3D_PROFILE_MAX_FUNCTIONS];
+    struct M3dProfileThread *next;
+}M3dProfileThread;
+
+/** returns the index of site, registering it on the first call,
+    or M3D_PROFILE_MAX_FUNCTIONS once the table is full */
+M3D_API int m3dProfileRegisterInternal(M3dProfileSite *site);
+/** returns the counters of the calling thread, created on its first call, NULL without memory */
+M3D_API M3dProfileThread *m3dProfileThreadInternal();
+
+#if defined(__GNUC__) || defined(__clang__)
+#define m3dProfileLoadInternal(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define m3dProfileAddInternal(p, v) __atomic_store_n(p, __atomic_load_n(p, __ATOMIC_RELAXED) + (v), __ATOMIC_RELAXED)
+#else
+// volatile accesses are acquire loads and release stores with msvc on x86
+#define m3dProfileLoadInternal(p) (*(volatile const int *)(p))
+#define m3dProfileAddInternal(p, v) (*(volatile uint64_t *)(p) += (v))
+#endif
+
+static inline int m3dProfileIndexInternal(M3dProfileSite *site)
+{
+    int index = m3dProfileLoadInternal(&site->index);
+    return index >= 0 ? index : m3dProfileRegisterInternal(site);
+}
+
+static inline void m3dProfileCountInternal(M3dProfileSite *site)
+{
+    int index = m3dProfileIndexInternal(site);
+    M3dProfileThread *t = m3dProfileThreadInternal();
+
+    if(t && index < M3D_PROFILE_MAX_FUNCTIONS)
+    {
+        m3dProfileAddInternal(&t->calls[index], 1);
+    }
+}
+
+#ifdef M3D_PROFILE_TIMED
+
+typedef struct{
+    M3dProfileSite *site;
+    uint64_t start;
+}M3dProfileScope;
+
+static inline M3dProfileScope m3dProfileEnterInternal(M3dProfileSite *site)
+{
+    m3dProfileCountInternal(site);
+
+    M3dProfileScope res = {site, __rdtsc()};
+    return res;
+}
+
+static inline void m3dProfileLeaveInternal(M3dProfileScope *scope)
+{
+    uint64_t cycles = __rdtsc() - scope->start;
+    int index = m3dProfileLoadInternal(&scope->site->index);
+    M3dProfileThread *t = m3dProfileThreadInternal();
+
+    if(t && index >= 0 && index < M3D_PROFILE_MAX_FUNCTIONS)
+    {
+        m3dProfileAddInternal(&t->cycles[index], cycles);
+    }
+}
+
+#define M3D_PROFILE_FUNCTION() \
+    static M3dProfileSite m3dProfileSite = {__func__, -1}; \
+    M3dProfileScope m3dProfileScope __attribute__((cleanup(m3dProfileLeaveInternal))) = m3dProfileEnterInternal(&m3dProfileSite)
+
+#else
+
+#define M3D_PROFILE_FUNCTION() \
+    static M3dProfileSite m3dProfileSite = {__func__, -1}; \
+    m3dProfileCountInternal(&m3dProfileSite)
+
+#endif // M3D_PROFILE_TIMED
+
+#else
+
+#define M3D_PROFILE_FUNCTION() (void)0
+
+#endif // M3D_PROFILE
+
+#endif // M3D_INTERNAL_H
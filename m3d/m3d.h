@@ -1,15 +1,111 @@
 #ifndef M3D_H
 #define M3D_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 /** ------------- typedef based controls
     sets how the library works, what types of floating points to use etc */
 
-#ifdef M3D_DOUBLE
+#if defined(M3D_FIXED) && defined(M3D_DOUBLE)
+#error "M3D_FIXED and M3D_DOUBLE can't be combined"
+#endif
+
+#if defined(M3D_FIXED)
+typedef int32_t M3dValue;
+#elif defined(M3D_DOUBLE)
 typedef double M3dValue;
 #else
 typedef float M3dValue;
 #endif // M3D_DOUBLE
 
+/** M3D_FIXED makes M3dValue a signed Q format integer for targets without an fpu and for
+    lockstep simulations that need the same bits on every machine. M3D_FIXED_FRACTION sets
+    the fractional bits, 16 by default for Q16.16 with a range of +-32768 and a step of
+    1.5e-5, and can be anything from 8 to 24. Products and quotients outside the range wrap
+    and saturate respectively, a division by 0 gives the largest value of the sign. The
+    lengths and normalizations sum their squares in 64 bits and work over the whole range,
+    normalizing a zero vector leaves it 0. Dot and LengthSqr results past the range wrap.
+    Maximum errors of the integer versions of the libm calls, in steps of the last
+    fractional bit, Q16.16 / Q8.24:
+        sqrt        0.5 / 0.5, rounded to nearest
+        sin, cos    0.59 / 0.83 for any input, cordic after a reduction by pi / 2
+        atan2       0.51 / 0.71, cordic
+        acos, asin  0.99 / 1.07 on [-1, 1] through atan2, inputs outside are clamped
+    The build covers the scalar math, Vec2, Vec3, Vec4 and quaternion functions, the arenas
+    and profiling. The other sections aren't declared, their files compile to nothing.
+    Build every file with the same M3D_FIXED and M3D_FIXED_FRACTION */
+#ifdef M3D_FIXED
+#ifndef M3D_FIXED_FRACTION
+#define M3D_FIXED_FRACTION 16
+#endif
+#if M3D_FIXED_FRACTION < 8 || M3D_FIXED_FRACTION > 24
+#error "M3D_FIXED_FRACTION has to be between 8 and 24"
+#endif
+#define M3D_FIXED_ONE ((M3dValue)1 << M3D_FIXED_FRACTION)
+#endif // M3D_FIXED
+
+/** M3D_VALUE turns a constant like M3D_VALUE(0.5) into an M3dValue in every build, rounded
+    to nearest in fixed builds. It goes through double, so on targets without an fpu it
+    should only see constants the compiler folds. M3D_VALUE_FROM_INT converts integers
+    without floating point, M3D_VALUE_TO_DOUBLE is meant for printing and tests */
+#ifdef M3D_FIXED
+#define M3D_VALUE(x) ((M3dValue)((x) * (double)M3D_FIXED_ONE + ((x) < 0 ? -0.5 : 0.5)))
+#define M3D_VALUE_FROM_INT(i) ((M3dValue)((i) * M3D_FIXED_ONE))
+#define M3D_VALUE_TO_DOUBLE(v) ((double)(v) / M3D_FIXED_ONE)
+#else
+#define M3D_VALUE(x) ((M3dValue)(x))
+#define M3D_VALUE_FROM_INT(i) ((M3dValue)(i))
+#define M3D_VALUE_TO_DOUBLE(v) ((double)(v))
+#endif // M3D_FIXED
+
+/** M3D_FAST_MATH replaces the libm calls made inside the library with polynomial and rsqrt
+    approximations, normalizing multiplies by an approximate 1 / length instead of dividing.
+    Maximum errors against libm in double, float builds / double builds:
+        sqrt        exact, sqrtss / sqrtsd without the errno handling
+        rsqrt       2.8e-7 / 1.7e-16 relative, rsqrtss plus one newton step in float builds,
+                    which gives inf below 2^-126 where rsqrtss flushes the input to zero,
+                    double builds divide by sqrtsd over the whole double range
+        sin, cos    1.6e-7 / 2.7e-9 absolute for |x| < 8192, the reduction by pi / 2 loses
+                    bits beyond that so larger values take the libm sin and cos
+        tan         2.4e-7 / 4e-9 relative on (-1.5, 1.5)
+        acos, asin  4.4e-7 / 2.2e-8 absolute on [-1, 1]
+        atan2       2.9e-7 / 1.4e-8 absolute
+    The float errors include rounding the result to float. Every file of the library has to
+    be built with the same setting */
+
+/** M3D_PROFILE counts the calls of every public function per thread, without locks, for
+    m3dProfileSnapshot and the format functions. M3D_PROFILE_CYCLES also sums the rdtsc
+    cycles spent inside them with gcc and clang on x86, inclusive of the public functions
+    they call. Functions register on their first call, so only functions that were called
+    are listed. Without M3D_PROFILE the counting compiles away and the snapshot is empty.
+    With M3D_INLINE every file including m3d.h counts on its own */
+
+/** By default the header only declares the library and the .c files are compiled as usual.
+    M3D_INLINE turns every function into a static inline definition in each file including
+    m3d.h, so small calls can inline without lto. M3D_IMPLEMENTATION compiles the whole
+    library into the one file that defines it, for builds that don't list the .c files.
+    Neither mode should be mixed with also linking the .c files */
+#ifdef M3D_INLINE
+#define M3D_API static inline
+#else
+#define M3D_API
+#endif // M3D_INLINE
+
+/** marks an out pointer that may not alias any other argument */
+#if defined(_MSC_VER) || defined(__cplusplus)
+#define M3D_RESTRICT __restrict
+#else
+#define M3D_RESTRICT restrict
+#endif
+
+/** raises the alignment of a type */
+#if defined(_MSC_VER)
+#define M3D_ALIGN(n) __declspec(align(n))
+#else
+#define M3D_ALIGN(n) __attribute__((aligned(n)))
+#endif
+
 /** ---------------- structs */
 
 /** a two component vector */
@@ -41,6 +137,13 @@ typedef struct{
     M3dValue w;
 }Quat;
 
+/** a rigid transform as a dual quaternion, real is the unit rotation and dual is
+    half the translation as a pure quaternion times real */
+typedef struct{
+    Quat real;
+    Quat dual;
+}DualQuat;
+
 /** a matrix with width 3 and height 3
     00  01  02
     10  11  12
@@ -61,6 +164,210 @@ typedef struct{
     M3dValue m[4][4];
 }Mat4x4;
 
+/** a three component vector padded to four and aligned to its size, 16 bytes in float
+    builds, so it loads as one sse register. w is padding and has to stay 0 */
+#ifdef M3D_DOUBLE
+typedef M3D_ALIGN(32) struct{
+#else
+typedef M3D_ALIGN(16) struct{
+#endif // M3D_DOUBLE
+    M3dValue x;
+    M3dValue y;
+    M3dValue z;
+    M3dValue w;
+}Vec3A;
+
+/** an affine transform, the top three rows of a Mat4x4 whose bottom row is 0 0 0 1,
+    each row aligned like a Vec3A
+    00  01  02  03
+    10  11  12  13
+    20  21  22  23
+*/
+#ifdef M3D_DOUBLE
+typedef M3D_ALIGN(32) struct{
+#else
+typedef M3D_ALIGN(16) struct{
+#endif // M3D_DOUBLE
+    M3dValue m[3][4];
+}Mat3x4;
+
+/** structure of arrays storage for many Vec2s,
+    x and y each point to at least count values */
+typedef struct{
+    M3dValue *x;
+    M3dValue *y;
+    size_t count;
+}Vec2Soa;
+
+/** structure of arrays storage for many Vec3s,
+    x, y and z each point to at least count values */
+typedef struct{
+    M3dValue *x;
+    M3dValue *y;
+    M3dValue *z;
+    size_t count;
+}Vec3Soa;
+
+/** structure of arrays storage for many Vec4s,
+    x, y, z and w each point to at least count values */
+typedef struct{
+    M3dValue *x;
+    M3dValue *y;
+    M3dValue *z;
+    M3dValue *w;
+    size_t count;
+}Vec4Soa;
+
+/** structure of arrays storage for many Quats,
+    i, j, k and w each point to at least count values */
+typedef struct{
+    M3dValue *i;
+    M3dValue *j;
+    M3dValue *k;
+    M3dValue *w;
+    size_t count;
+}QuatSoa;
+
+/** a unit quaternion in 32 bits, the index of the largest component in the top 2 bits
+    and the other three in 10 bits each */
+typedef uint32_t PackedQuat32;
+
+/** a unit quaternion in 48 bits, the other three components in the low 15 bits of each
+    value and the index of the largest one in the top bits of v[0] and v[1] */
+typedef struct{
+    uint16_t v[3];
+}PackedQuat48;
+
+/** a Vec3 quantized to 16 bits per component within a bounds box */
+typedef struct{
+    uint16_t x;
+    uint16_t y;
+    uint16_t z;
+}PackedVec3;
+
+/** a plane of the points p where dot(n, p) + d = 0, n is unit length */
+typedef struct{
+    Vec3 n;
+    M3dValue d;
+}Plane;
+
+/** the six planes of a view volume, their normals point inside */
+typedef struct{
+    Plane p[6];
+}Frustum;
+
+#define M3D_FRUSTUM_LEFT    0
+#define M3D_FRUSTUM_RIGHT   1
+#define M3D_FRUSTUM_BOTTOM  2
+#define M3D_FRUSTUM_TOP     3
+#define M3D_FRUSTUM_NEAR    4
+#define M3D_FRUSTUM_FAR     5
+
+/** an axis aligned box from min to max */
+typedef struct{
+    Vec3 min;
+    Vec3 max;
+}Aabb;
+
+/** a node of a bounding volume hierarchy. count is 0 for inner nodes, whose children are
+    the nodes first and first + 1, leaves hold the objects indices[first] to
+    indices[first + count - 1] of their M3dBvh */
+typedef struct{
+    Aabb bounds;
+    uint32_t first;
+    uint32_t count;
+}M3dBvhNode;
+
+/** a bounding volume hierarchy over count object boxes as one flat node array, root first.
+    bounds is read by the queries as well as the build and must stay alive, indices needs
+    room for count and nodes for 2 * count nodes, both are filled in by m3dBvhBuild */
+typedef struct{
+    const Aabb *bounds;
+    uint32_t *indices;
+    M3dBvhNode *nodes;
+    size_t nodeCount;
+    size_t count;
+}M3dBvh;
+
+#define M3D_BVH_NONE ((uint32_t)-1)
+
+/** tests the ray origin + t * dir against object index for m3dBvhRaycast, returns the t
+    of the hit or any value not below maxT for a miss */
+typedef M3dValue (*M3dBvhRayFunc)(void *user, uint32_t index, Vec3 origin, Vec3 dir, M3dValue maxT);
+
+/** a bump allocator for per frame scratch arrays, every allocation is a pointer increment
+    and a reset frees all of them at once. an arena is not thread safe, give every thread
+    its own. allocation is NULL when the memory belongs to the caller */
+typedef struct{
+    unsigned char *base;
+    size_t size;
+    size_t used;
+    size_t peak;
+    void *allocation;
+}M3dArena;
+
+/** alignment of every arena allocation, a cache line, enough for aligned sse, avx and avx512 loads */
+#define M3D_ARENA_ALIGN 64
+
+/** a transform hierarchy as flat arrays sorted by depth, every root comes first and
+    every node comes after its parent's whole level. parent holds M3D_HIERARCHY_NO_PARENT
+    for roots. position, rotation and scale are the local transform of each node and
+    world receives parent world * T * R * S. All arrays hold count entries except
+    levelStart, which needs count + 1 and is filled in by m3dHierarchyBuildLevels */
+typedef struct{
+    Vec3 *position;
+    Quat *rotation;
+    Vec3 *scale;
+    const size_t *parent;
+    Mat4x4 *world;
+    size_t *levelStart;
+    size_t levelCount;
+    size_t count;
+}M3dHierarchy;
+
+#define M3D_HIERARCHY_NO_PARENT ((size_t)-1)
+
+/** the totals of one function over every thread since the last m3dProfileReset */
+typedef struct{
+    const char *name;
+    uint64_t calls;
+    uint64_t cycles;
+}M3dProfileEntry;
+
+/** the inputs and outputs of linear blend skinning for count vertices. Vertex n has the 4
+    influences bones[4 * n + k] into the bone matrices with weights[4 * n + k], unused
+    influences have weight 0 and any valid bone. The bones are either palette or
+    affinePalette, the other one is NULL, and only their top three rows are read.
+    position and normal may each be NULL to skip that stream, otherwise resPosition and
+    resNormal receive count results and may be the inputs */
+typedef struct{
+    const Mat4x4 *palette;
+    const Mat3x4 *affinePalette;
+    const uint16_t *bones;
+    const M3dValue *weights;
+    const Vec3 *position;
+    const Vec3 *normal;
+    Vec3 *resPosition;
+    Vec3 *resNormal;
+    size_t count;
+}M3dSkin;
+
+/** ---------------- cpu feature detection */
+
+/** instruction sets the library can pick kernels for at runtime,
+    M3D_CPU_AVX512 is the avx-512 foundation set and only has double precision kernels */
+#define M3D_CPU_SSE2    0x01
+#define M3D_CPU_AVX     0x02
+#define M3D_CPU_AVX2    0x04
+#define M3D_CPU_FMA     0x08
+#define M3D_CPU_AVX512  0x10
+
+/** returns the M3D_CPU_ flags supported by this cpu and os, limited by m3dCpuSetFeatures */
+M3D_API unsigned int m3dCpuFeatures();
+/** limits the kernels the library may use to those in mask, 0 forces the plain c code.
+    kernels are picked on first use, so call this before any other m3d function */
+M3D_API void m3dCpuSetFeatures(unsigned int mask);
+
 /** ---------------- 1 dimensional maths*/
 
 #define PI 3.1415926535897
@@ -68,120 +375,268 @@ typedef struct{
 #define TO_DEGS 180.0 / PI
 
 /** returns value v clamped between low and high*/
-M3dValue m3d1DClamp(M3dValue v, M3dValue low, M3dValue high);
+M3D_API M3dValue m3d1DClamp(M3dValue v, M3dValue low, M3dValue high);
 /** linear interpolation between a and b based on t*/
-M3dValue m3d1DLerp(M3dValue a, M3dValue b, M3dValue t);
+M3D_API M3dValue m3d1DLerp(M3dValue a, M3dValue b, M3dValue t);
+/** writes the sine and cosine of count values of v into s and c. float builds with sse2
+    use a polynomial for 4 values at a time, within 1.6e-7 of the exact value for |v| < 8192,
+    larger values take the scalar sin and cos */
+M3D_API void m3d1DSinCosArray(M3dValue *M3D_RESTRICT s, M3dValue *M3D_RESTRICT c, const M3dValue *v, size_t count);
 
 /** ---------------- Vec2 related functions */
 
 /** returns the angle in radians between vectors a and b */
-M3dValue m3dVec2Angle(Vec2 a, Vec2 b);
+M3D_API M3dValue m3dVec2Angle(Vec2 a, Vec2 b);
  /** returns the distance between vectors a and b */
-M3dValue m3dVec2Distance(Vec2 a, Vec2 b);
+M3D_API M3dValue m3dVec2Distance(Vec2 a, Vec2 b);
 /** returns the dot product multiplication of vectors a and b */
-M3dValue m3dVec2Dot(Vec2 a, Vec2 b);
+M3D_API M3dValue m3dVec2Dot(Vec2 a, Vec2 b);
 /** returns the unsigned length of vector v */
-M3dValue m3dVec2Length(Vec2 v);
+M3D_API M3dValue m3dVec2Length(Vec2 v);
 /** returns the square length of vector v */
-M3dValue m3dVec2LengthSqr(Vec2 v);
+M3D_API M3dValue m3dVec2LengthSqr(Vec2 v);
 /** returns the linear interpolation between vectors a and b at value t */
-Vec2 m3dVec2Lerp(Vec2 a, Vec2 b, M3dValue t);
+M3D_API Vec2 m3dVec2Lerp(Vec2 a, Vec2 b, M3dValue t);
 /** returns a vector made of the largest components between vectors a and b */
-Vec2 m3dVec2Max(Vec2 a, Vec2 b);
+M3D_API Vec2 m3dVec2Max(Vec2 a, Vec2 b);
 /** returns a vector made of the smallest components between vectors a and b */
-Vec2 m3dVec2Min(Vec2 a, Vec2 b);
+M3D_API Vec2 m3dVec2Min(Vec2 a, Vec2 b);
 /** returns a normalized copy of the vector passed in */
-Vec2 m3dVec2Normalized(Vec2 v);
+M3D_API Vec2 m3dVec2Normalized(Vec2 v);
 /** returns the reflection of vector v over the normal vector n */
-Vec2 m3dVec2Reflect(Vec2 v, Vec2 n);
+M3D_API Vec2 m3dVec2Reflect(Vec2 v, Vec2 n);
 /** returns the spherical linear interpolation between vectors a and b */
-Vec2 m3dVec2Slerp(Vec2 a, Vec2 b, M3dValue t);
+M3D_API Vec2 m3dVec2Slerp(Vec2 a, Vec2 b, M3dValue t);
 
 /** returns vector of a and b added by component */
-Vec2 m3dVec2AddVec2(Vec2 a, Vec2 b);
+M3D_API Vec2 m3dVec2AddVec2(Vec2 a, Vec2 b);
 /** returns vector of b added to each component of a */
-Vec2 m3dVec2AddValue(Vec2 a, M3dValue b);
+M3D_API Vec2 m3dVec2AddValue(Vec2 a, M3dValue b);
 /** returns vector of a and b subtracted by component */
-Vec2 m3dVec2SubVec2(Vec2 a, Vec2 b);
+M3D_API Vec2 m3dVec2SubVec2(Vec2 a, Vec2 b);
 /** returns vector of b subtracted from each component of a */
-Vec2 m3dVec2SubValue(Vec2 a, M3dValue b);
+M3D_API Vec2 m3dVec2SubValue(Vec2 a, M3dValue b);
 /** returns vector of a and b multiplied by component */
-Vec2 m3dVec2MulVec2(Vec2 a, Vec2 b);
+M3D_API Vec2 m3dVec2MulVec2(Vec2 a, Vec2 b);
 /** returns vector of b multiplied with each component of a */
-Vec2 m3dVec2MulValue(Vec2 a, M3dValue b);
+M3D_API Vec2 m3dVec2MulValue(Vec2 a, M3dValue b);
 /** returns vector of a and b divided by component */
-Vec2 m3dVec2DivVec2(Vec2 a, Vec2 b);
+M3D_API Vec2 m3dVec2DivVec2(Vec2 a, Vec2 b);
 /** returns vector of b divided from each component of a */
-Vec2 m3dVec2DivValue(Vec2 a, M3dValue b);
+M3D_API Vec2 m3dVec2DivValue(Vec2 a, M3dValue b);
 
-char m3dVec2Equal(Vec2 a, Vec2 b);
+M3D_API char m3dVec2Equal(Vec2 a, Vec2 b);
 
 /** ---------------- Vec3 related functions*/
 
 /** returns the angle in radians between vectors a and b */
-M3dValue m3dVec3Angle(Vec3 a, Vec3 b);
+M3D_API M3dValue m3dVec3Angle(Vec3 a, Vec3 b);
 /** returns the cross product multiplication of vectors a and b */
-Vec3 m3dVec3Cross(Vec3 a, Vec3 b);
+M3D_API Vec3 m3dVec3Cross(Vec3 a, Vec3 b);
  /** returns the distance between vectors a and b */
-M3dValue m3dVec3Distance(Vec3 a, Vec3 b);
+M3D_API M3dValue m3dVec3Distance(Vec3 a, Vec3 b);
 /** returns the dot product multiplication of vectors a and b */
-M3dValue m3dVec3Dot(Vec3 a, Vec3 b);
+M3D_API M3dValue m3dVec3Dot(Vec3 a, Vec3 b);
 /** returns the unsigned length of vector v */
-M3dValue m3dVec3Length(Vec3 v);
+M3D_API M3dValue m3dVec3Length(Vec3 v);
 /** returns the sqr length of vector v */
-M3dValue m3dVec3LengthSqr(Vec3 v);
+M3D_API M3dValue m3dVec3LengthSqr(Vec3 v);
 /** returns the linear interpolation between vectors a and b at value t */
-Vec3 m3dVec3Lerp(Vec3 a, Vec3 b, M3dValue t);
+M3D_API Vec3 m3dVec3Lerp(Vec3 a, Vec3 b, M3dValue t);
 /** returns a vector made of the largest components between vectors a and b */
-Vec3 m3dVec3Max(Vec3 a, Vec3 b);
+M3D_API Vec3 m3dVec3Max(Vec3 a, Vec3 b);
 /** returns a vector made of the smallest components between vectors a and b */
-Vec3 m3dVec3Min(Vec3 a, Vec3 b);
+M3D_API Vec3 m3dVec3Min(Vec3 a, Vec3 b);
 /** returns a normalized copy of the vector passed in */
-Vec3 m3dVec3Normalized(Vec3 v);
+M3D_API Vec3 m3dVec3Normalized(Vec3 v);
 /** returns the reflection of vector v over the normal vector n */
-Vec3 m3dVec3Reflect(Vec3 v, Vec3 n);
+M3D_API Vec3 m3dVec3Reflect(Vec3 v, Vec3 n);
 /** returns the spherical linear interpolation between vectors a and b */
-Vec3 m3dVec3Slerp(Vec3 a, Vec3 b, M3dValue t);
+M3D_API Vec3 m3dVec3Slerp(Vec3 a, Vec3 b, M3dValue t);
 
 /** returns vector of a and b added by component */
-Vec3 m3dVec3AddVec3(Vec3 a, Vec3 b);
+M3D_API Vec3 m3dVec3AddVec3(Vec3 a, Vec3 b);
 /** returns vector of b added to each component of a */
-Vec3 m3dVec3AddValue(Vec3 a, M3dValue b);
+M3D_API Vec3 m3dVec3AddValue(Vec3 a, M3dValue b);
 /** returns vector of a and b subtracted by component */
-Vec3 m3dVec3SubVec3(Vec3 a, Vec3 b);
+M3D_API Vec3 m3dVec3SubVec3(Vec3 a, Vec3 b);
 /** returns vector of b subtracted from each component of a */
-Vec3 m3dVec3SubValue(Vec3 a, M3dValue b);
+M3D_API Vec3 m3dVec3SubValue(Vec3 a, M3dValue b);
 /** returns vector of a and b multiplied by component */
-Vec3 m3dVec3MulVec3(Vec3 a, Vec3 b);
+M3D_API Vec3 m3dVec3MulVec3(Vec3 a, Vec3 b);
 /** returns vector of b multiplied with each component of a */
-Vec3 m3dVec3MulValue(Vec3 a, M3dValue b);
+M3D_API Vec3 m3dVec3MulValue(Vec3 a, M3dValue b);
 /** returns vector of a and b divided by component */
-Vec3 m3dVec3DivVec3(Vec3 a, Vec3 b);
+M3D_API Vec3 m3dVec3DivVec3(Vec3 a, Vec3 b);
 /** returns vector of b divided from each component of a */
-Vec3 m3dVec3DivValue(Vec3 a, M3dValue b);
+M3D_API Vec3 m3dVec3DivValue(Vec3 a, M3dValue b);
+
+M3D_API char m3dVec3Equal(Vec3 a, Vec3 b);
+
+#ifndef M3D_FIXED
+
+/** Box quantization, every component of v is mapped to 0 - 65535 over min to max.
+    Values outside the box are clamped, inside it the error is at most (max - min) / 131070
+    per component plus float rounding. The Array forms work like the quaternion ones */
+
+M3D_API PackedVec3 m3dVec3Encode48(Vec3 v, Vec3 min, Vec3 max);
+M3D_API Vec3 m3dVec3Decode48(PackedVec3 v, Vec3 min, Vec3 max);
+M3D_API void m3dVec3Encode48Array(PackedVec3 *M3D_RESTRICT res, const Vec3 *v, size_t count, Vec3 min, Vec3 max);
+M3D_API void m3dVec3Decode48Array(Vec3 *M3D_RESTRICT res, const PackedVec3 *v, size_t count, Vec3 min, Vec3 max);
 
-char m3dVec3Equal(Vec3 a, Vec3 b);
+/** ---------------- Vec3A related functions
+    the Vec3 operations on aligned vectors with w kept at 0.
+    the by value forms are plain c, which compilers keep in registers, the Ptr forms work
+    on whole aligned sse registers in float builds */
+
+M3D_API Vec3A m3dVec3AFromVec3(Vec3 v);
+M3D_API Vec3 m3dVec3AToVec3(Vec3A v);
+M3D_API Vec3A m3dVec3AAddVec3A(Vec3A a, Vec3A b);
+M3D_API Vec3A m3dVec3AAddValue(Vec3A a, M3dValue b);
+M3D_API Vec3A m3dVec3ASubVec3A(Vec3A a, Vec3A b);
+M3D_API Vec3A m3dVec3ASubValue(Vec3A a, M3dValue b);
+M3D_API Vec3A m3dVec3AMulVec3A(Vec3A a, Vec3A b);
+M3D_API Vec3A m3dVec3AMulValue(Vec3A a, M3dValue b);
+M3D_API Vec3A m3dVec3ADivVec3A(Vec3A a, Vec3A b);
+M3D_API Vec3A m3dVec3ADivValue(Vec3A a, M3dValue b);
+M3D_API Vec3A m3dVec3AMin(Vec3A a, Vec3A b);
+M3D_API Vec3A m3dVec3AMax(Vec3A a, Vec3A b);
+M3D_API Vec3A m3dVec3ALerp(Vec3A a, Vec3A b, M3dValue t);
+M3D_API Vec3A m3dVec3ACross(Vec3A a, Vec3A b);
+M3D_API M3dValue m3dVec3ADot(Vec3A a, Vec3A b);
+M3D_API M3dValue m3dVec3ALengthSqr(Vec3A v);
+M3D_API M3dValue m3dVec3ALength(Vec3A v);
+M3D_API M3dValue m3dVec3ADistance(Vec3A a, Vec3A b);
+M3D_API Vec3A m3dVec3ANormalized(Vec3A v);
+M3D_API M3dValue m3dVec3AAngle(Vec3A a, Vec3A b);
+M3D_API Vec3A m3dVec3AReflect(Vec3A v, Vec3A n);
+M3D_API Vec3A m3dVec3ASlerp(Vec3A a, Vec3A b, M3dValue t);
+M3D_API char m3dVec3AEqual(Vec3A a, Vec3A b);
+M3D_API void m3dVec3AAddVec3APtr(Vec3A *res, const Vec3A *a, const Vec3A *b);
+M3D_API void m3dVec3ASubVec3APtr(Vec3A *res, const Vec3A *a, const Vec3A *b);
+M3D_API void m3dVec3AMulVec3APtr(Vec3A *res, const Vec3A *a, const Vec3A *b);
+M3D_API void m3dVec3AMulValuePtr(Vec3A *res, const Vec3A *a, M3dValue b);
+M3D_API void m3dVec3AMinPtr(Vec3A *res, const Vec3A *a, const Vec3A *b);
+M3D_API void m3dVec3AMaxPtr(Vec3A *res, const Vec3A *a, const Vec3A *b);
+M3D_API void m3dVec3ALerpPtr(Vec3A *res, const Vec3A *a, const Vec3A *b, M3dValue t);
+M3D_API void m3dVec3ACrossPtr(Vec3A *res, const Vec3A *a, const Vec3A *b);
+M3D_API M3dValue m3dVec3ADotPtr(const Vec3A *a, const Vec3A *b);
+M3D_API void m3dVec3ANormalizedPtr(Vec3A *res, const Vec3A *v);
+/** converts count vectors between the packed and padded layouts, 4 per step with sse2 */
+M3D_API void m3dVec3AFromVec3Array(Vec3A *M3D_RESTRICT res, const Vec3 *v, size_t count);
+M3D_API void m3dVec3AToVec3Array(Vec3 *M3D_RESTRICT res, const Vec3A *v, size_t count);
+
+#endif // M3D_FIXED
 
 /** ---------------- Vec4 related functions*/
 
 /** returns vector of a and b added by component */
-Vec4 m3dVec4AddVec4(Vec4 a, Vec4 b);
+M3D_API Vec4 m3dVec4AddVec4(Vec4 a, Vec4 b);
 /** returns vector of b added to each component of a */
-Vec4 m3dVec4AddValue(Vec4 a, M3dValue b);
+M3D_API Vec4 m3dVec4AddValue(Vec4 a, M3dValue b);
 /** returns vector of a and b subtracted by component */
-Vec4 m3dVec4SubVec4(Vec4 a, Vec4 b);
+M3D_API Vec4 m3dVec4SubVec4(Vec4 a, Vec4 b);
 /** returns vector of b subtracted from each component of a */
-Vec4 m3dVec4SubValue(Vec4 a, M3dValue b);
+M3D_API Vec4 m3dVec4SubValue(Vec4 a, M3dValue b);
 /** returns vector of a and b multiplied by component */
-Vec4 m3dVec4MulVec4(Vec4 a, Vec4 b);
+M3D_API Vec4 m3dVec4MulVec4(Vec4 a, Vec4 b);
 /** returns vector of b multiplied with each component of a */
-Vec4 m3dVec4MulValue(Vec4 a, M3dValue b);
+M3D_API Vec4 m3dVec4MulValue(Vec4 a, M3dValue b);
 /** returns vector of a and b divided by component */
-Vec4 m3dVec4DivVec4(Vec4 a, Vec4 b);
+M3D_API Vec4 m3dVec4DivVec4(Vec4 a, Vec4 b);
 /** returns vector of b divided from each component of a */
-Vec4 m3dVec4DivValue(Vec4 a, M3dValue b);
+M3D_API Vec4 m3dVec4DivValue(Vec4 a, M3dValue b);
+
+M3D_API char m3dVec4Equal(Vec4 a, Vec4 b);
+
+#ifndef M3D_FIXED
+
+/** ---------------- Vector batch functions*/
 
-char m3dVec4Equal(Vec4 a, Vec4 b);
+/** These work on a.count (or v.count) vectors at once, res must hold at least as many.
+    res may be the same storage as a or b, but must not partially overlap them.
+    Each component is a separate stream run through sse2 kernels, or avx (and avx-512
+    in double builds) when the cpu has it, and the plain c loop for the remainder.
+    Only the double avx-512 Lerp differs from the plain c results, by one fused rounding */
+
+/** copies count vectors from the array v into res */
+M3D_API void m3dVec2SoaFromArray(Vec2Soa res, const Vec2 *v);
+/** copies v.count vectors from v into the array res */
+M3D_API void m3dVec2SoaToArray(Vec2 *res, Vec2Soa v);
+/** res = a + b for every vector */
+M3D_API void m3dVec2SoaAddVec2Soa(Vec2Soa res, Vec2Soa a, Vec2Soa b);
+/** res = a - b for every vector */
+M3D_API void m3dVec2SoaSubVec2Soa(Vec2Soa res, Vec2Soa a, Vec2Soa b);
+/** res = a * b by component for every vector */
+M3D_API void m3dVec2SoaMulVec2Soa(Vec2Soa res, Vec2Soa a, Vec2Soa b);
+/** res = a * b for every vector */
+M3D_API void m3dVec2SoaMulValue(Vec2Soa res, Vec2Soa a, M3dValue b);
+/** res = a / b for every vector */
+M3D_API void m3dVec2SoaDivValue(Vec2Soa res, Vec2Soa a, M3dValue b);
+/** res = linear interpolation between a and b at value t for every vector */
+M3D_API void m3dVec2SoaLerp(Vec2Soa res, Vec2Soa a, Vec2Soa b, M3dValue t);
+/** writes the dot product of every pair of a and b into res */
+M3D_API void m3dVec2SoaDot(M3dValue *res, Vec2Soa a, Vec2Soa b);
+/** writes the square length of every vector of v into res */
+M3D_API void m3dVec2SoaLengthSqr(M3dValue *res, Vec2Soa v);
+/** writes the length of every vector of v into res */
+M3D_API void m3dVec2SoaLength(M3dValue *res, Vec2Soa v);
+/** res = normalized copy of every vector of v */
+M3D_API void m3dVec2SoaNormalized(Vec2Soa res, Vec2Soa v);
+
+/** copies count vectors from the array v into res */
+M3D_API void m3dVec3SoaFromArray(Vec3Soa res, const Vec3 *v);
+/** copies v.count vectors from v into the array res */
+M3D_API void m3dVec3SoaToArray(Vec3 *res, Vec3Soa v);
+/** res = a + b for every vector */
+M3D_API void m3dVec3SoaAddVec3Soa(Vec3Soa res, Vec3Soa a, Vec3Soa b);
+/** res = a - b for every vector */
+M3D_API void m3dVec3SoaSubVec3Soa(Vec3Soa res, Vec3Soa a, Vec3Soa b);
+/** res = a * b by component for every vector */
+M3D_API void m3dVec3SoaMulVec3Soa(Vec3Soa res, Vec3Soa a, Vec3Soa b);
+/** res = a * b for every vector */
+M3D_API void m3dVec3SoaMulValue(Vec3Soa res, Vec3Soa a, M3dValue b);
+/** res = a / b for every vector */
+M3D_API void m3dVec3SoaDivValue(Vec3Soa res, Vec3Soa a, M3dValue b);
+/** res = linear interpolation between a and b at value t for every vector */
+M3D_API void m3dVec3SoaLerp(Vec3Soa res, Vec3Soa a, Vec3Soa b, M3dValue t);
+/** res = cross product of every pair of a and b, res must not be a or b */
+M3D_API void m3dVec3SoaCross(Vec3Soa res, Vec3Soa a, Vec3Soa b);
+/** writes the dot product of every pair of a and b into res */
+M3D_API void m3dVec3SoaDot(M3dValue *res, Vec3Soa a, Vec3Soa b);
+/** writes the square length of every vector of v into res */
+M3D_API void m3dVec3SoaLengthSqr(M3dValue *res, Vec3Soa v);
+/** writes the length of every vector of v into res */
+M3D_API void m3dVec3SoaLength(M3dValue *res, Vec3Soa v);
+/** res = normalized copy of every vector of v */
+M3D_API void m3dVec3SoaNormalized(Vec3Soa res, Vec3Soa v);
+
+/** copies count vectors from the array v into res */
+M3D_API void m3dVec4SoaFromArray(Vec4Soa res, const Vec4 *v);
+/** copies v.count vectors from v into the array res */
+M3D_API void m3dVec4SoaToArray(Vec4 *res, Vec4Soa v);
+/** res = a + b for every vector */
+M3D_API void m3dVec4SoaAddVec4Soa(Vec4Soa res, Vec4Soa a, Vec4Soa b);
+/** res = a - b for every vector */
+M3D_API void m3dVec4SoaSubVec4Soa(Vec4Soa res, Vec4Soa a, Vec4Soa b);
+/** res = a * b by component for every vector */
+M3D_API void m3dVec4SoaMulVec4Soa(Vec4Soa res, Vec4Soa a, Vec4Soa b);
+/** res = a * b for every vector */
+M3D_API void m3dVec4SoaMulValue(Vec4Soa res, Vec4Soa a, M3dValue b);
+/** res = a / b for every vector */
+M3D_API void m3dVec4SoaDivValue(Vec4Soa res, Vec4Soa a, M3dValue b);
+/** res = linear interpolation between a and b at value t for every vector */
+M3D_API void m3dVec4SoaLerp(Vec4Soa res, Vec4Soa a, Vec4Soa b, M3dValue t);
+/** writes the dot product of every pair of a and b into res */
+M3D_API void m3dVec4SoaDot(M3dValue *res, Vec4Soa a, Vec4Soa b);
+/** writes the square length of every vector of v into res */
+M3D_API void m3dVec4SoaLengthSqr(M3dValue *res, Vec4Soa v);
+/** writes the length of every vector of v into res */
+M3D_API void m3dVec4SoaLength(M3dValue *res, Vec4Soa v);
+/** res = normalized copy of every vector of v */
+M3D_API void m3dVec4SoaNormalized(Vec4Soa res, Vec4Soa v);
+
+#endif // M3D_FIXED
 
 /** ---------------- Quaternion related functions*/
 
@@ -189,88 +644,540 @@ char m3dVec4Equal(Vec4 a, Vec4 b);
     before being passed into the function*/
 
 /** returns the angle in radians between quaternion a and b */
-M3dValue m3dQuatAngle(Quat a, Quat b);
-Quat m3dQuatAngleVec3(Vec3 a, Vec3 b, Vec3 up);
+M3D_API M3dValue m3dQuatAngle(Quat a, Quat b);
+M3D_API Quat m3dQuatAngleVec3(Vec3 a, Vec3 b, Vec3 up);
 /** returns a Quaternion rotated r radians around axis a*/
-Quat m3dQuatAngleAxis(M3dValue r, Vec3 a);
+M3D_API Quat m3dQuatAngleAxis(M3dValue r, Vec3 a);
 /** returns the conjugate of quaternion v */
-Quat m3dQuatConjugate(Quat v);
+M3D_API Quat m3dQuatConjugate(Quat v);
 /** returns the Euler angles of quaternion v */
-Vec3 m3dQuatEuler(Quat v);
-Quat m3dQuatFace(Vec3 dir, Vec3 up);
+M3D_API Vec3 m3dQuatEuler(Quat v);
+M3D_API Quat m3dQuatFace(Vec3 dir, Vec3 up);
+/** returns the quaternion of Euler angles e, rotating by e.x around x, then e.y around y,
+    then e.z around z. the inverse of m3dQuatEuler */
+M3D_API Quat m3dQuatFromEuler(Vec3 e);
+/** returns the rotation of m, whose top left 3x3 has to be a rotation without scale */
+M3D_API Quat m3dQuatFromMat4x4(Mat4x4 m);
 /** returns the unsigned length of quaternion v */
-M3dValue m3dQuatLength(Quat v);
+M3D_API M3dValue m3dQuatLength(Quat v);
 /** returns a quaternion that is a linear interpolation from quaternion a to b at value t */
-Quat m3dQuatLerp(Quat a, Quat b, M3dValue t);
+M3D_API Quat m3dQuatLerp(Quat a, Quat b, M3dValue t);
 /** returns a normalized copy of quaternion v */
-Quat m3dQuatNormalized(Quat v);
-/** returns vector b rotated by quaternion a */
-Vec3 m3dQuatRotateVec3(Quat a, Vec3 b);
-/** returns a quaternion that is a spherical linear interpolation from quaternion a to b at value t */
-Quat m3dQuatSlerp(Quat a, Quat b, M3dValue t);
+M3D_API Quat m3dQuatNormalized(Quat v);
+/** returns vector b rotated by quaternion a, a must be normalized */
+M3D_API Vec3 m3dQuatRotateVec3(Quat a, Vec3 b);
+/** returns a quaternion that is a spherical linear interpolation from quaternion a to b at value t,
+    takes the shorter arc when a and b are more than 180 degrees apart */
+M3D_API Quat m3dQuatSlerp(Quat a, Quat b, M3dValue t);
+/** returns an approximation of m3dQuatSlerp without any trig calls, a normalized lerp with t corrected
+    by a cubic fit. takes the shorter arc as well, the result is normalized and stays within
+    0.0008 radians (0.05 degrees) of the exact rotation for every t and every angle between a and b */
+M3D_API Quat m3dQuatSlerpFast(Quat a, Quat b, M3dValue t);
 
 /** returns quaternion a added to quaternion b*/
-Quat m3dQuatAddQuat(Quat a, Quat b);
+M3D_API Quat m3dQuatAddQuat(Quat a, Quat b);
 /** returns quaternion b subtracted from quaternion a*/
-Quat m3dQuatSubQuat(Quat a, Quat b);
+M3D_API Quat m3dQuatSubQuat(Quat a, Quat b);
 /** returns quaternion a multiplied by quaternion b*/
-Quat m3dQuatMulQuat(Quat a, Quat b);
+M3D_API Quat m3dQuatMulQuat(Quat a, Quat b);
 
 /** returns quaternion a multiplied component wise by b*/
-Quat m3dQuatMulValue(Quat a, M3dValue b);
+M3D_API Quat m3dQuatMulValue(Quat a, M3dValue b);
 /** returns quaternion a divided component wise by b*/
-Quat m3dQuatDivValue(Quat a, M3dValue b);
+M3D_API Quat m3dQuatDivValue(Quat a, M3dValue b);
+
+M3D_API char m3dQuatEqual(Quat a, Quat b);
+
+/** By pointer variants, these avoid copying the operands and the result.
+    A M3D_RESTRICT res must not be any of the inputs, use the InPlace forms for that */
+
+/** res = a * b */
+M3D_API void m3dQuatMulQuatPtr(Quat *M3D_RESTRICT res, const Quat *a, const Quat *b);
+/** a = a * b, b may be a */
+M3D_API void m3dQuatMulQuatInPlace(Quat *a, const Quat *b);
+/** b = a * b, a may be b */
+M3D_API void m3dQuatPreMulQuatInPlace(const Quat *a, Quat *b);
+/** sets v to its conjugate */
+M3D_API void m3dQuatConjugateInPlace(Quat *v);
+/** sets v to its normalized copy */
+M3D_API void m3dQuatNormalizeInPlace(Quat *v);
+/** res = spherical linear interpolation from quaternion a to b at value t */
+M3D_API void m3dQuatSlerpPtr(Quat *M3D_RESTRICT res, const Quat *a, const Quat *b, M3dValue t);
+/** res = approximate spherical linear interpolation, see m3dQuatSlerpFast */
+M3D_API void m3dQuatSlerpFastPtr(Quat *M3D_RESTRICT res, const Quat *a, const Quat *b, M3dValue t);
+/** res = vector b rotated by the normalized quaternion a */
+M3D_API void m3dQuatRotateVec3Ptr(Vec3 *M3D_RESTRICT res, const Quat *a, const Vec3 *b);
+
+/** Batch products of count pairs, res[n] = a[n] * b[n], res must not overlap a or b.
+    Uses sse2 in float builds and avx or avx-512 (two per register) in double builds.
+    sse2 and avx match m3dQuatMulQuatPtr bit for bit, avx-512 fuses the multiply adds
+    so results can differ by up to 3 ulp of the sum of the absolute products */
+
+M3D_API void m3dQuatMulQuatArray(Quat *M3D_RESTRICT res, const Quat *a, const Quat *b, size_t count);
+
+/** Batch rotation of count vectors, by the one quaternion q or by q[n] for each v[n].
+    The quaternions must be normalized and res must not overlap v. Runs 4 vectors per
+    step with sse2 in float builds, matching m3dQuatRotateVec3 bit for bit */
+
+M3D_API void m3dQuatRotateVec3Array(Vec3 *M3D_RESTRICT res, Quat q, const Vec3 *v, size_t count);
+M3D_API void m3dQuatArrayRotateVec3Array(Vec3 *M3D_RESTRICT res, const Quat *q, const Vec3 *v, size_t count);
+
+/** Batch blends of count pairs, res[n] = slerp from a[n] to b[n] at t[n].
+    res must not overlap a or b. The Fast form runs 4 blends per step with sse2 and
+    matches m3dQuatSlerpFast bit for bit */
+
+M3D_API void m3dQuatSlerpArray(Quat *M3D_RESTRICT res, const Quat *a, const Quat *b, const M3dValue *t, size_t count);
+M3D_API void m3dQuatSlerpFastArray(Quat *M3D_RESTRICT res, const Quat *a, const Quat *b, const M3dValue *t, size_t count);
+
+/** Batch construction of count quaternions, with the sincos of m3d1DSinCosArray for 4 at a time */
 
-char m3dQuatEqual(Quat a, Quat b);
+/** res[n] = rotation of r[n] radians around axis a[n] */
+M3D_API void m3dQuatAngleAxisArray(Quat *M3D_RESTRICT res, const M3dValue *r, const Vec3 *a, size_t count);
+/** res[n] = quaternion of the Euler angles e[n] */
+M3D_API void m3dQuatFromEulerArray(Quat *M3D_RESTRICT res, const Vec3 *e, size_t count);
+
+#ifndef M3D_FIXED
+
+/** Smallest three encoding, the largest component is dropped and rebuilt from the other
+    three, which are quantized over [-1 / sqrt(2), 1 / sqrt(2)]. q should be normalized.
+    q and -q encode the same, the decoded quaternion always has a positive largest component.
+    Zero components and so the identity decode exactly. Largest errors of the three stored
+    components, the rebuilt one and the rotation angle, measured over random rotations:
+        32 bit  6.9e-4, 1.9e-3, 4.4e-3 radians
+        48 bit  2.2e-5, 6.1e-5, 1.4e-4 radians
+    The Array forms encode or decode count values, 4 at a time with sse2 in float builds,
+    matching the single versions bit for bit. res must not overlap the input */
+
+M3D_API PackedQuat32 m3dQuatEncode32(Quat q);
+M3D_API Quat m3dQuatDecode32(PackedQuat32 q);
+M3D_API PackedQuat48 m3dQuatEncode48(Quat q);
+M3D_API Quat m3dQuatDecode48(PackedQuat48 q);
+M3D_API void m3dQuatEncode32Array(PackedQuat32 *M3D_RESTRICT res, const Quat *q, size_t count);
+M3D_API void m3dQuatDecode32Array(Quat *M3D_RESTRICT res, const PackedQuat32 *q, size_t count);
+M3D_API void m3dQuatEncode48Array(PackedQuat48 *M3D_RESTRICT res, const Quat *q, size_t count);
+M3D_API void m3dQuatDecode48Array(Quat *M3D_RESTRICT res, const PackedQuat48 *q, size_t count);
 
 /** ---------------- Mat3x3 related functions*/
 
 /** returns the identity matrix */
-Mat3x3 m3dMat3x3InitIdentity();
+M3D_API Mat3x3 m3dMat3x3InitIdentity();
 /** returns an 2d orthographic matrix */
-Mat3x3 m3dMat3x3InitOrtho(M3dValue r, M3dValue l, M3dValue t, M3dValue b);
+M3D_API Mat3x3 m3dMat3x3InitOrtho(M3dValue r, M3dValue l, M3dValue t, M3dValue b);
 /** returns an 2d orthographic matrix centered at the middle of w and h*/
-Mat3x3 m3dMat3x3InitOrthoCentered(M3dValue w, M3dValue h);
+M3D_API Mat3x3 m3dMat3x3InitOrthoCentered(M3dValue w, M3dValue h);
 /** returns a 3d rotation matrix confined in a 3x3 matrix */
-Mat3x3 m3dMat3x3InitRotationFromQuat(Quat quat);
+M3D_API Mat3x3 m3dMat3x3InitRotationFromQuat(Quat quat);
 /** sets the matrix m rotated around z by r, returns copy of m after rotation */
-Mat3x3 m3dMat3x3Rotate(Mat3x3 *m, M3dValue r);
+M3D_API Mat3x3 m3dMat3x3Rotate(Mat3x3 *m, M3dValue r);
 /** sets the matrix m scaled by s, returns copy of m after scaling */
-Mat3x3 m3dMat3x3Scale(Mat3x3 *m, Vec2 s);
+M3D_API Mat3x3 m3dMat3x3Scale(Mat3x3 *m, Vec2 s);
 /** sets the matrix m translated by t, returns copy of m after translation */
-Mat3x3 m3dMat3x3Translate(Mat3x3 *m, Vec2 t);
+M3D_API Mat3x3 m3dMat3x3Translate(Mat3x3 *m, Vec2 t);
 
-Mat3x3 m3dMat3x3FromMat4x4(Mat4x4 m);
+M3D_API Mat3x3 m3dMat3x3FromMat4x4(Mat4x4 m);
+/** returns m with its rows and columns swapped */
+M3D_API Mat3x3 m3dMat3x3Transpose(Mat3x3 m);
 
 /** returns the matrix multiplication of a and b*/
-Mat3x3 m3dMat3x3MulMat3x3(Mat3x3 a, Mat3x3 b);
-Vec3 m3dMat3x3MulVec3(Mat3x3 a, Vec3 b);
+M3D_API Mat3x3 m3dMat3x3MulMat3x3(Mat3x3 a, Mat3x3 b);
+M3D_API Vec3 m3dMat3x3MulVec3(Mat3x3 a, Vec3 b);
+
+/** By pointer variants, these avoid copying the operands and the result.
+    A M3D_RESTRICT res must not be any of the inputs, use the InPlace forms for that */
+
+/** sets res to the identity matrix */
+M3D_API void m3dMat3x3InitIdentityPtr(Mat3x3 *res);
+/** sets the matrix m rotated around z by r */
+M3D_API void m3dMat3x3RotatePtr(Mat3x3 *m, M3dValue r);
+/** sets the matrix m scaled by s */
+M3D_API void m3dMat3x3ScalePtr(Mat3x3 *m, const Vec2 *s);
+/** sets the matrix m translated by t */
+M3D_API void m3dMat3x3TranslatePtr(Mat3x3 *m, const Vec2 *t);
+/** res = a * b */
+M3D_API void m3dMat3x3MulMat3x3Ptr(Mat3x3 *M3D_RESTRICT res, const Mat3x3 *a, const Mat3x3 *b);
+/** a = a * b, b may be a */
+M3D_API void m3dMat3x3MulMat3x3InPlace(Mat3x3 *a, const Mat3x3 *b);
+/** b = a * b, a may be b */
+M3D_API void m3dMat3x3PreMulMat3x3InPlace(const Mat3x3 *a, Mat3x3 *b);
+/** res = a * b */
+M3D_API void m3dMat3x3MulVec3Ptr(Vec3 *M3D_RESTRICT res, const Mat3x3 *a, const Vec3 *b);
+
+/** ---------------- Mat3x4 related functions
+    affine transforms in 3 aligned rows, 25% smaller than a Mat4x4. The multiplies, Ptr
+    and Array forms work on whole aligned sse registers in float builds */
+
+M3D_API Mat3x4 m3dMat3x4InitIdentity();
+/** drops the bottom row of m, which has to be 0 0 0 1 */
+M3D_API Mat3x4 m3dMat3x4FromMat4x4(Mat4x4 m);
+/** returns m with the bottom row 0 0 0 1 added */
+M3D_API Mat4x4 m3dMat4x4FromMat3x4(Mat3x4 m);
+/** returns a * b, a applied after b */
+M3D_API Mat3x4 m3dMat3x4MulMat3x4(Mat3x4 a, Mat3x4 b);
+M3D_API void m3dMat3x4MulMat3x4Ptr(Mat3x4 *M3D_RESTRICT res, const Mat3x4 *a, const Mat3x4 *b);
+/** returns the point v transformed by m, translation included */
+M3D_API Vec3A m3dMat3x4TransformPoint(Mat3x4 m, Vec3A v);
+/** returns the direction v transformed by m, translation ignored */
+M3D_API Vec3A m3dMat3x4TransformDirection(Mat3x4 m, Vec3A v);
+M3D_API void m3dMat3x4TransformPointPtr(Vec3A *M3D_RESTRICT res, const Mat3x4 *m, const Vec3A *v);
+M3D_API void m3dMat3x4TransformDirectionPtr(Vec3A *M3D_RESTRICT res, const Mat3x4 *m, const Vec3A *v);
+/** returns the inverse of m, identity when singular */
+M3D_API Mat3x4 m3dMat3x4Inverse(Mat3x4 m);
+/** res = inverse of m, returns 0 and sets res to identity when m is singular */
+M3D_API char m3dMat3x4InversePtr(Mat3x4 *M3D_RESTRICT res, const Mat3x4 *m);
+/** res[n] = m * v[n] as points for count vectors */
+M3D_API void m3dMat3x4TransformPointArray(Vec3A *M3D_RESTRICT res, Mat3x4 m, const Vec3A *v, size_t count);
+/** res[n] = a[n] * b[n] for count matrices */
+M3D_API void m3dMat3x4MulMat3x4Array(Mat3x4 *M3D_RESTRICT res, const Mat3x4 *a, const Mat3x4 *b, size_t count);
 
 /** ---------------- Mat4x4 related functions*/
 
 /** returns the identity matrix */
-Mat4x4 m3dMat4x4InitIdentity();
+M3D_API Mat4x4 m3dMat4x4InitIdentity();
 /** returns a 3d orthographic matrix */
-Mat4x4 m3dMat4x4InitOrtho(M3dValue r, M3dValue l, M3dValue t, M3dValue b, M3dValue n, M3dValue f);
+M3D_API Mat4x4 m3dMat4x4InitOrtho(M3dValue r, M3dValue l, M3dValue t, M3dValue b, M3dValue n, M3dValue f);
 /** returns a 3d orthographic matrix centered at the middle of the w and h */
-Mat4x4 m3dMat4x4InitOrthoCentered(M3dValue w, M3dValue h, M3dValue n, M3dValue f);
+M3D_API Mat4x4 m3dMat4x4InitOrthoCentered(M3dValue w, M3dValue h, M3dValue n, M3dValue f);
 /** returns a perspective projection matrix*/
-Mat4x4 m3dMat4x4InitPerspective(M3dValue w, M3dValue h, M3dValue fov, M3dValue n, M3dValue f);
+M3D_API Mat4x4 m3dMat4x4InitPerspective(M3dValue w, M3dValue h, M3dValue fov, M3dValue n, M3dValue f);
 /** returns the inverse of a homogeneous matrix, ie: rotation and position ONLY */
-// TODO implement this
-Mat4x4 m3dMat4x4InverseHomogeneous(Mat4x4 mat);
+M3D_API Mat4x4 m3dMat4x4InverseHomogeneous(Mat4x4 mat);
+/** returns the inverse of an affine matrix, ie: bottom row is 0 0 0 1, identity when singular */
+M3D_API Mat4x4 m3dMat4x4InverseAffine(Mat4x4 mat);
+/** returns the inverse of any matrix, identity when singular */
+M3D_API Mat4x4 m3dMat4x4Inverse(Mat4x4 mat);
+/** Rotate, Scale and Translate overwrite their elements of m instead of composing with it,
+    m3dMat4x4FromTrs builds a whole scale, rotation and translation at once */
+
 /** sets the matrix m rotated by r, returns copy of m after rotation */
-Mat4x4 m3dMat4x4Rotate(Mat4x4 *m, Quat r);
-Mat4x4 m3dMat4x4RotateY(Mat4x4 *m, M3dValue r);
+M3D_API Mat4x4 m3dMat4x4Rotate(Mat4x4 *m, Quat r);
+M3D_API Mat4x4 m3dMat4x4RotateY(Mat4x4 *m, M3dValue r);
 /** sets the matrix m scaled by s, returns copy of m after scaling */
-Mat4x4 m3dMat4x4Scale(Mat4x4 *m, Vec3 s);
+M3D_API Mat4x4 m3dMat4x4Scale(Mat4x4 *m, Vec3 s);
 /** sets the matrix m translated by t, returns copy of m after translation */
-Mat4x4 m3dMat4x4Translate(Mat4x4 *m, Vec3 t);
+M3D_API Mat4x4 m3dMat4x4Translate(Mat4x4 *m, Vec3 t);
 
-Mat4x4 m3dMat4x4FromMat3x3(Mat3x3 m);
+M3D_API Mat4x4 m3dMat4x4FromMat3x3(Mat3x3 m);
+/** returns m with its rows and columns swapped, the column major layout of m */
+M3D_API Mat4x4 m3dMat4x4Transpose(Mat4x4 m);
 
-/** returns the matrix multiplication of a and b*/
-Mat4x4 m3dMat4x4MulMat4x4(Mat4x4 a, Mat4x4 b);
-Vec4 m3dMat4x4MulVec4(Mat4x4 a, Vec4 b);
+/** returns the matrix multiplication of a and b.
+    uses sse2, avx or avx2 + fma kernels when available, plus avx-512 in double builds.
+    sse2 and avx match the plain c code bit for bit, fma and avx-512 round once per term
+    so results can differ by up to 4 ulp of the sum of the absolute products */
+M3D_API Mat4x4 m3dMat4x4MulMat4x4(Mat4x4 a, Mat4x4 b);
+/** returns vector b transformed by matrix a, same kernels and precision as m3dMat4x4MulMat4x4 */
+M3D_API Vec4 m3dMat4x4MulVec4(Mat4x4 a, Vec4 b);
+
+/** By pointer variants, these avoid copying the operands and the result.
+    A M3D_RESTRICT res must not be any of the inputs, use the InPlace forms for that */
+
+/** sets res to the identity matrix */
+M3D_API void m3dMat4x4InitIdentityPtr(Mat4x4 *res);
+/** sets the matrix m rotated by r */
+M3D_API void m3dMat4x4RotatePtr(Mat4x4 *m, const Quat *r);
+/** sets the matrix m scaled by s */
+M3D_API void m3dMat4x4ScalePtr(Mat4x4 *m, const Vec3 *s);
+/** sets the matrix m translated by t */
+M3D_API void m3dMat4x4TranslatePtr(Mat4x4 *m, const Vec3 *t);
+/** res = a * b */
+M3D_API void m3dMat4x4MulMat4x4Ptr(Mat4x4 *M3D_RESTRICT res, const Mat4x4 *a, const Mat4x4 *b);
+/** a = a * b, b may be a */
+M3D_API void m3dMat4x4MulMat4x4InPlace(Mat4x4 *a, const Mat4x4 *b);
+/** b = a * b, a may be b */
+M3D_API void m3dMat4x4PreMulMat4x4InPlace(const Mat4x4 *a, Mat4x4 *b);
+/** res = a * b */
+M3D_API void m3dMat4x4MulVec4Ptr(Vec4 *M3D_RESTRICT res, const Mat4x4 *a, const Vec4 *b);
+/** res = inverse of the rotation and position only matrix m */
+M3D_API void m3dMat4x4InverseHomogeneousPtr(Mat4x4 *M3D_RESTRICT res, const Mat4x4 *m);
+/** res = inverse of the affine matrix m, returns 0 and sets res to identity when m is singular */
+M3D_API char m3dMat4x4InverseAffinePtr(Mat4x4 *M3D_RESTRICT res, const Mat4x4 *m);
+/** res = inverse of m, returns 0 and sets res to identity when m is singular.
+    uses an sse2 block-wise cofactor kernel for float builds when available */
+M3D_API char m3dMat4x4InversePtr(Mat4x4 *M3D_RESTRICT res, const Mat4x4 *m);
+/** res = m with its rows and columns swapped */
+M3D_API void m3dMat4x4TransposePtr(Mat4x4 *M3D_RESTRICT res, const Mat4x4 *m);
+
+/** Batch inverses of count matrices from m into res, res must not overlap m.
+    The Affine and general forms return how many matrices were singular */
+
+M3D_API void m3dMat4x4InverseHomogeneousArray(Mat4x4 *M3D_RESTRICT res, const Mat4x4 *m, size_t count);
+M3D_API size_t m3dMat4x4InverseAffineArray(Mat4x4 *M3D_RESTRICT res, const Mat4x4 *m, size_t count);
+M3D_API size_t m3dMat4x4InverseArray(Mat4x4 *M3D_RESTRICT res, const Mat4x4 *m, size_t count);
+
+/** ---------------- Bulk transform functions*/
+
+/** flags for the bulk transforms, POINT and DIRECTION pick the w used for Vec3 and Vec2 input */
+#define M3D_TRANSFORM_POINT         0x0 /** w = 1, translation applies */
+#define M3D_TRANSFORM_DIRECTION     0x1 /** w = 0, translation is ignored */
+#define M3D_TRANSFORM_PERSPECTIVE   0x2 /** divide the result by its w */
+#define M3D_TRANSFORM_STREAM        0x4 /** non temporal stores, for outputs larger than the cache */
+
+/** These transform count vectors from v into res. Strides are in bytes, 0 means packed.
+    res may be v when both strides match, partial overlap is not allowed. The sse2 paths and
+    STREAM are float only, and for Vec3 and Vec2 need both strides packed. Double builds and
+    strided Vec3 or Vec2 buffers silently take the scalar loop with plain stores */
+
+/** res = m * (v, w) for every Vec3 of v, w given by the flags */
+M3D_API void m3dMat4x4TransformVec3Array(Mat4x4 m, Vec3 *res, size_t resStride, const Vec3 *v, size_t stride, size_t count, unsigned int flags);
+/** res = m * v for every Vec4 of v */
+M3D_API void m3dMat4x4TransformVec4Array(Mat4x4 m, Vec4 *res, size_t resStride, const Vec4 *v, size_t stride, size_t count, unsigned int flags);
+/** res = m * v for every Vec3 of v, only the STREAM flag applies */
+M3D_API void m3dMat3x3TransformVec3Array(Mat3x3 m, Vec3 *res, size_t resStride, const Vec3 *v, size_t stride, size_t count, unsigned int flags);
+/** res = m * (v, w) for every 2d Vec2 of v, w given by the flags */
+M3D_API void m3dMat3x3TransformVec2Array(Mat3x3 m, Vec2 *res, size_t resStride, const Vec2 *v, size_t stride, size_t count, unsigned int flags);
+
+/** ---------------- Layout export functions*/
+
+/** In float builds an array of Mat4x4 already is row major float data and can be uploaded
+    as it is to shaders declaring their matrices row major, these are for the consumers
+    that can't. The Export forms write count matrices of m as float straight into res,
+    which may be a mapped upload buffer, converting from double in double builds. Only the
+    STREAM flag applies, it writes around the cache when res is 16 byte aligned */
+
+/** res[n] = the transpose of m[n] for count matrices, res must not overlap m */
+M3D_API void m3dMat4x4TransposeArray(Mat4x4 *M3D_RESTRICT res, const Mat4x4 *m, size_t count);
+/** 16 floats per matrix, row after row */
+M3D_API void m3dMat4x4ExportRowMajor(float *M3D_RESTRICT res, const Mat4x4 *m, size_t count, unsigned int flags);
+/** 16 floats per matrix, column after column, the layout of opengl and vulkan defaults */
+M3D_API void m3dMat4x4ExportColumnMajor(float *M3D_RESTRICT res, const Mat4x4 *m, size_t count, unsigned int flags);
+/** 12 floats per matrix, the top three rows of affine matrices, the layout of Mat3x4 in
+    float builds and of the 3x4 instance transforms of most gpu apis */
+M3D_API void m3dMat4x4ExportRows3x4(float *M3D_RESTRICT res, const Mat4x4 *m, size_t count, unsigned int flags);
+
+/** ---------------- TRS composition functions*/
+
+/** T * R * S written directly: the rotation of the normalized quaternion r with its
+    columns scaled by s and t as the translation, no matrix multiplies.
+    Transforms a point by scaling it, then rotating, then translating */
+
+M3D_API Mat4x4 m3dMat4x4FromTrs(Vec3 t, Quat r, Vec3 s);
+M3D_API void m3dMat4x4FromTrsPtr(Mat4x4 *M3D_RESTRICT res, const Vec3 *t, const Quat *r, const Vec3 *s);
+M3D_API Mat3x4 m3dMat3x4FromTrs(Vec3 t, Quat r, Vec3 s);
+M3D_API void m3dMat3x4FromTrsPtr(Mat3x4 *M3D_RESTRICT res, const Vec3 *t, const Quat *r, const Vec3 *s);
+
+/** Batch forms for t.count instances into the contiguous matrices of res, r and s hold at
+    least as many. 4 instances per step with sse2 in float builds, matching the single forms
+    bit for bit, and large batches are split across threads when built with openmp */
+
+M3D_API void m3dMat4x4FromTrsSoa(Mat4x4 *M3D_RESTRICT res, Vec3Soa t, QuatSoa r, Vec3Soa s);
+M3D_API void m3dMat3x4FromTrsSoa(Mat3x4 *M3D_RESTRICT res, Vec3Soa t, QuatSoa r, Vec3Soa s);
+
+/** ---------------- Dual quaternion functions*/
+
+/** Rotation and translation without scale. Blending dual quaternions keeps rigid
+    transforms rigid, where blending matrices shrinks the volume around twisting joints */
+
+M3D_API DualQuat m3dDualQuatInitIdentity();
+/** returns the transform rotating by the normalized quaternion r, then translating by t.
+    A TRS converts by its t and r, scale can't be represented */
+M3D_API DualQuat m3dDualQuatFromTr(Vec3 t, Quat r);
+/** returns the transform of m, whose top left 3x3 has to be a rotation without scale */
+M3D_API DualQuat m3dDualQuatFromMat4x4(Mat4x4 m);
+M3D_API Mat4x4 m3dDualQuatToMat4x4(DualQuat d);
+/** returns the translation of the normalized d */
+M3D_API Vec3 m3dDualQuatTranslation(DualQuat d);
+/** returns the transform doing b, then a */
+M3D_API DualQuat m3dDualQuatMulDualQuat(DualQuat a, DualQuat b);
+M3D_API void m3dDualQuatMulDualQuatPtr(DualQuat *M3D_RESTRICT res, const DualQuat *a, const DualQuat *b);
+/** returns d with a unit real part and the dual part made orthogonal to it */
+M3D_API DualQuat m3dDualQuatNormalized(DualQuat d);
+/** returns the normalized weighted sum of count dual quaternions, each negated when its real
+    part points away from that of d[0] so every blend takes the short way */
+M3D_API DualQuat m3dDualQuatBlend(const DualQuat *d, const M3dValue *weights, size_t count);
+/** returns the blend of a with weight 1 - t and b with weight t */
+M3D_API DualQuat m3dDualQuatLerp(DualQuat a, DualQuat b, M3dValue t);
+/** these take a normalized d */
+M3D_API Vec3 m3dDualQuatTransformPoint(DualQuat d, Vec3 p);
+M3D_API void m3dDualQuatTransformPointPtr(Vec3 *M3D_RESTRICT res, const DualQuat *d, const Vec3 *p);
+M3D_API Vec3 m3dDualQuatTransformDirection(DualQuat d, Vec3 v);
+
+/** Dual quaternion skinning of count vertices. Vertex n has the 4 influences bones[4 * n + k]
+    into palette with weights[4 * n + k], unused influences have weight 0 and any valid bone.
+    The weights of a vertex should sum to 1 and must not cancel out. With the DIRECTION flag
+    the translation is ignored, for normals and tangents, the other flags don't apply.
+    res may be v. Float builds skin 4 vertices per step with sse2, matching the scalar path
+    bit for bit, and large buffers are split across threads when built with openmp */
+
+M3D_API void m3dDualQuatSkinVec3Array(Vec3 *res, const Vec3 *v, const uint16_t *bones, const M3dValue *weights, const DualQuat *palette, size_t count, unsigned int flags);
+
+/** ---------------- 2D sprite batch functions*/
+
+/** 2d T * R * S for sprites: the rotation of m3dMat3x3Rotate by r radians with its columns
+    scaled by s and t as the translation. Transforms a point by scaling it, then rotating,
+    then translating */
+M3D_API Mat3x3 m3dMat3x3FromTrs(Vec2 t, M3dValue r, Vec2 s);
+/** m3dMat3x3FromTrs for t.count sprites into res, r and s hold at least as many. Float
+    builds take the sincos of m3d1DSinCosArray for 4 at a time, rotations of 8192 radians
+    or more go through the scalar sin and cos, so any r matches m3dMat3x3FromTrs */
+M3D_API void m3dMat3x3FromTrsSoa(Mat3x3 *M3D_RESTRICT res, Vec2Soa t, const M3dValue *r, Vec2Soa s);
+/** Writes the 4 vertices of every one of the t.count sprites into res, which needs room for
+    4 * t.count, vertex k of sprite n at res[4 * n + k] = camera * T * R * S * corners[k].
+    corners is the quad in sprite space, like the unit square around the pivot. camera is
+    an affine matrix like m3dMat3x3InitOrtho and is folded into every sprite's matrix, so
+    each vertex costs 4 multiplies. Float builds do 4 sprites per step with sse2 and the
+    sincos of m3d1DSinCosArray, large batches are split across threads when built with
+    openmp. Only the STREAM flag applies, it writes around the cache when res is 16 byte
+    aligned */
+M3D_API void m3dMat3x3TransformSpriteQuads(Mat3x3 camera, Vec2 *M3D_RESTRICT res, Vec2Soa t, const M3dValue *r, Vec2Soa s, const Vec2 *corners, unsigned int flags);
+
+/** ---------------- Frustum functions*/
+
+/** returns the planes of the view volume of a projection or view projection matrix,
+    for the -w to w clip space of m3dMat4x4InitPerspective and m3dMat4x4InitOrtho */
+M3D_API Frustum m3dFrustumFromMat4x4(Mat4x4 m);
+/** returns 1 when the sphere is at least partly inside f */
+M3D_API char m3dFrustumSphereVisible(Frustum f, Vec3 center, M3dValue radius);
+/** returns 1 when the box of half size extents around center is at least partly inside f */
+M3D_API char m3dFrustumAabbVisible(Frustum f, Vec3 center, Vec3 extents);
+
+/** Batch culling of centers.count objects, conservative like the single tests: objects near
+    a corner of the frustum may be kept even though they are outside. The mask forms set bit
+    n % 32 of mask[n / 32] for every visible object n, mask needs (count + 31) / 32 words.
+    The Indices forms write the indices of the visible objects in order into res, which
+    needs room for count, and return how many there are. Float builds test 4 objects per
+    step with sse2 and 8 with avx, with the same results as the single tests. Objects with
+    a NaN in their position or size are culled */
+
+M3D_API void m3dFrustumCullSpheres(uint32_t *M3D_RESTRICT mask, Frustum f, Vec3Soa centers, const M3dValue *radius);
+M3D_API void m3dFrustumCullAabbs(uint32_t *M3D_RESTRICT mask, Frustum f, Vec3Soa centers, Vec3Soa extents);
+M3D_API size_t m3dFrustumCullSpheresIndices(uint32_t *M3D_RESTRICT res, Frustum f, Vec3Soa centers, const M3dValue *radius);
+M3D_API size_t m3dFrustumCullAabbsIndices(uint32_t *M3D_RESTRICT res, Frustum f, Vec3Soa centers, Vec3Soa extents);
+
+/** ---------------- Aabb and bounding volume hierarchy functions*/
+
+/** returns the box around both a and b */
+M3D_API Aabb m3dAabbUnion(Aabb a, Aabb b);
+/** returns 1 when p is inside a or on its surface */
+M3D_API char m3dAabbContainsVec3(Aabb a, Vec3 p);
+/** returns 1 when a and b overlap or touch */
+M3D_API char m3dAabbOverlaps(Aabb a, Aabb b);
+/** returns 1 when origin + t * dir is in a for some 0 <= t <= maxT, and the smallest such t
+    in t when it is not NULL. dir does not have to be normalized */
+M3D_API char m3dAabbRay(Aabb a, Vec3 origin, Vec3 dir, M3dValue maxT, M3dValue *t);
+
+/** builds the hierarchy over bvh->bounds with the binned surface area heuristic and returns
+    bvh->nodeCount. large builds are split across threads when the library is built with
+    openmp (-fopenmp), the tree is the same but its node order can differ between runs */
+M3D_API size_t m3dBvhBuild(M3dBvh *bvh);
+/** returns the closest object hit by origin + t * dir for 0 <= t < *maxT and sets *maxT to
+    its t, or returns M3D_BVH_NONE. hit tests the objects whose box the ray enters, with
+    user passed along; without one the object boxes are the hits. For line of sight tests
+    hit can return 0 to stop at the first hit */
+M3D_API uint32_t m3dBvhRaycast(M3dBvh bvh, Vec3 origin, Vec3 dir, M3dValue *maxT, M3dBvhRayFunc hit, void *user);
+
+/** The query forms write the indices of the objects whose box contains p, overlaps box or
+    is hit by origin + t * dir for 0 <= t <= maxT into res, at most capacity of them in no
+    particular order, and return how many objects there are in total */
+
+M3D_API size_t m3dBvhQueryVec3(uint32_t *M3D_RESTRICT res, size_t capacity, M3dBvh bvh, Vec3 p);
+M3D_API size_t m3dBvhQueryAabb(uint32_t *M3D_RESTRICT res, size_t capacity, M3dBvh bvh, Aabb box);
+M3D_API size_t m3dBvhQueryRay(uint32_t *M3D_RESTRICT res, size_t capacity, M3dBvh bvh, Vec3 origin, Vec3 dir, M3dValue maxT);
+
+#endif // M3D_FIXED
+
+/** ---------------- Arena functions*/
+
+/** allocates size bytes for a, returns 0 when malloc fails or size leaves no room for the alignment */
+M3D_API char m3dArenaInit(M3dArena *a, size_t size);
+/** uses size bytes of buffer for a, the part before its first aligned address is skipped */
+M3D_API void m3dArenaInitBuffer(M3dArena *a, void *buffer, size_t size);
+/** frees the memory of m3dArenaInit, buffers given to m3dArenaInitBuffer stay untouched */
+M3D_API void m3dArenaFree(M3dArena *a);
+/** returns size bytes aligned to M3D_ARENA_ALIGN, or NULL when a is full */
+M3D_API void *m3dArenaAlloc(M3dArena *a, size_t size);
+/** returns size bytes aligned to align, a power of two, or NULL when a is full */
+M3D_API void *m3dArenaAllocAligned(M3dArena *a, size_t size, size_t align);
+/** returns the current fill of a, m3dArenaRelease with it frees everything allocated after */
+M3D_API size_t m3dArenaMark(const M3dArena *a);
+M3D_API void m3dArenaRelease(M3dArena *a, size_t mark);
+/** frees every allocation of a, usually once per frame. a->peak keeps the largest fill seen */
+M3D_API void m3dArenaReset(M3dArena *a);
+
+/** Typed forms, NULL or a Soa with NULL components when a is full or count is too large
+    for a size_t byte count. Every Soa component
+    array starts on its own M3D_ARENA_ALIGN boundary and is padded up to the next one, so
+    simd loops can read whole vectors past count */
+
+M3D_API Vec3 *m3dArenaAllocVec3(M3dArena *a, size_t count);
+M3D_API Quat *m3dArenaAllocQuat(M3dArena *a, size_t count);
+M3D_API Mat4x4 *m3dArenaAllocMat4x4(M3dArena *a, size_t count);
+M3D_API Vec3Soa m3dArenaAllocVec3Soa(M3dArena *a, size_t count);
+M3D_API Vec4Soa m3dArenaAllocVec4Soa(M3dArena *a, size_t count);
+M3D_API QuatSoa m3dArenaAllocQuatSoa(M3dArena *a, size_t count);
+
+#ifndef M3D_FIXED
+
+/** ---------------- Transform hierarchy functions*/
+
+/** finds where each depth level of h starts from the parent array, sets h->levelCount
+    and returns it, or returns 0 when the nodes are not sorted by depth */
+M3D_API size_t m3dHierarchyBuildLevels(M3dHierarchy *h);
+/** computes the world matrix of every node, one level at a time. levels with many nodes
+    are split across threads when the library is built with openmp (-fopenmp) */
+M3D_API void m3dHierarchyUpdate(M3dHierarchy h);
+/** computes the world matrices of the nodes begin to end, all in one level, once their
+    parents are done. lets a job system run the levels of m3dHierarchyUpdate itself */
+M3D_API void m3dHierarchyUpdateRange(M3dHierarchy h, size_t begin, size_t end);
+
+/** ---------------- Linear blend skinning functions*/
+
+/** Each vertex is transformed by the weighted sum of its bone matrices, positions with
+    the translation and normals without. Normals are not renormalized and only stay
+    perpendicular for bones without non uniform scale. Float builds blend whole matrix rows
+    with sse2 and skin 4 vertices per step, matching the scalar path bit for bit */
+
+/** skins every vertex of s, split across threads when built with openmp (-fopenmp) */
+M3D_API void m3dSkinUpdate(M3dSkin s);
+/** skins the vertices begin to end of s, lets a job system split the mesh itself */
+M3D_API void m3dSkinUpdateRange(M3dSkin s, size_t begin, size_t end);
+
+#endif // M3D_FIXED
+
+/** ---------------- Profiling functions*/
+
+/** writes the totals of up to capacity functions into res in the order they were first
+    called and returns how many it wrote. Cheap enough to call every frame */
+M3D_API size_t m3dProfileSnapshot(M3dProfileEntry *res, size_t capacity);
+/** starts every count from 0 again, calls running at the same time may land on either side */
+M3D_API void m3dProfileReset();
+/** Write the snapshot, most cycles then most calls first, as an aligned text table or as
+    {"functions":[{"name":..,"calls":..,"cycles":..},..]} into res. Like snprintf they write
+    at most size bytes, terminated when size is not 0, and return the length of the whole
+    output, so a call with size 0 measures it */
+M3D_API size_t m3dProfileFormatText(char *res, size_t size);
+M3D_API size_t m3dProfileFormatJson(char *res, size_t size);
+
+#if defined(M3D_INLINE) || defined(M3D_IMPLEMENTATION)
+#if defined(__GNUC__) || defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#endif
+#include "../cpu.c"
+#include "../math1D.c"
+#include "../vec2.c"
+#include "../vec3.c"
+#include "../vec4.c"
+#include "../vec3a.c"
+#include "../vecsoa.c"
+#include "../quat.c"
+#include "../mat3x3.c"
+#include "../mat4x4.c"
+#include "../mat3x4.c"
+#include "../transform.c"
+#include "../export.c"
+#include "../sprite.c"
+#include "../trs.c"
+#include "../dualquat.c"
+#include "../hierarchy.c"
+#include "../skin.c"
+#include "../compress.c"
+#include "../frustum.c"
+#include "../bvh.c"
+#include "../arena.c"
+#include "../profile.c"
+#if defined(__GNUC__) || defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif // M3D_INLINE || M3D_IMPLEMENTATION
 
 #endif // M3D_H
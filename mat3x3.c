@@ -1,8 +1,11 @@
 #include "m3d/m3d.h"
+#include "internal.h"
 #include <math.h>
 #include <stdint.h>
 
-static void setAllZeroInternal(Mat3x3 *v)
+#ifndef M3D_FIXED
+
+static void setAllZero3x3Internal(Mat3x3 *v)
 {
     for(int i = 0; i < 3; i++)
     {
@@ -13,25 +16,21 @@ static void setAllZeroInternal(Mat3x3 *v)
     }
 }
 
-Mat3x3 m3dMat3x3InitIdentity()
+M3D_API Mat3x3 m3dMat3x3InitIdentity()
 {
+    M3D_PROFILE_FUNCTION();
     Mat3x3 res;
 
-    setAllZeroInternal(&res);
-
-    // set diagonal to 1s
-    for(int i = 0; i < 3; i++)
-    {
-        res.m[i][i] = 1;
-    }
+    m3dMat3x3InitIdentityPtr(&res);
 
     return res;
 }
 
-Mat3x3 m3dMat3x3InitOrtho(M3dValue r, M3dValue l, M3dValue t, M3dValue b)
+M3D_API Mat3x3 m3dMat3x3InitOrtho(M3dValue r, M3dValue l, M3dValue t, M3dValue b)
 {
+    M3D_PROFILE_FUNCTION();
     Mat3x3 res;
-    setAllZeroInternal(&res);
+    setAllZero3x3Internal(&res);
 
     M3dValue rml = 1.0 / (r - l);
     M3dValue tmb = 1.0 / (t - b);
@@ -45,10 +44,11 @@ Mat3x3 m3dMat3x3InitOrtho(M3dValue r, M3dValue l, M3dValue t, M3dValue b)
     return res;
 }
 
-Mat3x3 m3dMat3x3InitOrthoCentered(M3dValue w, M3dValue h)
+M3D_API Mat3x3 m3dMat3x3InitOrthoCentered(M3dValue w, M3dValue h)
 {
+    M3D_PROFILE_FUNCTION();
     Mat3x3 res;
-    setAllZeroInternal(&res);
+    setAllZero3x3Internal(&res);
 
     res.m[0][0] = 2.0 / w;
     res.m[1][1] = 2.0 / h;
@@ -57,8 +57,9 @@ Mat3x3 m3dMat3x3InitOrthoCentered(M3dValue w, M3dValue h)
     return res;
 }
 
-Mat3x3 m3dMat3x3InitRotationFromQuat(Quat quat)
+M3D_API Mat3x3 m3dMat3x3InitRotationFromQuat(Quat quat)
 {
+    M3D_PROFILE_FUNCTION();
     Mat3x3 res;
 
     // precalc most parts
@@ -81,37 +82,33 @@ Mat3x3 m3dMat3x3InitRotationFromQuat(Quat quat)
     return res;
 }
 
-Mat3x3 m3dMat3x3Rotate(Mat3x3 *m, M3dValue r)
+M3D_API Mat3x3 m3dMat3x3Rotate(Mat3x3 *m, M3dValue r)
 {
-    M3dValue cosTheta = cos(r);
-    M3dValue sinTheta = sin(r);
-
-    m->m[0][0] = cosTheta;
-    m->m[0][1] = -sinTheta;
-    m->m[1][0] = sinTheta;
-    m->m[1][1] = cosTheta;
+    M3D_PROFILE_FUNCTION();
+    m3dMat3x3RotatePtr(m, r);
 
     return *m;
 }
 
-Mat3x3 m3dMat3x3Scale(Mat3x3 *m, Vec2 s)
+M3D_API Mat3x3 m3dMat3x3Scale(Mat3x3 *m, Vec2 s)
 {
-    m->m[0][0] = s.x;
-    m->m[1][1] = s.y;
+    M3D_PROFILE_FUNCTION();
+    m3dMat3x3ScalePtr(m, &s);
 
     return *m;
 }
 
-Mat3x3 m3dMat3x3Translate(Mat3x3 *m, Vec2 t)
+M3D_API Mat3x3 m3dMat3x3Translate(Mat3x3 *m, Vec2 t)
 {
-    m->m[0][2] = t.x;
-    m->m[1][2] = t.y;
+    M3D_PROFILE_FUNCTION();
+    m3dMat3x3TranslatePtr(m, &t);
 
     return *m;
 }
 
-Mat3x3 m3dMat3x3FromMat4x4(Mat4x4 m)
+M3D_API Mat3x3 m3dMat3x3FromMat4x4(Mat4x4 m)
 {
+    M3D_PROFILE_FUNCTION();
     Mat3x3 res;
 
     for(int i = 0; i < 3; i++)
@@ -125,10 +122,85 @@ Mat3x3 m3dMat3x3FromMat4x4(Mat4x4 m)
     return res;
 }
 
-Mat3x3 m3dMat3x3MulMat3x3(Mat3x3 a, Mat3x3 b)
+M3D_API Mat3x3 m3dMat3x3Transpose(Mat3x3 m)
+{
+    M3D_PROFILE_FUNCTION();
+    Mat3x3 res;
+
+    for(int i = 0; i < 3; i++)
+    {
+        for(int j = 0; j < 3; j++)
+        {
+            res.m[i][j] = m.m[j][i];
+        }
+    }
+
+    return res;
+}
+
+M3D_API Mat3x3 m3dMat3x3MulMat3x3(Mat3x3 a, Mat3x3 b)
 {
+    M3D_PROFILE_FUNCTION();
     Mat3x3 res;
 
+    m3dMat3x3MulMat3x3Ptr(&res, &a, &b);
+
+    return res;
+}
+
+M3D_API Vec3 m3dMat3x3MulVec3(Mat3x3 a, Vec3 b)
+{
+    M3D_PROFILE_FUNCTION();
+    Vec3 res;
+
+    m3dMat3x3MulVec3Ptr(&res, &a, &b);
+
+    return res;
+}
+
+/** ---------------- by pointer variants */
+
+M3D_API void m3dMat3x3InitIdentityPtr(Mat3x3 *res)
+{
+    M3D_PROFILE_FUNCTION();
+    setAllZero3x3Internal(res);
+
+    // set diagonal to 1s
+    for(int i = 0; i < 3; i++)
+    {
+        res->m[i][i] = 1;
+    }
+}
+
+M3D_API void m3dMat3x3RotatePtr(Mat3x3 *m, M3dValue r)
+{
+    M3D_PROFILE_FUNCTION();
+    M3dValue cosTheta = m3dCosInternal(r);
+    M3dValue sinTheta = m3dSinInternal(r);
+
+    m->m[0][0] = cosTheta;
+    m->m[0][1] = -sinTheta;
+    m->m[1][0] = sinTheta;
+    m->m[1][1] = cosTheta;
+}
+
+M3D_API void m3dMat3x3ScalePtr(Mat3x3 *m, const Vec2 *s)
+{
+    M3D_PROFILE_FUNCTION();
+    m->m[0][0] = s->x;
+    m->m[1][1] = s->y;
+}
+
+M3D_API void m3dMat3x3TranslatePtr(Mat3x3 *m, const Vec2 *t)
+{
+    M3D_PROFILE_FUNCTION();
+    m->m[0][2] = t->x;
+    m->m[1][2] = t->y;
+}
+
+M3D_API void m3dMat3x3MulMat3x3Ptr(Mat3x3 *M3D_RESTRICT res, const Mat3x3 *a, const Mat3x3 *b)
+{
+    M3D_PROFILE_FUNCTION();
     for (uint8_t i = 0 ; i < 3 ; i++ )
     {
         for (uint8_t j = 0 ; j < 3 ; j++ )
@@ -136,23 +208,40 @@ Mat3x3 m3dMat3x3MulMat3x3(Mat3x3 a, Mat3x3 b)
             M3dValue sum = 0;
             for (uint8_t k = 0 ; k < 3 ; k++ )
             {
-                sum += a.m[i][k] * b.m[k][j];
+                sum += a->m[i][k] * b->m[k][j];
             }
 
-            res.m[i][j] = sum;
+            res->m[i][j] = sum;
         }
     }
+}
 
-    return res;
+M3D_API void m3dMat3x3MulMat3x3InPlace(Mat3x3 *a, const Mat3x3 *b)
+{
+    M3D_PROFILE_FUNCTION();
+    Mat3x3 res;
+
+    m3dMat3x3MulMat3x3Ptr(&res, a, b);
+
+    *a = res;
 }
 
-Vec3 m3dMat3x3MulVec3(Mat3x3 a, Vec3 b)
+M3D_API void m3dMat3x3PreMulMat3x3InPlace(const Mat3x3 *a, Mat3x3 *b)
 {
-    Vec3 res;
+    M3D_PROFILE_FUNCTION();
+    Mat3x3 res;
 
-    res.x = a.m[0][0] * b.x + a.m[0][1] * b.y + a.m[0][2] * b.z;
-    res.y = a.m[1][0] * b.x + a.m[1][1] * b.y + a.m[1][2] * b.z;
-    res.z = a.m[2][0] * b.x + a.m[2][1] * b.y + a.m[2][2] * b.z;
+    m3dMat3x3MulMat3x3Ptr(&res, a, b);
 
-    return res;
+    *b = res;
 }
+
+M3D_API void m3dMat3x3MulVec3Ptr(Vec3 *M3D_RESTRICT res, const Mat3x3 *a, const Vec3 *b)
+{
+    M3D_PROFILE_FUNCTION();
+    res->x = a->m[0][0] * b->x + a->m[0][1] * b->y + a->m[0][2] * b->z;
+    res->y = a->m[1][0] * b->x + a->m[1][1] * b->y + a->m[1][2] * b->z;
+    res->z = a->m[2][0] * b->x + a->m[2][1] * b->y + a->m[2][2] * b->z;
+}
+
+#endif // M3D_FIXED
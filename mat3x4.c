@@ -0,0 +1,248 @@
+#include "m3d/m3d.h"
+#include "internal.h"
+
+#ifndef M3D_FIXED
+
+/** the rows are 16 byte aligned in float builds, so every kernel works on whole rows
+    and the implied bottom row 0 0 0 1 only shows up as the translation lane */
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+#define MAT3X4_SSE2
+#endif
+
+M3D_API Mat3x4 m3dMat3x4InitIdentity()
+{
+    M3D_PROFILE_FUNCTION();
+    Mat3x4 res = {{
+        {1, 0, 0, 0},
+        {0, 1, 0, 0},
+        {0, 0, 1, 0}
+    }};
+
+    return res;
+}
+
+M3D_API Mat3x4 m3dMat3x4FromMat4x4(Mat4x4 m)
+{
+    M3D_PROFILE_FUNCTION();
+    Mat3x4 res;
+
+    for(int i = 0; i < 3; i++)
+    {
+        for(int j = 0; j < 4; j++)
+        {
+            res.m[i][j] = m.m[i][j];
+        }
+    }
+
+    return res;
+}
+
+M3D_API Mat4x4 m3dMat4x4FromMat3x4(Mat3x4 m)
+{
+    M3D_PROFILE_FUNCTION();
+    Mat4x4 res;
+
+    for(int i = 0; i < 3; i++)
+    {
+        for(int j = 0; j < 4; j++)
+        {
+            res.m[i][j] = m.m[i][j];
+        }
+    }
+
+    res.m[3][0] = 0;
+    res.m[3][1] = 0;
+    res.m[3][2] = 0;
+    res.m[3][3] = 1;
+
+    return res;
+}
+
+M3D_API void m3dMat3x4MulMat3x4Ptr(Mat3x4 *M3D_RESTRICT res, const Mat3x4 *a, const Mat3x4 *b)
+{
+    M3D_PROFILE_FUNCTION();
+#ifdef MAT3X4_SSE2
+    __m128 b0 = _mm_load_ps(b->m[0]);
+    __m128 b1 = _mm_load_ps(b->m[1]);
+    __m128 b2 = _mm_load_ps(b->m[2]);
+
+    for(int i = 0; i < 3; i++)
+    {
+        // the 0 0 0 1 row of b adds a[i][3] to the translation lane only
+        __m128 r = _mm_mul_ps(_mm_set1_ps(a->m[i][0]), b0);
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a->m[i][1]), b1));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a->m[i][2]), b2));
+        r = _mm_add_ps(r, _mm_set_ps(a->m[i][3], 0, 0, 0));
+        _mm_store_ps(res->m[i], r);
+    }
+#else
+    for(int i = 0; i < 3; i++)
+    {
+        for(int j = 0; j < 4; j++)
+        {
+            res->m[i][j] = a->m[i][0] * b->m[0][j] + a->m[i][1] * b->m[1][j] + a->m[i][2] * b->m[2][j];
+        }
+
+        res->m[i][3] += a->m[i][3];
+    }
+#endif // MAT3X4_SSE2
+}
+
+M3D_API Mat3x4 m3dMat3x4MulMat3x4(Mat3x4 a, Mat3x4 b)
+{
+    M3D_PROFILE_FUNCTION();
+    Mat3x4 res;
+
+    m3dMat3x4MulMat3x4Ptr(&res, &a, &b);
+
+    return res;
+}
+
+#ifdef MAT3X4_SSE2
+
+// the three row products transposed into columns and summed, w is what v carries in w
+static inline __m128 transformSse2(const Mat3x4 *m, __m128 v)
+{
+    __m128 r0 = _mm_mul_ps(_mm_load_ps(m->m[0]), v);
+    __m128 r1 = _mm_mul_ps(_mm_load_ps(m->m[1]), v);
+    __m128 r2 = _mm_mul_ps(_mm_load_ps(m->m[2]), v);
+    __m128 r3 = _mm_setzero_ps();
+
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+    return _mm_add_ps(_mm_add_ps(_mm_add_ps(r0, r1), r2), r3);
+}
+
+#endif // MAT3X4_SSE2
+
+// plain c for the by value forms, see vec3a.c for why
+M3D_API Vec3A m3dMat3x4TransformPoint(Mat3x4 m, Vec3A v)
+{
+    M3D_PROFILE_FUNCTION();
+    Vec3A res;
+    res.x = m.m[0][0] * v.x + m.m[0][1] * v.y + m.m[0][2] * v.z + m.m[0][3];
+    res.y = m.m[1][0] * v.x + m.m[1][1] * v.y + m.m[1][2] * v.z + m.m[1][3];
+    res.z = m.m[2][0] * v.x + m.m[2][1] * v.y + m.m[2][2] * v.z + m.m[2][3];
+    res.w = 0;
+    return res;
+}
+
+M3D_API Vec3A m3dMat3x4TransformDirection(Mat3x4 m, Vec3A v)
+{
+    M3D_PROFILE_FUNCTION();
+    Vec3A res;
+    res.x = m.m[0][0] * v.x + m.m[0][1] * v.y + m.m[0][2] * v.z;
+    res.y = m.m[1][0] * v.x + m.m[1][1] * v.y + m.m[1][2] * v.z;
+    res.z = m.m[2][0] * v.x + m.m[2][1] * v.y + m.m[2][2] * v.z;
+    res.w = 0;
+    return res;
+}
+
+M3D_API void m3dMat3x4TransformPointPtr(Vec3A *M3D_RESTRICT res, const Mat3x4 *m, const Vec3A *v)
+{
+    M3D_PROFILE_FUNCTION();
+#ifdef MAT3X4_SSE2
+    __m128 p = _mm_add_ps(_mm_load_ps(&v->x), _mm_set_ps(1, 0, 0, 0));
+    _mm_store_ps(&res->x, transformSse2(m, p));
+#else
+    *res = m3dMat3x4TransformPoint(*m, *v);
+#endif // MAT3X4_SSE2
+}
+
+M3D_API void m3dMat3x4TransformDirectionPtr(Vec3A *M3D_RESTRICT res, const Mat3x4 *m, const Vec3A *v)
+{
+    M3D_PROFILE_FUNCTION();
+#ifdef MAT3X4_SSE2
+    _mm_store_ps(&res->x, transformSse2(m, _mm_load_ps(&v->x)));
+#else
+    *res = m3dMat3x4TransformDirection(*m, *v);
+#endif // MAT3X4_SSE2
+}
+
+M3D_API char m3dMat3x4InversePtr(Mat3x4 *M3D_RESTRICT res, const Mat3x4 *m)
+{
+    M3D_PROFILE_FUNCTION();
+    const M3dValue (*a)[4] = m->m;
+
+    // cofactors of the 3x3 part, transposed into the adjugate
+    M3dValue c00 = a[1][1] * a[2][2] - a[1][2] * a[2][1];
+    M3dValue c01 = a[1][2] * a[2][0] - a[1][0] * a[2][2];
+    M3dValue c02 = a[1][0] * a[2][1] - a[1][1] * a[2][0];
+
+    M3dValue det = a[0][0] * c00 + a[0][1] * c01 + a[0][2] * c02;
+
+    if(det == 0)
+    {
+        *res = m3dMat3x4InitIdentity();
+        return 0;
+    }
+
+    M3dValue inv = 1 / det;
+
+    res->m[0][0] = c00 * inv;
+    res->m[1][0] = c01 * inv;
+    res->m[2][0] = c02 * inv;
+    res->m[0][1] = (a[0][2] * a[2][1] - a[0][1] * a[2][2]) * inv;
+    res->m[1][1] = (a[0][0] * a[2][2] - a[0][2] * a[2][0]) * inv;
+    res->m[2][1] = (a[0][1] * a[2][0] - a[0][0] * a[2][1]) * inv;
+    res->m[0][2] = (a[0][1] * a[1][2] - a[0][2] * a[1][1]) * inv;
+    res->m[1][2] = (a[0][2] * a[1][0] - a[0][0] * a[1][2]) * inv;
+    res->m[2][2] = (a[0][0] * a[1][1] - a[0][1] * a[1][0]) * inv;
+
+    for(int i = 0; i < 3; i++)
+    {
+        res->m[i][3] = -(res->m[i][0] * a[0][3] + res->m[i][1] * a[1][3] + res->m[i][2] * a[2][3]);
+    }
+
+    return 1;
+}
+
+M3D_API Mat3x4 m3dMat3x4Inverse(Mat3x4 m)
+{
+    M3D_PROFILE_FUNCTION();
+    Mat3x4 res;
+
+    m3dMat3x4InversePtr(&res, &m);
+
+    return res;
+}
+
+M3D_API void m3dMat3x4TransformPointArray(Vec3A *M3D_RESTRICT res, Mat3x4 m, const Vec3A *v, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+#ifdef MAT3X4_SSE2
+    // the matrix as columns once, then every point is 3 multiply adds onto the translation
+    __m128 c0 = _mm_load_ps(m.m[0]);
+    __m128 c1 = _mm_load_ps(m.m[1]);
+    __m128 c2 = _mm_load_ps(m.m[2]);
+    __m128 c3 = _mm_setzero_ps();
+
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+    for(size_t n = 0; n < count; n++)
+    {
+        __m128 p = _mm_load_ps(&v[n].x);
+        __m128 r = _mm_add_ps(_mm_mul_ps(c0, _mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0))), c3);
+        r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1))));
+        r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2))));
+        _mm_store_ps(&res[n].x, r);
+    }
+#else
+    for(size_t n = 0; n < count; n++)
+    {
+        res[n] = m3dMat3x4TransformPoint(m, v[n]);
+    }
+#endif // MAT3X4_SSE2
+}
+
+M3D_API void m3dMat3x4MulMat3x4Array(Mat3x4 *M3D_RESTRICT res, const Mat3x4 *a, const Mat3x4 *b, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    for(size_t n = 0; n < count; n++)
+    {
+        m3dMat3x4MulMat3x4Ptr(&res[n], &a[n], &b[n]);
+    }
+}
+
+#endif // M3D_FIXED
@@ -1,8 +1,11 @@
 #include "m3d/m3d.h"
+#include "internal.h"
 #include <math.h>
 #include <stdint.h>
 
-static void setAllZeroInternal(Mat4x4 *v)
+#ifndef M3D_FIXED
+
+static void setAllZero4x4Internal(Mat4x4 *v)
 {
     for(int i = 0; i < 4; i++)
     {
@@ -13,25 +16,21 @@ static void setAllZeroInternal(Mat4x4 *v)
     }
 }
 
-Mat4x4 m3dMat4x4InitIdentity()
+M3D_API Mat4x4 m3dMat4x4InitIdentity()
 {
+    M3D_PROFILE_FUNCTION();
     Mat4x4 res;
 
-    setAllZeroInternal(&res);
-
-    // set diagonal to 1s
-    for(int i = 0; i < 4; i++)
-    {
-        res.m[i][i] = 1;
-    }
+    m3dMat4x4InitIdentityPtr(&res);
 
     return res;
 }
 
-Mat4x4 m3dMat4x4InitOrtho(M3dValue r, M3dValue l, M3dValue t, M3dValue b, M3dValue n, M3dValue f)
+M3D_API Mat4x4 m3dMat4x4InitOrtho(M3dValue r, M3dValue l, M3dValue t, M3dValue b, M3dValue n, M3dValue f)
 {
+    M3D_PROFILE_FUNCTION();
     Mat4x4 res;
-    setAllZeroInternal(&res);
+    setAllZero4x4Internal(&res);
 
     M3dValue rml = 1.0 / (r - l);
     M3dValue tmb = 1.0 / (t - b);
@@ -48,10 +47,11 @@ Mat4x4 m3dMat4x4InitOrtho(M3dValue r, M3dValue l, M3dValue t, M3dValue b, M3dVal
     return res;
 }
 
-Mat4x4 m3dMat4x4InitOrthoCentered(M3dValue w, M3dValue h, M3dValue n, M3dValue f)
+M3D_API Mat4x4 m3dMat4x4InitOrthoCentered(M3dValue w, M3dValue h, M3dValue n, M3dValue f)
 {
+    M3D_PROFILE_FUNCTION();
     Mat4x4 res;
-    setAllZeroInternal(&res);
+    setAllZero4x4Internal(&res);
 
     M3dValue fmn = 1.0 / (f - n);
 
@@ -64,12 +64,13 @@ Mat4x4 m3dMat4x4InitOrthoCentered(M3dValue w, M3dValue h, M3dValue n, M3dValue f
     return res;
 }
 
-Mat4x4 m3dMat4x4InitPerspective(M3dValue w, M3dValue h, M3dValue fov, M3dValue n, M3dValue f)
+M3D_API Mat4x4 m3dMat4x4InitPerspective(M3dValue w, M3dValue h, M3dValue fov, M3dValue n, M3dValue f)
 {
+    M3D_PROFILE_FUNCTION();
     Mat4x4 res;
-    setAllZeroInternal(&res);
+    setAllZero4x4Internal(&res);
 
-    M3dValue cotFov = 1.0 / tan(fov / 2.0);
+    M3dValue cotFov = 1 / m3dTanInternal(fov / 2);
     M3dValue fmn = 1.0 / (f - n);
     M3dValue aspect = w / h;
 
@@ -83,37 +84,49 @@ Mat4x4 m3dMat4x4InitPerspective(M3dValue w, M3dValue h, M3dValue fov, M3dValue n
 
 }
 
-Mat4x4 m3dMat4x4InverseHomogeneous(Mat4x4 mat)
+M3D_API Mat4x4 m3dMat4x4InverseHomogeneous(Mat4x4 mat)
 {
-    return m3dMat4x4InitIdentity();
+    M3D_PROFILE_FUNCTION();
+    Mat4x4 res;
+
+    m3dMat4x4InverseHomogeneousPtr(&res, &mat);
+
+    return res;
 }
 
-Mat4x4 m3dMat4x4Rotate(Mat4x4 *m, Quat r)
+M3D_API Mat4x4 m3dMat4x4InverseAffine(Mat4x4 mat)
 {
-    // precalc most parts
-    M3dValue i2 = r.i * r.i * 2.0;
-    M3dValue j2 = r.j * r.j * 2.0;
-    M3dValue k2 = r.k * r.k * 2.0;
+    M3D_PROFILE_FUNCTION();
+    Mat4x4 res;
 
-    M3dValue ij = r.i * r.j * 2.0;
-    M3dValue jk = r.j * r.k * 2.0;
-    M3dValue ik = r.i * r.k * 2.0;
+    m3dMat4x4InverseAffinePtr(&res, &mat);
 
-    M3dValue iw = r.i * r.w * 2.0;
-    M3dValue jw = r.j * r.w * 2.0;
-    M3dValue kw = r.k * r.w * 2.0;
+    return res;
+}
 
-    m->m[0][0] = 1 - j2 - k2;   m->m[0][1] = ij - kw;       m->m[0][2] = ik + jw;
-    m->m[1][0] = ij + kw;       m->m[1][1] = 1 - i2 - k2;   m->m[1][2] = jk - iw;
-    m->m[2][0] = ik - jw;       m->m[2][1] = jk + iw;       m->m[2][2] = 1 - i2 - j2;
+M3D_API Mat4x4 m3dMat4x4Inverse(Mat4x4 mat)
+{
+    M3D_PROFILE_FUNCTION();
+    Mat4x4 res;
+
+    m3dMat4x4InversePtr(&res, &mat);
+
+    return res;
+}
+
+M3D_API Mat4x4 m3dMat4x4Rotate(Mat4x4 *m, Quat r)
+{
+    M3D_PROFILE_FUNCTION();
+    m3dMat4x4RotatePtr(m, &r);
 
     return *m;
 }
 
-Mat4x4 m3dMat4x4RotateY(Mat4x4 *m, M3dValue r)
+M3D_API Mat4x4 m3dMat4x4RotateY(Mat4x4 *m, M3dValue r)
 {
-    M3dValue sinTheta = sin(r);
-    M3dValue cosTheta = cos(r);
+    M3D_PROFILE_FUNCTION();
+    M3dValue sinTheta = m3dSinInternal(r);
+    M3dValue cosTheta = m3dCosInternal(r);
 
     m->m[0][0] = cosTheta;
     m->m[0][2] = sinTheta;
@@ -123,26 +136,25 @@ Mat4x4 m3dMat4x4RotateY(Mat4x4 *m, M3dValue r)
     return *m;
 }
 
-Mat4x4 m3dMat4x4Scale(Mat4x4 *m, Vec3 s)
+M3D_API Mat4x4 m3dMat4x4Scale(Mat4x4 *m, Vec3 s)
 {
-    m->m[0][0] = s.x;
-    m->m[1][1] = s.y;
-    m->m[2][2] = s.z;
+    M3D_PROFILE_FUNCTION();
+    m3dMat4x4ScalePtr(m, &s);
 
     return *m;
 }
 
-Mat4x4 m3dMat4x4Translate(Mat4x4 *m, Vec3 t)
+M3D_API Mat4x4 m3dMat4x4Translate(Mat4x4 *m, Vec3 t)
 {
-    m->m[0][3] = t.x;
-    m->m[1][3] = t.y;
-    m->m[2][3] = t.z;
+    M3D_PROFILE_FUNCTION();
+    m3dMat4x4TranslatePtr(m, &t);
 
     return *m;
 }
 
-Mat4x4 m3dMat4x4FromMat3x3(Mat3x3 m)
+M3D_API Mat4x4 m3dMat4x4FromMat3x3(Mat3x3 m)
 {
+    M3D_PROFILE_FUNCTION();
     Mat4x4 res;
 
     for(int i = 0; i < 3; i++)
@@ -161,10 +173,20 @@ Mat4x4 m3dMat4x4FromMat3x3(Mat3x3 m)
     return res;
 }
 
-Mat4x4 m3dMat4x4MulMat4x4(Mat4x4 a, Mat4x4 b)
+M3D_API Mat4x4 m3dMat4x4Transpose(Mat4x4 m)
 {
+    M3D_PROFILE_FUNCTION();
     Mat4x4 res;
 
+    m3dMat4x4TransposePtr(&res, &m);
+
+    return res;
+}
+
+/** ---------------- multiplication kernels, picked once by cpu features */
+
+static void mulMat4x4Scalar(Mat4x4 *res, const Mat4x4 *a, const Mat4x4 *b)
+{
     for (uint8_t i = 0 ; i < 4 ; i++ )
     {
         for (uint8_t j = 0 ; j < 4 ; j++ )
@@ -172,24 +194,718 @@ Mat4x4 m3dMat4x4MulMat4x4(Mat4x4 a, Mat4x4 b)
             M3dValue sum = 0;
             for (uint8_t k = 0 ; k < 4 ; k++ )
             {
-                sum += a.m[i][k] * b.m[k][j];
+                sum += a->m[i][k] * b->m[k][j];
             }
 
-            res.m[i][j] = sum;
+            res->m[i][j] = sum;
         }
     }
+}
+
+static void mulVec4Scalar(Vec4 *res, const Mat4x4 *a, const Vec4 *b)
+{
+    res->x = a->m[0][0] * b->x + a->m[0][1] * b->y + a->m[0][2] * b->z + a->m[0][3] * b->w;
+    res->y = a->m[1][0] * b->x + a->m[1][1] * b->y + a->m[1][2] * b->z + a->m[1][3] * b->w;
+    res->z = a->m[2][0] * b->x + a->m[2][1] * b->y + a->m[2][2] * b->z + a->m[2][3] * b->w;
+    res->w = a->m[3][0] * b->x + a->m[3][1] * b->y + a->m[3][2] * b->z + a->m[3][3] * b->w;
+}
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+
+// each result row is a[i][0] * b row 0 + ... + a[i][3] * b row 3, summed in the
+// same order as the plain c loop so the results are identical
+static void mulMat4x4Sse2(Mat4x4 *res, const Mat4x4 *a, const Mat4x4 *b)
+{
+    __m128 b0 = _mm_loadu_ps(b->m[0]);
+    __m128 b1 = _mm_loadu_ps(b->m[1]);
+    __m128 b2 = _mm_loadu_ps(b->m[2]);
+    __m128 b3 = _mm_loadu_ps(b->m[3]);
+
+    for(int i = 0; i < 4; i++)
+    {
+        __m128 r = _mm_mul_ps(_mm_set1_ps(a->m[i][0]), b0);
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a->m[i][1]), b1));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a->m[i][2]), b2));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a->m[i][3]), b3));
+        _mm_storeu_ps(res->m[i], r);
+    }
+}
+
+// multiplies every row by b then transposes, so the columns add up in the plain c order
+static void mulVec4Sse2(Vec4 *res, const Mat4x4 *a, const Vec4 *b)
+{
+    __m128 v = _mm_loadu_ps(&b->x);
+    __m128 r0 = _mm_mul_ps(_mm_loadu_ps(a->m[0]), v);
+    __m128 r1 = _mm_mul_ps(_mm_loadu_ps(a->m[1]), v);
+    __m128 r2 = _mm_mul_ps(_mm_loadu_ps(a->m[2]), v);
+    __m128 r3 = _mm_mul_ps(_mm_loadu_ps(a->m[3]), v);
+
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+    _mm_storeu_ps(&res->x, _mm_add_ps(_mm_add_ps(_mm_add_ps(r0, r1), r2), r3));
+}
+
+#ifdef M3D_X86_DISPATCH
+
+// two result rows per register, a[i][k] broadcast within each 128 bit lane
+M3D_TARGET_AVX static void mulMat4x4Avx(Mat4x4 *res, const Mat4x4 *a, const Mat4x4 *b)
+{
+    __m256 b0 = _mm256_broadcast_ps((const __m128 *)b->m[0]);
+    __m256 b1 = _mm256_broadcast_ps((const __m128 *)b->m[1]);
+    __m256 b2 = _mm256_broadcast_ps((const __m128 *)b->m[2]);
+    __m256 b3 = _mm256_broadcast_ps((const __m128 *)b->m[3]);
+
+    for(int i = 0; i < 4; i += 2)
+    {
+        __m256 rows = _mm256_loadu_ps(a->m[i]);
+
+        __m256 r = _mm256_mul_ps(_mm256_permute_ps(rows, 0x00), b0);
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(rows, 0x55), b1));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(rows, 0xAA), b2));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(rows, 0xFF), b3));
+        _mm256_storeu_ps(res->m[i], r);
+    }
+}
+
+M3D_TARGET_AVX2 static void mulMat4x4Avx2Fma(Mat4x4 *res, const Mat4x4 *a, const Mat4x4 *b)
+{
+    __m256 b0 = _mm256_broadcast_ps((const __m128 *)b->m[0]);
+    __m256 b1 = _mm256_broadcast_ps((const __m128 *)b->m[1]);
+    __m256 b2 = _mm256_broadcast_ps((const __m128 *)b->m[2]);
+    __m256 b3 = _mm256_broadcast_ps((const __m128 *)b->m[3]);
+
+    for(int i = 0; i < 4; i += 2)
+    {
+        __m256 rows = _mm256_loadu_ps(a->m[i]);
+
+        __m256 r = _mm256_mul_ps(_mm256_permute_ps(rows, 0x00), b0);
+        r = _mm256_fmadd_ps(_mm256_permute_ps(rows, 0x55), b1, r);
+        r = _mm256_fmadd_ps(_mm256_permute_ps(rows, 0xAA), b2, r);
+        r = _mm256_fmadd_ps(_mm256_permute_ps(rows, 0xFF), b3, r);
+        _mm256_storeu_ps(res->m[i], r);
+    }
+}
+
+// two rows per multiply, then the sse2 transpose on the halves so the columns add up in the plain c order
+M3D_TARGET_AVX static void mulVec4Avx(Vec4 *res, const Mat4x4 *a, const Vec4 *b)
+{
+    __m256 v = _mm256_broadcast_ps((const __m128 *)&b->x);
+    __m256 r01 = _mm256_mul_ps(_mm256_loadu_ps(a->m[0]), v);
+    __m256 r23 = _mm256_mul_ps(_mm256_loadu_ps(a->m[2]), v);
+
+    __m128 r0 = _mm256_castps256_ps128(r01);
+    __m128 r1 = _mm256_extractf128_ps(r01, 1);
+    __m128 r2 = _mm256_castps256_ps128(r23);
+    __m128 r3 = _mm256_extractf128_ps(r23, 1);
+
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+    _mm_storeu_ps(&res->x, _mm_add_ps(_mm_add_ps(_mm_add_ps(r0, r1), r2), r3));
+}
+
+// transposes the matrix into columns so every term can be one fused multiply add
+M3D_TARGET_AVX2 static void mulVec4Avx2Fma(Vec4 *res, const Mat4x4 *a, const Vec4 *b)
+{
+    __m128 c0 = _mm_loadu_ps(a->m[0]);
+    __m128 c1 = _mm_loadu_ps(a->m[1]);
+    __m128 c2 = _mm_loadu_ps(a->m[2]);
+    __m128 c3 = _mm_loadu_ps(a->m[3]);
+
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+    __m128 r = _mm_mul_ps(c0, _mm_set1_ps(b->x));
+    r = _mm_fmadd_ps(c1, _mm_set1_ps(b->y), r);
+    r = _mm_fmadd_ps(c2, _mm_set1_ps(b->z), r);
+    r = _mm_fmadd_ps(c3, _mm_set1_ps(b->w), r);
+    _mm_storeu_ps(&res->x, r);
+}
+
+#endif // M3D_X86_DISPATCH
+
+#elif defined(M3D_SSE2)
+
+// a double row is two registers, otherwise the same as the float kernel
+static void mulMat4x4Sse2(Mat4x4 *res, const Mat4x4 *a, const Mat4x4 *b)
+{
+    for(int i = 0; i < 4; i++)
+    {
+        for(int h = 0; h < 4; h += 2)
+        {
+            __m128d r = _mm_mul_pd(_mm_set1_pd(a->m[i][0]), _mm_loadu_pd(&b->m[0][h]));
+            r = _mm_add_pd(r, _mm_mul_pd(_mm_set1_pd(a->m[i][1]), _mm_loadu_pd(&b->m[1][h])));
+            r = _mm_add_pd(r, _mm_mul_pd(_mm_set1_pd(a->m[i][2]), _mm_loadu_pd(&b->m[2][h])));
+            r = _mm_add_pd(r, _mm_mul_pd(_mm_set1_pd(a->m[i][3]), _mm_loadu_pd(&b->m[3][h])));
+            _mm_storeu_pd(&res->m[i][h], r);
+        }
+    }
+}
+
+static void mulVec4Sse2(Vec4 *res, const Mat4x4 *a, const Vec4 *b)
+{
+    __m128d x = _mm_set1_pd(b->x);
+    __m128d y = _mm_set1_pd(b->y);
+    __m128d z = _mm_set1_pd(b->z);
+    __m128d w = _mm_set1_pd(b->w);
+
+    for(int h = 0; h < 4; h += 2)
+    {
+        // rows h and h + 1 gathered column by column
+        __m128d c0 = _mm_set_pd(a->m[h + 1][0], a->m[h][0]);
+        __m128d c1 = _mm_set_pd(a->m[h + 1][1], a->m[h][1]);
+        __m128d c2 = _mm_set_pd(a->m[h + 1][2], a->m[h][2]);
+        __m128d c3 = _mm_set_pd(a->m[h + 1][3], a->m[h][3]);
+
+        __m128d r = _mm_mul_pd(c0, x);
+        r = _mm_add_pd(r, _mm_mul_pd(c1, y));
+        r = _mm_add_pd(r, _mm_mul_pd(c2, z));
+        r = _mm_add_pd(r, _mm_mul_pd(c3, w));
+        _mm_storeu_pd(&res->x + h, r);
+    }
+}
+
+#ifdef M3D_X86_DISPATCH
+
+// a double row fills a whole ymm register, so this is the float sse2 kernel at full width
+M3D_TARGET_AVX static void mulMat4x4Avx(Mat4x4 *res, const Mat4x4 *a, const Mat4x4 *b)
+{
+    __m256d b0 = _mm256_loadu_pd(b->m[0]);
+    __m256d b1 = _mm256_loadu_pd(b->m[1]);
+    __m256d b2 = _mm256_loadu_pd(b->m[2]);
+    __m256d b3 = _mm256_loadu_pd(b->m[3]);
+
+    for(int i = 0; i < 4; i++)
+    {
+        __m256d r = _mm256_mul_pd(_mm256_broadcast_sd(&a->m[i][0]), b0);
+        r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_broadcast_sd(&a->m[i][1]), b1));
+        r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_broadcast_sd(&a->m[i][2]), b2));
+        r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_broadcast_sd(&a->m[i][3]), b3));
+        _mm256_storeu_pd(res->m[i], r);
+    }
+}
+
+M3D_TARGET_AVX2 static void mulMat4x4Avx2Fma(Mat4x4 *res, const Mat4x4 *a, const Mat4x4 *b)
+{
+    __m256d b0 = _mm256_loadu_pd(b->m[0]);
+    __m256d b1 = _mm256_loadu_pd(b->m[1]);
+    __m256d b2 = _mm256_loadu_pd(b->m[2]);
+    __m256d b3 = _mm256_loadu_pd(b->m[3]);
+
+    for(int i = 0; i < 4; i++)
+    {
+        __m256d r = _mm256_mul_pd(_mm256_broadcast_sd(&a->m[i][0]), b0);
+        r = _mm256_fmadd_pd(_mm256_broadcast_sd(&a->m[i][1]), b1, r);
+        r = _mm256_fmadd_pd(_mm256_broadcast_sd(&a->m[i][2]), b2, r);
+        r = _mm256_fmadd_pd(_mm256_broadcast_sd(&a->m[i][3]), b3, r);
+        _mm256_storeu_pd(res->m[i], r);
+    }
+}
+
+// two result rows per zmm register like the float avx kernel, a[i][k] broadcast within each 256 bit half
+M3D_TARGET_AVX512 static void mulMat4x4Avx512(Mat4x4 *res, const Mat4x4 *a, const Mat4x4 *b)
+{
+    __m512d b0 = _mm512_broadcast_f64x4(_mm256_loadu_pd(b->m[0]));
+    __m512d b1 = _mm512_broadcast_f64x4(_mm256_loadu_pd(b->m[1]));
+    __m512d b2 = _mm512_broadcast_f64x4(_mm256_loadu_pd(b->m[2]));
+    __m512d b3 = _mm512_broadcast_f64x4(_mm256_loadu_pd(b->m[3]));
+
+    for(int i = 0; i < 4; i += 2)
+    {
+        __m512d rows = _mm512_loadu_pd(a->m[i]);
+
+        __m512d r = _mm512_mul_pd(_mm512_permutex_pd(rows, 0x00), b0);
+        r = _mm512_fmadd_pd(_mm512_permutex_pd(rows, 0x55), b1, r);
+        r = _mm512_fmadd_pd(_mm512_permutex_pd(rows, 0xAA), b2, r);
+        r = _mm512_fmadd_pd(_mm512_permutex_pd(rows, 0xFF), b3, r);
+        _mm512_storeu_pd(res->m[i], r);
+    }
+}
+
+// the four rows transposed into columns, the double counterpart of _MM_TRANSPOSE4_PS
+M3D_TARGET_AVX static inline void transpose4x4Avx(__m256d *c0, __m256d *c1, __m256d *c2, __m256d *c3)
+{
+    __m256d t0 = _mm256_unpacklo_pd(*c0, *c1);
+    __m256d t1 = _mm256_unpackhi_pd(*c0, *c1);
+    __m256d t2 = _mm256_unpacklo_pd(*c2, *c3);
+    __m256d t3 = _mm256_unpackhi_pd(*c2, *c3);
+
+    *c0 = _mm256_permute2f128_pd(t0, t2, 0x20);
+    *c1 = _mm256_permute2f128_pd(t1, t3, 0x20);
+    *c2 = _mm256_permute2f128_pd(t0, t2, 0x31);
+    *c3 = _mm256_permute2f128_pd(t1, t3, 0x31);
+}
+
+// column k times b component k, summed in the plain c order
+M3D_TARGET_AVX static void mulVec4Avx(Vec4 *res, const Mat4x4 *a, const Vec4 *b)
+{
+    __m256d c0 = _mm256_loadu_pd(a->m[0]);
+    __m256d c1 = _mm256_loadu_pd(a->m[1]);
+    __m256d c2 = _mm256_loadu_pd(a->m[2]);
+    __m256d c3 = _mm256_loadu_pd(a->m[3]);
+
+    transpose4x4Avx(&c0, &c1, &c2, &c3);
+
+    __m256d r = _mm256_mul_pd(c0, _mm256_broadcast_sd(&b->x));
+    r = _mm256_add_pd(r, _mm256_mul_pd(c1, _mm256_broadcast_sd(&b->y)));
+    r = _mm256_add_pd(r, _mm256_mul_pd(c2, _mm256_broadcast_sd(&b->z)));
+    r = _mm256_add_pd(r, _mm256_mul_pd(c3, _mm256_broadcast_sd(&b->w)));
+    _mm256_storeu_pd(&res->x, r);
+}
+
+M3D_TARGET_AVX2 static void mulVec4Avx2Fma(Vec4 *res, const Mat4x4 *a, const Vec4 *b)
+{
+    __m256d c0 = _mm256_loadu_pd(a->m[0]);
+    __m256d c1 = _mm256_loadu_pd(a->m[1]);
+    __m256d c2 = _mm256_loadu_pd(a->m[2]);
+    __m256d c3 = _mm256_loadu_pd(a->m[3]);
+
+    transpose4x4Avx(&c0, &c1, &c2, &c3);
+
+    __m256d r = _mm256_mul_pd(c0, _mm256_broadcast_sd(&b->x));
+    r = _mm256_fmadd_pd(c1, _mm256_broadcast_sd(&b->y), r);
+    r = _mm256_fmadd_pd(c2, _mm256_broadcast_sd(&b->z), r);
+    r = _mm256_fmadd_pd(c3, _mm256_broadcast_sd(&b->w), r);
+    _mm256_storeu_pd(&res->x, r);
+}
+
+#endif // M3D_X86_DISPATCH
+
+#endif // M3D_SSE2
+
+static void mulMat4x4Resolve(Mat4x4 *res, const Mat4x4 *a, const Mat4x4 *b);
+static void mulVec4Resolve(Vec4 *res, const Mat4x4 *a, const Vec4 *b);
+
+static void (*mulMat4x4Internal)(Mat4x4 *res, const Mat4x4 *a, const Mat4x4 *b) = mulMat4x4Resolve;
+static void (*mulVec4Internal)(Vec4 *res, const Mat4x4 *a, const Vec4 *b) = mulVec4Resolve;
+
+static void mulMat4x4Resolve(Mat4x4 *res, const Mat4x4 *a, const Mat4x4 *b)
+{
+    unsigned int cpu = m3dCpuFeatures();
+
+    void (*kernel)(Mat4x4 *res, const Mat4x4 *a, const Mat4x4 *b) = mulMat4x4Scalar;
+#ifdef M3D_SSE2
+    if(cpu & M3D_CPU_SSE2) kernel = mulMat4x4Sse2;
+#endif
+#ifdef M3D_X86_DISPATCH
+    if(cpu & M3D_CPU_AVX) kernel = mulMat4x4Avx;
+    if((cpu & M3D_CPU_AVX2) && (cpu & M3D_CPU_FMA)) kernel = mulMat4x4Avx2Fma;
+#ifdef M3D_DOUBLE
+    if(cpu & M3D_CPU_AVX512) kernel = mulMat4x4Avx512;
+#endif
+#endif
+    (void)cpu;
+
+    M3D_STORE_RELAXED(mulMat4x4Internal, kernel);
+    kernel(res, a, b);
+}
+
+static void mulVec4Resolve(Vec4 *res, const Mat4x4 *a, const Vec4 *b)
+{
+    unsigned int cpu = m3dCpuFeatures();
+
+    void (*kernel)(Vec4 *res, const Mat4x4 *a, const Vec4 *b) = mulVec4Scalar;
+#ifdef M3D_SSE2
+    if(cpu & M3D_CPU_SSE2) kernel = mulVec4Sse2;
+#endif
+#ifdef M3D_X86_DISPATCH
+    if(cpu & M3D_CPU_AVX) kernel = mulVec4Avx;
+    if((cpu & M3D_CPU_AVX2) && (cpu & M3D_CPU_FMA)) kernel = mulVec4Avx2Fma;
+#endif
+    (void)cpu;
+
+    M3D_STORE_RELAXED(mulVec4Internal, kernel);
+    kernel(res, a, b);
+}
+
+/** ---------------- inverse kernels */
+
+// cofactor expansion through the 2x2 determinants of the top and bottom row pairs
+static char inverseScalar(Mat4x4 *res, const Mat4x4 *m)
+{
+    const M3dValue (*a)[4] = m->m;
+
+    M3dValue s0 = a[0][0] * a[1][1] - a[1][0] * a[0][1];
+    M3dValue s1 = a[0][0] * a[1][2] - a[1][0] * a[0][2];
+    M3dValue s2 = a[0][0] * a[1][3] - a[1][0] * a[0][3];
+    M3dValue s3 = a[0][1] * a[1][2] - a[1][1] * a[0][2];
+    M3dValue s4 = a[0][1] * a[1][3] - a[1][1] * a[0][3];
+    M3dValue s5 = a[0][2] * a[1][3] - a[1][2] * a[0][3];
+
+    M3dValue c5 = a[2][2] * a[3][3] - a[3][2] * a[2][3];
+    M3dValue c4 = a[2][1] * a[3][3] - a[3][1] * a[2][3];
+    M3dValue c3 = a[2][1] * a[3][2] - a[3][1] * a[2][2];
+    M3dValue c2 = a[2][0] * a[3][3] - a[3][0] * a[2][3];
+    M3dValue c1 = a[2][0] * a[3][2] - a[3][0] * a[2][2];
+    M3dValue c0 = a[2][0] * a[3][1] - a[3][0] * a[2][1];
+
+    M3dValue det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+
+    if(det == 0)
+    {
+        m3dMat4x4InitIdentityPtr(res);
+        return 0;
+    }
+
+    M3dValue inv = 1 / det;
+
+    res->m[0][0] = ( a[1][1] * c5 - a[1][2] * c4 + a[1][3] * c3) * inv;
+    res->m[0][1] = (-a[0][1] * c5 + a[0][2] * c4 - a[0][3] * c3) * inv;
+    res->m[0][2] = ( a[3][1] * s5 - a[3][2] * s4 + a[3][3] * s3) * inv;
+    res->m[0][3] = (-a[2][1] * s5 + a[2][2] * s4 - a[2][3] * s3) * inv;
+
+    res->m[1][0] = (-a[1][0] * c5 + a[1][2] * c2 - a[1][3] * c1) * inv;
+    res->m[1][1] = ( a[0][0] * c5 - a[0][2] * c2 + a[0][3] * c1) * inv;
+    res->m[1][2] = (-a[3][0] * s5 + a[3][2] * s2 - a[3][3] * s1) * inv;
+    res->m[1][3] = ( a[2][0] * s5 - a[2][2] * s2 + a[2][3] * s1) * inv;
+
+    res->m[2][0] = ( a[1][0] * c4 - a[1][1] * c2 + a[1][3] * c0) * inv;
+    res->m[2][1] = (-a[0][0] * c4 + a[0][1] * c2 - a[0][3] * c0) * inv;
+    res->m[2][2] = ( a[3][0] * s4 - a[3][1] * s2 + a[3][3] * s0) * inv;
+    res->m[2][3] = (-a[2][0] * s4 + a[2][1] * s2 - a[2][3] * s0) * inv;
+
+    res->m[3][0] = (-a[1][0] * c3 + a[1][1] * c1 - a[1][2] * c0) * inv;
+    res->m[3][1] = ( a[0][0] * c3 - a[0][1] * c1 + a[0][2] * c0) * inv;
+    res->m[3][2] = (-a[3][0] * s3 + a[3][1] * s1 - a[3][2] * s0) * inv;
+    res->m[3][3] = ( a[2][0] * s3 - a[2][1] * s1 + a[2][2] * s0) * inv;
+
+    return 1;
+}
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+
+#define SWIZZLE(v, x, y, z, w) _mm_shuffle_ps(v, v, _MM_SHUFFLE(w, z, y, x))
+
+// 2x2 row major blocks held as (00 01 10 11) in one register
+static inline __m128 mat2MulSse2(__m128 a, __m128 b)
+{
+    return _mm_add_ps(_mm_mul_ps(a, SWIZZLE(b, 0, 3, 0, 3)),
+                      _mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// adjugate(a) * b
+static inline __m128 mat2AdjMulSse2(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(SWIZZLE(a, 3, 3, 0, 0), b),
+                      _mm_mul_ps(SWIZZLE(a, 1, 1, 2, 2), SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+// a * adjugate(b)
+static inline __m128 mat2MulAdjSse2(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, SWIZZLE(b, 3, 0, 3, 0)),
+                      _mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// block inverse of | A B |, every step works on a whole 2x2 block at once
+//                  | C D |
+static char inverseSse2(Mat4x4 *res, const Mat4x4 *m)
+{
+    __m128 r0 = _mm_loadu_ps(m->m[0]);
+    __m128 r1 = _mm_loadu_ps(m->m[1]);
+    __m128 r2 = _mm_loadu_ps(m->m[2]);
+    __m128 r3 = _mm_loadu_ps(m->m[3]);
+
+    __m128 A = _mm_movelh_ps(r0, r1);
+    __m128 B = _mm_movehl_ps(r1, r0);
+    __m128 C = _mm_movelh_ps(r2, r3);
+    __m128 D = _mm_movehl_ps(r3, r2);
+
+    // determinants of the blocks as (|A| |B| |C| |D|)
+    __m128 detSub = _mm_sub_ps(
+        _mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(3, 1, 3, 1))),
+        _mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(2, 0, 2, 0))));
+    __m128 detA = SWIZZLE(detSub, 0, 0, 0, 0);
+    __m128 detB = SWIZZLE(detSub, 1, 1, 1, 1);
+    __m128 detC = SWIZZLE(detSub, 2, 2, 2, 2);
+    __m128 detD = SWIZZLE(detSub, 3, 3, 3, 3);
+
+    __m128 DC = mat2AdjMulSse2(D, C);
+    __m128 AB = mat2AdjMulSse2(A, B);
+
+    // adjugates of the result blocks
+    __m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), mat2MulSse2(B, DC));
+    __m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), mat2MulSse2(C, AB));
+    __m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), mat2MulAdjSse2(D, AB));
+    __m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), mat2MulAdjSse2(A, DC));
+
+    // |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+    __m128 tr = _mm_mul_ps(AB, SWIZZLE(DC, 0, 2, 1, 3));
+    tr = _mm_add_ps(tr, SWIZZLE(tr, 2, 3, 0, 1));
+    tr = _mm_add_ps(tr, SWIZZLE(tr, 1, 0, 3, 2));
+
+    __m128 detM = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), tr);
+
+    if(_mm_cvtss_f32(detM) == 0)
+    {
+        m3dMat4x4InitIdentityPtr(res);
+        return 0;
+    }
+
+    __m128 invDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+
+    X = _mm_mul_ps(X, invDet);
+    Y = _mm_mul_ps(Y, invDet);
+    Z = _mm_mul_ps(Z, invDet);
+    W = _mm_mul_ps(W, invDet);
+
+    // the adjugate swizzle and the block to row shuffle in one step
+    _mm_storeu_ps(res->m[0], _mm_shuffle_ps(X, Y, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_storeu_ps(res->m[1], _mm_shuffle_ps(X, Y, _MM_SHUFFLE(0, 2, 0, 2)));
+    _mm_storeu_ps(res->m[2], _mm_shuffle_ps(Z, W, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_storeu_ps(res->m[3], _mm_shuffle_ps(Z, W, _MM_SHUFFLE(0, 2, 0, 2)));
+
+    return 1;
+}
+
+#undef SWIZZLE
+
+#endif // M3D_SSE2
+
+static char inverseResolve(Mat4x4 *res, const Mat4x4 *m);
+
+static char (*inverseInternal)(Mat4x4 *res, const Mat4x4 *m) = inverseResolve;
+
+static char inverseResolve(Mat4x4 *res, const Mat4x4 *m)
+{
+    char (*kernel)(Mat4x4 *res, const Mat4x4 *m) = inverseScalar;
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    if(m3dCpuFeatures() & M3D_CPU_SSE2) kernel = inverseSse2;
+#endif
+
+    M3D_STORE_RELAXED(inverseInternal, kernel);
+
+    return kernel(res, m);
+}
+
+M3D_API Mat4x4 m3dMat4x4MulMat4x4(Mat4x4 a, Mat4x4 b)
+{
+    M3D_PROFILE_FUNCTION();
+    Mat4x4 res;
+
+    M3D_LOAD_RELAXED(mulMat4x4Internal)(&res, &a, &b);
 
     return res;
 }
 
-Vec4 m3dMat4x4MulVec4(Mat4x4 a, Vec4 b)
+M3D_API Vec4 m3dMat4x4MulVec4(Mat4x4 a, Vec4 b)
 {
+    M3D_PROFILE_FUNCTION();
     Vec4 res;
 
-    res.x = a.m[0][0] * b.x + a.m[0][1] * b.y + a.m[0][2] * b.z + a.m[0][3] * b.w;
-    res.y = a.m[1][0] * b.x + a.m[1][1] * b.y + a.m[1][2] * b.z + a.m[1][3] * b.w;
-    res.z = a.m[2][0] * b.x + a.m[2][1] * b.y + a.m[2][2] * b.z + a.m[2][3] * b.w;
-    res.w = a.m[3][0] * b.x + a.m[3][1] * b.y + a.m[3][2] * b.z + a.m[3][3] * b.w;
+    M3D_LOAD_RELAXED(mulVec4Internal)(&res, &a, &b);
 
     return res;
 }
+
+/** ---------------- by pointer variants */
+
+M3D_API void m3dMat4x4InitIdentityPtr(Mat4x4 *res)
+{
+    M3D_PROFILE_FUNCTION();
+    setAllZero4x4Internal(res);
+
+    // set diagonal to 1s
+    for(int i = 0; i < 4; i++)
+    {
+        res->m[i][i] = 1;
+    }
+}
+
+M3D_API void m3dMat4x4RotatePtr(Mat4x4 *m, const Quat *r)
+{
+    M3D_PROFILE_FUNCTION();
+    // precalc most parts
+    M3dValue i2 = r->i * r->i * 2.0;
+    M3dValue j2 = r->j * r->j * 2.0;
+    M3dValue k2 = r->k * r->k * 2.0;
+
+    M3dValue ij = r->i * r->j * 2.0;
+    M3dValue jk = r->j * r->k * 2.0;
+    M3dValue ik = r->i * r->k * 2.0;
+
+    M3dValue iw = r->i * r->w * 2.0;
+    M3dValue jw = r->j * r->w * 2.0;
+    M3dValue kw = r->k * r->w * 2.0;
+
+    m->m[0][0] = 1 - j2 - k2;   m->m[0][1] = ij - kw;       m->m[0][2] = ik + jw;
+    m->m[1][0] = ij + kw;       m->m[1][1] = 1 - i2 - k2;   m->m[1][2] = jk - iw;
+    m->m[2][0] = ik - jw;       m->m[2][1] = jk + iw;       m->m[2][2] = 1 - i2 - j2;
+}
+
+M3D_API void m3dMat4x4ScalePtr(Mat4x4 *m, const Vec3 *s)
+{
+    M3D_PROFILE_FUNCTION();
+    m->m[0][0] = s->x;
+    m->m[1][1] = s->y;
+    m->m[2][2] = s->z;
+}
+
+M3D_API void m3dMat4x4TranslatePtr(Mat4x4 *m, const Vec3 *t)
+{
+    M3D_PROFILE_FUNCTION();
+    m->m[0][3] = t->x;
+    m->m[1][3] = t->y;
+    m->m[2][3] = t->z;
+}
+
+M3D_API void m3dMat4x4MulMat4x4Ptr(Mat4x4 *M3D_RESTRICT res, const Mat4x4 *a, const Mat4x4 *b)
+{
+    M3D_PROFILE_FUNCTION();
+    M3D_LOAD_RELAXED(mulMat4x4Internal)(res, a, b);
+}
+
+M3D_API void m3dMat4x4MulMat4x4InPlace(Mat4x4 *a, const Mat4x4 *b)
+{
+    M3D_PROFILE_FUNCTION();
+    Mat4x4 res;
+
+    M3D_LOAD_RELAXED(mulMat4x4Internal)(&res, a, b);
+
+    *a = res;
+}
+
+M3D_API void m3dMat4x4PreMulMat4x4InPlace(const Mat4x4 *a, Mat4x4 *b)
+{
+    M3D_PROFILE_FUNCTION();
+    Mat4x4 res;
+
+    M3D_LOAD_RELAXED(mulMat4x4Internal)(&res, a, b);
+
+    *b = res;
+}
+
+M3D_API void m3dMat4x4MulVec4Ptr(Vec4 *M3D_RESTRICT res, const Mat4x4 *a, const Vec4 *b)
+{
+    M3D_PROFILE_FUNCTION();
+    M3D_LOAD_RELAXED(mulVec4Internal)(res, a, b);
+}
+
+M3D_API void m3dMat4x4InverseHomogeneousPtr(Mat4x4 *M3D_RESTRICT res, const Mat4x4 *m)
+{
+    M3D_PROFILE_FUNCTION();
+    // the rotation inverts by transposing, the position by rotating it back and negating
+    for(int i = 0; i < 3; i++)
+    {
+        for(int j = 0; j < 3; j++)
+        {
+            res->m[i][j] = m->m[j][i];
+        }
+    }
+
+    for(int i = 0; i < 3; i++)
+    {
+        res->m[i][3] = -(res->m[i][0] * m->m[0][3] + res->m[i][1] * m->m[1][3] + res->m[i][2] * m->m[2][3]);
+        res->m[3][i] = 0;
+    }
+
+    res->m[3][3] = 1;
+}
+
+M3D_API char m3dMat4x4InverseAffinePtr(Mat4x4 *M3D_RESTRICT res, const Mat4x4 *m)
+{
+    M3D_PROFILE_FUNCTION();
+    const M3dValue (*a)[4] = m->m;
+
+    // cofactors of the upper 3x3, transposed into the adjugate
+    M3dValue c00 = a[1][1] * a[2][2] - a[1][2] * a[2][1];
+    M3dValue c01 = a[1][2] * a[2][0] - a[1][0] * a[2][2];
+    M3dValue c02 = a[1][0] * a[2][1] - a[1][1] * a[2][0];
+
+    M3dValue det = a[0][0] * c00 + a[0][1] * c01 + a[0][2] * c02;
+
+    if(det == 0)
+    {
+        m3dMat4x4InitIdentityPtr(res);
+        return 0;
+    }
+
+    M3dValue inv = 1 / det;
+
+    res->m[0][0] = c00 * inv;
+    res->m[1][0] = c01 * inv;
+    res->m[2][0] = c02 * inv;
+    res->m[0][1] = (a[0][2] * a[2][1] - a[0][1] * a[2][2]) * inv;
+    res->m[1][1] = (a[0][0] * a[2][2] - a[0][2] * a[2][0]) * inv;
+    res->m[2][1] = (a[0][1] * a[2][0] - a[0][0] * a[2][1]) * inv;
+    res->m[0][2] = (a[0][1] * a[1][2] - a[0][2] * a[1][1]) * inv;
+    res->m[1][2] = (a[0][2] * a[1][0] - a[0][0] * a[1][2]) * inv;
+    res->m[2][2] = (a[0][0] * a[1][1] - a[0][1] * a[1][0]) * inv;
+
+    for(int i = 0; i < 3; i++)
+    {
+        res->m[i][3] = -(res->m[i][0] * a[0][3] + res->m[i][1] * a[1][3] + res->m[i][2] * a[2][3]);
+        res->m[3][i] = 0;
+    }
+
+    res->m[3][3] = 1;
+
+    return 1;
+}
+
+M3D_API char m3dMat4x4InversePtr(Mat4x4 *M3D_RESTRICT res, const Mat4x4 *m)
+{
+    M3D_PROFILE_FUNCTION();
+    return M3D_LOAD_RELAXED(inverseInternal)(res, m);
+}
+
+M3D_API void m3dMat4x4TransposePtr(Mat4x4 *M3D_RESTRICT res, const Mat4x4 *m)
+{
+    M3D_PROFILE_FUNCTION();
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    __m128 r0 = _mm_loadu_ps(m->m[0]);
+    __m128 r1 = _mm_loadu_ps(m->m[1]);
+    __m128 r2 = _mm_loadu_ps(m->m[2]);
+    __m128 r3 = _mm_loadu_ps(m->m[3]);
+
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+    _mm_storeu_ps(res->m[0], r0);
+    _mm_storeu_ps(res->m[1], r1);
+    _mm_storeu_ps(res->m[2], r2);
+    _mm_storeu_ps(res->m[3], r3);
+#else
+    for(int i = 0; i < 4; i++)
+    {
+        for(int j = 0; j < 4; j++)
+        {
+            res->m[i][j] = m->m[j][i];
+        }
+    }
+#endif // M3D_SSE2
+}
+
+M3D_API void m3dMat4x4InverseHomogeneousArray(Mat4x4 *M3D_RESTRICT res, const Mat4x4 *m, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    for(size_t i = 0; i < count; i++)
+    {
+        m3dMat4x4InverseHomogeneousPtr(&res[i], &m[i]);
+    }
+}
+
+M3D_API size_t m3dMat4x4InverseAffineArray(Mat4x4 *M3D_RESTRICT res, const Mat4x4 *m, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t singular = 0;
+
+    for(size_t i = 0; i < count; i++)
+    {
+        singular += !m3dMat4x4InverseAffinePtr(&res[i], &m[i]);
+    }
+
+    return singular;
+}
+
+M3D_API size_t m3dMat4x4InverseArray(Mat4x4 *M3D_RESTRICT res, const Mat4x4 *m, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t singular = 0;
+
+    for(size_t i = 0; i < count; i++)
+    {
+        singular += !M3D_LOAD_RELAXED(inverseInternal)(&res[i], &m[i]);
+    }
+
+    return singular;
+}
+
+#endif // M3D_FIXED
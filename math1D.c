@@ -1,12 +1,38 @@
 #include "m3d/m3d.h"
+#include "internal.h"
 #include <math.h>
 
-M3dValue m3d1DClamp(M3dValue v, M3dValue low, M3dValue high)
+M3D_API M3dValue m3d1DClamp(M3dValue v, M3dValue low, M3dValue high)
 {
-    return fmin(fmax(low, v), high);
+    M3D_PROFILE_FUNCTION();
+    return m3dMinInternal(m3dMaxInternal(low, v), high);
 }
 
-M3dValue m3d1DLerp(M3dValue a, M3dValue b, M3dValue t)
+M3D_API M3dValue m3d1DLerp(M3dValue a, M3dValue b, M3dValue t)
 {
-    return (1.0 - t) * a + b * t;
+    M3D_PROFILE_FUNCTION();
+    return m3dMulInternal(M3D_VALUE(1) - t, a) + m3dMulInternal(b, t);
+}
+
+M3D_API void m3d1DSinCosArray(M3dValue *M3D_RESTRICT s, M3dValue *M3D_RESTRICT c, const M3dValue *v, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t i = 0;
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        __m128 rs, rc;
+        m3dSinCos4Internal(_mm_loadu_ps(v + i), &rs, &rc);
+
+        _mm_storeu_ps(s + i, rs);
+        _mm_storeu_ps(c + i, rc);
+    }
+#endif
+
+    for(; i < count; i++)
+    {
+        s[i] = m3dSinInternal(v[i]);
+        c[i] = m3dCosInternal(v[i]);
+    }
 }
@@ -0,0 +1,293 @@
+#include "m3d/m3d.h"
+#include "internal.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <inttypes.h>
+
+#ifdef M3D_PROFILE
+
+#include <stdlib.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define M3D_THREAD_LOCAL __declspec(thread)
+#else
+#define M3D_THREAD_LOCAL __thread
+#endif
+
+static const char *functionNames[M3D_PROFILE_MAX_FUNCTIONS];
+static int functionCount = 0;
+static M3dProfileThread *threadList = NULL;
+static M3D_THREAD_LOCAL M3dProfileThread *threadCounters = NULL;
+
+#if defined(__GNUC__) || defined(__clang__)
+
+static inline char casIntInternal(int *p, int expected, int desired)
+{
+    return __atomic_compare_exchange_n(p, &expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+static inline char casThreadInternal(M3dProfileThread **p, M3dProfileThread *expected, M3dProfileThread *desired)
+{
+    return __atomic_compare_exchange_n(p, &expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+static inline int fetchAddIntInternal(int *p, int v)
+{
+    return __atomic_fetch_add(p, v, __ATOMIC_ACQ_REL);
+}
+
+static inline void storeIndexInternal(int *p, int v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static inline void storeNameInternal(const char **p, const char *v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static inline const char *loadNameInternal(const char **p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline M3dProfileThread *loadThreadInternal(M3dProfileThread **p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline uint64_t loadCounterInternal(const uint64_t *p)
+{
+    return __atomic_load_n(p, __ATOMIC_RELAXED);
+}
+
+#else
+
+static inline char casIntInternal(int *p, int expected, int desired)
+{
+    return _InterlockedCompareExchange((volatile long *)p, desired, expected) == expected;
+}
+
+static inline char casThreadInternal(M3dProfileThread **p, M3dProfileThread *expected, M3dProfileThread *desired)
+{
+    return _InterlockedCompareExchangePointer((void *volatile *)p, desired, expected) == expected;
+}
+
+static inline int fetchAddIntInternal(int *p, int v)
+{
+    return _InterlockedExchangeAdd((volatile long *)p, v);
+}
+
+static inline void storeIndexInternal(int *p, int v)
+{
+    *(volatile int *)p = v;
+}
+
+static inline void storeNameInternal(const char **p, const char *v)
+{
+    *(const char *volatile *)p = v;
+}
+
+static inline const char *loadNameInternal(const char **p)
+{
+    return *(const char *volatile *)p;
+}
+
+static inline M3dProfileThread *loadThreadInternal(M3dProfileThread **p)
+{
+    return *(M3dProfileThread *volatile *)p;
+}
+
+static inline uint64_t loadCounterInternal(const uint64_t *p)
+{
+    return *(volatile const uint64_t *)p;
+}
+
+#endif // __GNUC__
+
+M3D_API int m3dProfileRegisterInternal(M3dProfileSite *site)
+{
+    if(casIntInternal(&site->index, -1, -2))
+    {
+        int index = fetchAddIntInternal(&functionCount, 1);
+
+        if(index >= M3D_PROFILE_MAX_FUNCTIONS)
+        {
+            index = M3D_PROFILE_MAX_FUNCTIONS;
+        }
+        else
+        {
+            storeNameInternal(&functionNames[index], site->name);
+        }
+
+        storeIndexInternal(&site->index, index);
+        return index;
+    }
+
+    // another thread is registering it, which takes a few instructions
+    int index;
+    while((index = m3dProfileLoadInternal(&site->index)) < 0)
+    {
+    }
+
+    return index;
+}
+
+M3D_API M3dProfileThread *m3dProfileThreadInternal()
+{
+    if(!threadCounters)
+    {
+        M3dProfileThread *t = (M3dProfileThread *)calloc(1, sizeof(M3dProfileThread));
+
+        if(!t)
+        {
+            return NULL;
+        }
+
+        // pushed for good, the counts of finished threads stay in the totals
+        do
+        {
+            t->next = loadThreadInternal(&threadList);
+        }
+        while(!casThreadInternal(&threadList, t->next, t));
+
+        threadCounters = t;
+    }
+
+    return threadCounters;
+}
+
+#endif // M3D_PROFILE
+
+M3D_API size_t m3dProfileSnapshot(M3dProfileEntry *res, size_t capacity)
+{
+#ifdef M3D_PROFILE
+    int count = m3dProfileLoadInternal(&functionCount);
+    size_t functions = count < M3D_PROFILE_MAX_FUNCTIONS ? (size_t)count : M3D_PROFILE_MAX_FUNCTIONS;
+    size_t written = 0;
+
+    for(size_t f = 0; f < functions && written < capacity; f++)
+    {
+        const char *name = loadNameInternal(&functionNames[f]);
+
+        // claimed but not published yet
+        if(!name)
+        {
+            continue;
+        }
+
+        M3dProfileEntry e = {name, 0, 0};
+
+        for(M3dProfileThread *t = loadThreadInternal(&threadList); t; t = t->next)
+        {
+            e.calls += loadCounterInternal(&t->calls[f]) - t->baseCalls[f];
+            e.cycles += loadCounterInternal(&t->cycles[f]) - t->baseCycles[f];
+        }
+
+        res[written++] = e;
+    }
+
+    return written;
+#else
+    (void)res;
+    (void)capacity;
+    return 0;
+#endif // M3D_PROFILE
+}
+
+M3D_API void m3dProfileReset()
+{
+#ifdef M3D_PROFILE
+    for(M3dProfileThread *t = loadThreadInternal(&threadList); t; t = t->next)
+    {
+        for(size_t f = 0; f < M3D_PROFILE_MAX_FUNCTIONS; f++)
+        {
+            t->baseCalls[f] = loadCounterInternal(&t->calls[f]);
+            t->baseCycles[f] = loadCounterInternal(&t->cycles[f]);
+        }
+    }
+#endif // M3D_PROFILE
+}
+
+/** ---------------- formatting */
+
+// vsnprintf at the end of res, len counts what the whole output needs even once res is full
+static void appendInternal(char *res, size_t size, size_t *len, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+
+    int n = vsnprintf(*len < size ? res + *len : NULL, *len < size ? size - *len : 0, format, args);
+
+    va_end(args);
+
+    *len += n > 0 ? (size_t)n : 0;
+}
+
+// the snapshot with the most expensive functions first, by cycles when they are measured
+static size_t sortedSnapshotInternal(M3dProfileEntry *entries, size_t capacity)
+{
+    size_t count = m3dProfileSnapshot(entries, capacity);
+
+    for(size_t i = 1; i < count; i++)
+    {
+        M3dProfileEntry e = entries[i];
+        size_t j = i;
+
+        while(j > 0 && (entries[j - 1].cycles < e.cycles ||
+                        (entries[j - 1].cycles == e.cycles && entries[j - 1].calls < e.calls)))
+        {
+            entries[j] = entries[j - 1];
+            j--;
+        }
+
+        entries[j] = e;
+    }
+
+    return count;
+}
+
+#ifdef M3D_PROFILE
+#define PROFILE_FORMAT_MAX M3D_PROFILE_MAX_FUNCTIONS
+#else
+#define PROFILE_FORMAT_MAX 1
+#endif // M3D_PROFILE
+
+M3D_API size_t m3dProfileFormatText(char *res, size_t size)
+{
+    M3dProfileEntry entries[PROFILE_FORMAT_MAX];
+    size_t count = sortedSnapshotInternal(entries, PROFILE_FORMAT_MAX);
+    size_t len = 0;
+
+    appendInternal(res, size, &len, "%-36s %14s %16s %12s\n", "function", "calls", "cycles", "cycles/call");
+
+    for(size_t i = 0; i < count; i++)
+    {
+        double perCall = entries[i].calls ? (double)entries[i].cycles / (double)entries[i].calls : 0;
+
+        appendInternal(res, size, &len, "%-36s %14" PRIu64 " %16" PRIu64 " %12.1f\n",
+                       entries[i].name, entries[i].calls, entries[i].cycles, perCall);
+    }
+
+    return len;
+}
+
+M3D_API size_t m3dProfileFormatJson(char *res, size_t size)
+{
+    M3dProfileEntry entries[PROFILE_FORMAT_MAX];
+    size_t count = sortedSnapshotInternal(entries, PROFILE_FORMAT_MAX);
+    size_t len = 0;
+
+    appendInternal(res, size, &len, "{\"functions\":[");
+
+    for(size_t i = 0; i < count; i++)
+    {
+        appendInternal(res, size, &len, "%s{\"name\":\"%s\",\"calls\":%" PRIu64 ",\"cycles\":%" PRIu64 "}",
+                       i ? "," : "", entries[i].name, entries[i].calls, entries[i].cycles);
+    }
+
+    appendInternal(res, size, &len, "]}\n");
+
+    return len;
+}
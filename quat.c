@@ -1,132 +1,217 @@
 #include "m3d/m3d.h"
+#include "internal.h"
 #include <math.h>
 
 //https://www.mathworks.com/matlabcentral/answers/415936-angle-between-2-quaternions
-M3dValue m3dQuatAngle(Quat a, Quat b)
+M3D_API M3dValue m3dQuatAngle(Quat a, Quat b)
 {
-    return 2 * acos(m3dQuatMulQuat(m3dQuatConjugate(a), b).w);
+    M3D_PROFILE_FUNCTION();
+    return 2 * m3dAcosInternal(m3dQuatMulQuat(m3dQuatConjugate(a), b).w);
 }
 
 //https://stackoverflow.com/questions/12435671/quaternion-lookat-function
 //https://gamedev.stackexchange.com/questions/15070/orienting-a-model-to-face-a-target
-Quat m3dQuatAngleVec3(Vec3 a, Vec3 b, Vec3 up)
+M3D_API Quat m3dQuatAngleVec3(Vec3 a, Vec3 b, Vec3 up)
 {
-    float dot = m3dVec3Dot(a, b);
+    M3D_PROFILE_FUNCTION();
+#ifdef M3D_FIXED
+    // at least one step, 1e-6 rounds to 0 with fewer than 20 fractional bits
+    const M3dValue epsilon = m3dMaxInternal(M3D_VALUE(0.000001), 1);
+#else
+    const M3dValue epsilon = (M3dValue)0.000001f;
+#endif
+    M3dValue dot = m3dVec3Dot(a, b);
+    M3dValue dotPlusOne = dot + M3D_VALUE(1);
+    M3dValue dotMinusOne = dot - M3D_VALUE(1);
     // test for dot -1
-    if(fabs(dot + 1.0f) < 0.000001f)
+    if(m3dMaxInternal(dotPlusOne, -dotPlusOne) < epsilon)
     {
         // vector a and b point exactly in the opposite direction,
         // so it is a 180 degrees turn around the up-axis
-        return m3dQuatAngleAxis(180.0f * TO_RADS, up);
+        return m3dQuatAngleAxis(M3D_VALUE(180.0 * TO_RADS), up);
     }
     // test for dot 1
-    else if(fabs(dot - 1.0f) < 0.000001f)
+    else if(m3dMaxInternal(dotMinusOne, -dotMinusOne) < epsilon)
     {
         // vector a and b point exactly in the same direction
         // so we return the identity quaternion
-        return (Quat){0.0f, 0.0f, 0.0f, 1.0f};
+        return (Quat){0, 0, 0, M3D_VALUE(1)};
     }
 
-    float rotAngle = acos(dot);
+    M3dValue rotAngle = m3dAcosInternal(dot);
     Vec3 rotAxis = m3dVec3Cross(a, b);
     rotAxis = m3dVec3Normalized(rotAxis);
     return m3dQuatAngleAxis(rotAngle, rotAxis);
 }
 
-Quat m3dQuatAngleAxis(M3dValue r, Vec3 a)
+M3D_API Quat m3dQuatAngleAxis(M3dValue r, Vec3 a)
 {
+    M3D_PROFILE_FUNCTION();
+    M3dValue halfR = r / 2;
+    M3dValue sinHalfR = m3dSinInternal(halfR);
+
     Quat res;
-    res.i = a.x * sin(r / 2.0);
-    res.j = a.y * sin(r / 2.0);
-    res.k = a.z * sin(r / 2.0);
-    res.w = cos(r / 2.0);
+    res.i = m3dMulInternal(a.x, sinHalfR);
+    res.j = m3dMulInternal(a.y, sinHalfR);
+    res.k = m3dMulInternal(a.z, sinHalfR);
+    res.w = m3dCosInternal(halfR);
 
     return res;
 }
 
-Quat m3dQuatConjugate(Quat v)
+M3D_API Quat m3dQuatConjugate(Quat v)
 {
+    M3D_PROFILE_FUNCTION();
     v.i = -v.i;
     v.j = -v.j;
     v.k = -v.k;
     return v;
 }
 
-Vec3 m3dQuatEuler(Quat v)
+M3D_API Vec3 m3dQuatEuler(Quat v)
 {
-    M3dValue i2 = v.i * v.i;
-    M3dValue j2 = v.j * v.j;
-    M3dValue k2 = v.k * v.k;
+    M3D_PROFILE_FUNCTION();
+    M3dValue i2 = m3dMulInternal(v.i, v.i);
+    M3dValue j2 = m3dMulInternal(v.j, v.j);
+    M3dValue k2 = m3dMulInternal(v.k, v.k);
 
     Vec3 res;
-    res.x = atan2(2 * (v.w * v.i + v.j * v.k), 1 - 2 * (i2 + j2));
-    res.y = asin(2 * (v.w * v.j - v.k * v.i));
-    res.z = atan2(2 * (v.w * v.k + v.i * v.j), 1 - 2 * (j2 + k2));
+    res.x = m3dAtan2Internal(2 * (m3dMulInternal(v.w, v.i) + m3dMulInternal(v.j, v.k)), M3D_VALUE(1) - 2 * (i2 + j2));
+    res.y = m3dAsinInternal(2 * (m3dMulInternal(v.w, v.j) - m3dMulInternal(v.k, v.i)));
+    res.z = m3dAtan2Internal(2 * (m3dMulInternal(v.w, v.k) + m3dMulInternal(v.i, v.j)), M3D_VALUE(1) - 2 * (j2 + k2));
+
+    return res;
+}
+
+M3D_API Quat m3dQuatFace(Vec3 dir, Vec3 up)
+{
+    M3D_PROFILE_FUNCTION();
+    return m3dQuatAngleVec3((Vec3){0, 0, M3D_VALUE(1)}, dir, up);
+}
+
+M3D_API Quat m3dQuatFromEuler(Vec3 e)
+{
+    M3D_PROFILE_FUNCTION();
+    M3dValue sx = m3dSinInternal(e.x / 2), cx = m3dCosInternal(e.x / 2);
+    M3dValue sy = m3dSinInternal(e.y / 2), cy = m3dCosInternal(e.y / 2);
+    M3dValue sz = m3dSinInternal(e.z / 2), cz = m3dCosInternal(e.z / 2);
+
+    // z * y * x, the order m3dQuatEuler takes apart
+    Quat res;
+    res.i = m3dMulInternal(m3dMulInternal(sx, cy), cz) - m3dMulInternal(m3dMulInternal(cx, sy), sz);
+    res.j = m3dMulInternal(m3dMulInternal(cx, sy), cz) + m3dMulInternal(m3dMulInternal(sx, cy), sz);
+    res.k = m3dMulInternal(m3dMulInternal(cx, cy), sz) - m3dMulInternal(m3dMulInternal(sx, sy), cz);
+    res.w = m3dMulInternal(m3dMulInternal(cx, cy), cz) + m3dMulInternal(m3dMulInternal(sx, sy), sz);
 
     return res;
 }
 
-Quat m3dQuatFace(Vec3 dir, Vec3 up)
+// Shepperd's method, the square root is taken of the largest of the 4 candidates
+// so it stays far from 0 and the divisions keep their precision
+M3D_API Quat m3dQuatFromMat4x4(Mat4x4 m)
 {
-    return m3dQuatAngleVec3((Vec3){0.0f, 0.0f, 1.0f}, dir, up);
+    M3D_PROFILE_FUNCTION();
+    M3dValue trace = m.m[0][0] + m.m[1][1] + m.m[2][2];
+    Quat res;
+
+    if(trace > 0)
+    {
+        M3dValue s = m3dSqrtInternal(trace + M3D_VALUE(1)) * 2;
+        res.w = s / 4;
+        res.i = m3dDivInternal(m.m[2][1] - m.m[1][2], s);
+        res.j = m3dDivInternal(m.m[0][2] - m.m[2][0], s);
+        res.k = m3dDivInternal(m.m[1][0] - m.m[0][1], s);
+    }
+    else if(m.m[0][0] > m.m[1][1] && m.m[0][0] > m.m[2][2])
+    {
+        M3dValue s = m3dSqrtInternal(M3D_VALUE(1) + m.m[0][0] - m.m[1][1] - m.m[2][2]) * 2;
+        res.w = m3dDivInternal(m.m[2][1] - m.m[1][2], s);
+        res.i = s / 4;
+        res.j = m3dDivInternal(m.m[0][1] + m.m[1][0], s);
+        res.k = m3dDivInternal(m.m[0][2] + m.m[2][0], s);
+    }
+    else if(m.m[1][1] > m.m[2][2])
+    {
+        M3dValue s = m3dSqrtInternal(M3D_VALUE(1) + m.m[1][1] - m.m[0][0] - m.m[2][2]) * 2;
+        res.w = m3dDivInternal(m.m[0][2] - m.m[2][0], s);
+        res.i = m3dDivInternal(m.m[0][1] + m.m[1][0], s);
+        res.j = s / 4;
+        res.k = m3dDivInternal(m.m[1][2] + m.m[2][1], s);
+    }
+    else
+    {
+        M3dValue s = m3dSqrtInternal(M3D_VALUE(1) + m.m[2][2] - m.m[0][0] - m.m[1][1]) * 2;
+        res.w = m3dDivInternal(m.m[1][0] - m.m[0][1], s);
+        res.i = m3dDivInternal(m.m[0][2] + m.m[2][0], s);
+        res.j = m3dDivInternal(m.m[1][2] + m.m[2][1], s);
+        res.k = s / 4;
+    }
+
+    return res;
 }
 
-M3dValue m3dQuatLength(Quat v)
+M3D_API M3dValue m3dQuatLength(Quat v)
 {
-    M3dValue res = sqrt(v.i * v.i + v.j * v.j + v.k * v.k + v.w * v.w);
+    M3D_PROFILE_FUNCTION();
+#ifdef M3D_FIXED
+    M3dValue res = m3dFixedLengthInternal(&v.i, 4);
+#else
+    M3dValue res = m3dSqrtInternal(m3dMulInternal(v.i, v.i) + m3dMulInternal(v.j, v.j) + m3dMulInternal(v.k, v.k) + m3dMulInternal(v.w, v.w));
+#endif // M3D_FIXED
 
     return res;
 }
 
-Vec3 m3dQuatRotateVec3(Quat a, Vec3 b)
+M3D_API Quat m3dQuatLerp(Quat a, Quat b, M3dValue t)
+{
+    M3D_PROFILE_FUNCTION();
+    a.i = m3d1DLerp(a.i, b.i, t);
+    a.j = m3d1DLerp(a.j, b.j, t);
+    a.k = m3d1DLerp(a.k, b.k, t);
+    a.w = m3d1DLerp(a.w, b.w, t);
+    return a;
+}
+
+M3D_API Vec3 m3dQuatRotateVec3(Quat a, Vec3 b)
 {
-    Quat P = {b.x, b.y, b.z, 0};
+    M3D_PROFILE_FUNCTION();
+    Vec3 res;
 
-    Quat temp = m3dQuatMulQuat(m3dQuatMulQuat(a, P), m3dQuatConjugate(a));
+    m3dQuatRotateVec3Ptr(&res, &a, &b);
 
-    return (Vec3){temp.i, temp.j, temp.k};
+    return res;
 }
 
-Quat m3dQuatNormalized(Quat v)
+M3D_API Quat m3dQuatNormalized(Quat v)
 {
-    M3dValue length = m3dQuatLength(v);
-    v.i /= length;
-    v.j /= length;
-    v.k /= length;
-    v.w /= length;
+    M3D_PROFILE_FUNCTION();
+    m3dQuatNormalizeInPlace(&v);
     return v;
 }
 
-Quat m3dQuatSlerp(Quat a, Quat b, M3dValue t)
+M3D_API Quat m3dQuatSlerp(Quat a, Quat b, M3dValue t)
 {
+    M3D_PROFILE_FUNCTION();
     Quat res;
 
-    M3dValue cosHalfTheta = a.w * b.w + a.i * b.i + a.j * b.j + a.k * b.k;
-	// if qa=qb or qa=-qb then theta = 0 and we can return qa
-	if (abs(cosHalfTheta) >= 1.0)
-    {
-		return a;
-	}
-	// Calculate temporary values.
-	M3dValue halfTheta = acos(cosHalfTheta);
-	M3dValue sinHalfTheta = sqrt(1.0 - cosHalfTheta*cosHalfTheta);
-	// if theta = 180 degrees then result is not fully defined
-	// we could rotate around any axis normal to qa or qb
-	if (fabs(sinHalfTheta) < 0.001)
-	{
-	    return m3dQuatAddQuat(m3dQuatMulValue(a, 0.5), m3dQuatMulValue(b, 0.5));
-	}
+    m3dQuatSlerpPtr(&res, &a, &b, t);
+
+    return res;
+}
+
+M3D_API Quat m3dQuatSlerpFast(Quat a, Quat b, M3dValue t)
+{
+    M3D_PROFILE_FUNCTION();
+    Quat res;
 
-	//calculate Quaternion.
-	res = m3dQuatMulValue(a, sin((1 - t) * halfTheta));
-	res = m3dQuatAddQuat(res, m3dQuatMulValue(b, sin(t * halfTheta)));
-	res = m3dQuatDivValue(res, sin(halfTheta));
+    m3dQuatSlerpFastPtr(&res, &a, &b, t);
 
-	return res;
+    return res;
 }
 
-Quat m3dQuatAddQuat(Quat a, Quat b)
+M3D_API Quat m3dQuatAddQuat(Quat a, Quat b)
 {
+    M3D_PROFILE_FUNCTION();
     a.i += b.i;
     a.j += b.j;
     a.k += b.k;
@@ -135,8 +220,9 @@ Quat m3dQuatAddQuat(Quat a, Quat b)
     return a;
 }
 
-Quat m3dQuatSubQuat(Quat a, Quat b)
+M3D_API Quat m3dQuatSubQuat(Quat a, Quat b)
 {
+    M3D_PROFILE_FUNCTION();
     a.i -= b.i;
     a.j -= b.j;
     a.k -= b.k;
@@ -145,44 +231,543 @@ Quat m3dQuatSubQuat(Quat a, Quat b)
     return a;
 }
 
-Quat m3dQuatMulQuat(Quat a, Quat b)
+M3D_API Quat m3dQuatMulQuat(Quat a, Quat b)
 {
+    M3D_PROFILE_FUNCTION();
     Quat res;
 
-    res.i = a.w * b.i + a.i * b.w + a.j * b.k - a.k * b.j;
-    res.j = a.w * b.j - a.i * b.k + a.j * b.w + a.k * b.i;
-    res.k = a.w * b.k + a.i * b.j - a.j * b.i + a.k * b.w;
-    res.w = a.w * b.w - a.i * b.i - a.j * b.j - a.k * b.k;
-
-    //res.i = a.i * b.w + a.w * b.i + a.j * b.k - a.k * b.j;
-    //res.j = a.j * b.w + a.w * b.j + a.k * b.i - a.i * b.k;
-    //res.k = a.k * b.w + a.w * b.k + a.i * b.j - a.j * b.i;
-    //res.w = a.w * b.w - a.i * b.i - a.j * b.j - a.k * b.k;
+    m3dQuatMulQuatPtr(&res, &a, &b);
 
     return res;
 }
 
-Quat m3dQuatMulValue(Quat a, M3dValue b)
+M3D_API Quat m3dQuatMulValue(Quat a, M3dValue b)
 {
-    a.i *= b;
-    a.j *= b;
-    a.k *= b;
-    a.w *= b;
+    M3D_PROFILE_FUNCTION();
+    a.i = m3dMulInternal(a.i, b);
+    a.j = m3dMulInternal(a.j, b);
+    a.k = m3dMulInternal(a.k, b);
+    a.w = m3dMulInternal(a.w, b);
 
     return a;
 }
 
-Quat m3dQuatDivValue(Quat a, M3dValue b)
+M3D_API Quat m3dQuatDivValue(Quat a, M3dValue b)
 {
-    a.i /= b;
-    a.j /= b;
-    a.k /= b;
-    a.w /= b;
+    M3D_PROFILE_FUNCTION();
+    a.i = m3dDivInternal(a.i, b);
+    a.j = m3dDivInternal(a.j, b);
+    a.k = m3dDivInternal(a.k, b);
+    a.w = m3dDivInternal(a.w, b);
 
     return a;
 }
 
-char m3dQuatEqual(Quat a, Quat b)
+M3D_API char m3dQuatEqual(Quat a, Quat b)
 {
+    M3D_PROFILE_FUNCTION();
     return a.i == b.i && a.j == b.j && a.k == b.k && a.w == b.w;
 }
+
+/** ---------------- by pointer variants */
+
+M3D_API void m3dQuatMulQuatPtr(Quat *M3D_RESTRICT res, const Quat *a, const Quat *b)
+{
+    M3D_PROFILE_FUNCTION();
+    res->i = m3dMulInternal(a->w, b->i) + m3dMulInternal(a->i, b->w) + m3dMulInternal(a->j, b->k) - m3dMulInternal(a->k, b->j);
+    res->j = m3dMulInternal(a->w, b->j) - m3dMulInternal(a->i, b->k) + m3dMulInternal(a->j, b->w) + m3dMulInternal(a->k, b->i);
+    res->k = m3dMulInternal(a->w, b->k) + m3dMulInternal(a->i, b->j) - m3dMulInternal(a->j, b->i) + m3dMulInternal(a->k, b->w);
+    res->w = m3dMulInternal(a->w, b->w) - m3dMulInternal(a->i, b->i) - m3dMulInternal(a->j, b->j) - m3dMulInternal(a->k, b->k);
+
+    //res->i = a->i * b->w + a->w * b->i + a->j * b->k - a->k * b->j;
+    //res->j = a->j * b->w + a->w * b->j + a->k * b->i - a->i * b->k;
+    //res->k = a->k * b->w + a->w * b->k + a->i * b->j - a->j * b->i;
+    //res->w = a->w * b->w - a->i * b->i - a->j * b->j - a->k * b->k;
+}
+
+M3D_API void m3dQuatMulQuatInPlace(Quat *a, const Quat *b)
+{
+    M3D_PROFILE_FUNCTION();
+    Quat res;
+
+    m3dQuatMulQuatPtr(&res, a, b);
+
+    *a = res;
+}
+
+M3D_API void m3dQuatPreMulQuatInPlace(const Quat *a, Quat *b)
+{
+    M3D_PROFILE_FUNCTION();
+    Quat res;
+
+    m3dQuatMulQuatPtr(&res, a, b);
+
+    *b = res;
+}
+
+M3D_API void m3dQuatConjugateInPlace(Quat *v)
+{
+    M3D_PROFILE_FUNCTION();
+    v->i = -v->i;
+    v->j = -v->j;
+    v->k = -v->k;
+}
+
+M3D_API void m3dQuatNormalizeInPlace(Quat *v)
+{
+    M3D_PROFILE_FUNCTION();
+#if defined(M3D_FIXED)
+    m3dFixedNormalizeInternal(&v->i, 4);
+#elif defined(M3D_FAST_MATH)
+    M3dValue inv = m3dRsqrtInternal(m3dMulInternal(v->i, v->i) + m3dMulInternal(v->j, v->j) + m3dMulInternal(v->k, v->k) + m3dMulInternal(v->w, v->w));
+    v->i = m3dMulInternal(v->i, inv);
+    v->j = m3dMulInternal(v->j, inv);
+    v->k = m3dMulInternal(v->k, inv);
+    v->w = m3dMulInternal(v->w, inv);
+#else
+    M3dValue length = m3dQuatLength(*v);
+    v->i = m3dDivInternal(v->i, length);
+    v->j = m3dDivInternal(v->j, length);
+    v->k = m3dDivInternal(v->k, length);
+    v->w = m3dDivInternal(v->w, length);
+#endif // M3D_FAST_MATH
+}
+
+// a * b * conjugate(a) expanded for a pure b and a unit a:
+// t = 2 * cross(a.ijk, b), res = b + a.w * t + cross(a.ijk, t), 15 multiplies instead of 32
+M3D_API void m3dQuatRotateVec3Ptr(Vec3 *M3D_RESTRICT res, const Quat *a, const Vec3 *b)
+{
+    M3D_PROFILE_FUNCTION();
+    M3dValue tx = (m3dMulInternal(a->j, b->z) - m3dMulInternal(a->k, b->y)) * 2;
+    M3dValue ty = (m3dMulInternal(a->k, b->x) - m3dMulInternal(a->i, b->z)) * 2;
+    M3dValue tz = (m3dMulInternal(a->i, b->y) - m3dMulInternal(a->j, b->x)) * 2;
+
+    res->x = b->x + m3dMulInternal(a->w, tx) + (m3dMulInternal(a->j, tz) - m3dMulInternal(a->k, ty));
+    res->y = b->y + m3dMulInternal(a->w, ty) + (m3dMulInternal(a->k, tx) - m3dMulInternal(a->i, tz));
+    res->z = b->z + m3dMulInternal(a->w, tz) + (m3dMulInternal(a->i, ty) - m3dMulInternal(a->j, tx));
+}
+
+M3D_API void m3dQuatSlerpPtr(Quat *M3D_RESTRICT res, const Quat *a, const Quat *b, M3dValue t)
+{
+    M3D_PROFILE_FUNCTION();
+    M3dValue cosHalfTheta = m3dMulInternal(a->w, b->w) + m3dMulInternal(a->i, b->i) + m3dMulInternal(a->j, b->j) + m3dMulInternal(a->k, b->k);
+    // q and -q are the same rotation, flipping b keeps the blend on the shorter arc.
+    // sign is a plain factor of 1 or -1, not a value, so it multiplies without m3dMulInternal
+    M3dValue sign = cosHalfTheta < 0 ? -1 : 1;
+    cosHalfTheta *= sign;
+
+    M3dValue sa, sb;
+
+    // nearly the same rotation, sin(halfTheta) is too small to divide by but lerp is exact enough.
+    // this is a half angle under 0.001 radians, checked on the cosine so rounding it to 1 can't skip t
+#ifdef M3D_FIXED
+    // fewer than 21 fractional bits round that cosine to 1, then only an exact 1 takes the lerp
+    if(cosHalfTheta > m3dMinInternal(M3D_VALUE(0.9999995), M3D_FIXED_ONE - 1))
+#else
+    if(cosHalfTheta > (M3dValue)0.9999995)
+#endif
+    {
+        sa = M3D_VALUE(1) - t;
+        sb = t * sign;
+    }
+    else
+    {
+        M3dValue halfTheta = m3dAcosInternal(cosHalfTheta);
+        // (1 - c)(1 + c) rather than 1 - c*c, the square loses the low bits of c exactly where c is near 1
+        M3dValue sinHalfTheta = m3dSqrtInternal(m3dMulInternal(M3D_VALUE(1) - cosHalfTheta, M3D_VALUE(1) + cosHalfTheta));
+
+        sa = m3dDivInternal(m3dSinInternal(m3dMulInternal(M3D_VALUE(1) - t, halfTheta)), sinHalfTheta);
+        sb = m3dDivInternal(m3dSinInternal(m3dMulInternal(t, halfTheta)), sinHalfTheta) * sign;
+    }
+
+    res->i = m3dMulInternal(a->i, sa) + m3dMulInternal(b->i, sb);
+    res->j = m3dMulInternal(a->j, sa) + m3dMulInternal(b->j, sb);
+    res->k = m3dMulInternal(a->k, sa) + m3dMulInternal(b->k, sb);
+    res->w = m3dMulInternal(a->w, sa) + m3dMulInternal(b->w, sb);
+}
+
+// nlerp with t reshaped by a cubic so the angle moves at close to constant speed,
+// the coefficients are fit against the cosine of the angle between a and b.
+// https://zeux.io/2015/07/23/approximating-slerp/
+static inline M3dValue slerpFastTInternal(M3dValue d, M3dValue t)
+{
+    const M3dValue half = M3D_VALUE(0.5);
+    M3dValue ka = M3D_VALUE(1.0904) + m3dMulInternal(d, M3D_VALUE(-3.2452) + m3dMulInternal(d, M3D_VALUE(3.55645) - m3dMulInternal(d, M3D_VALUE(1.43519))));
+    M3dValue kb = M3D_VALUE(0.848013) + m3dMulInternal(d, M3D_VALUE(-1.06021) + m3dMulInternal(d, M3D_VALUE(0.215638)));
+    M3dValue k = m3dMulInternal(m3dMulInternal(ka, t - half), t - half) + kb;
+
+    return t + m3dMulInternal(m3dMulInternal(m3dMulInternal(t, t - half), t - M3D_VALUE(1)), k);
+}
+
+M3D_API void m3dQuatSlerpFastPtr(Quat *M3D_RESTRICT res, const Quat *a, const Quat *b, M3dValue t)
+{
+    M3D_PROFILE_FUNCTION();
+    M3dValue d = m3dMulInternal(a->w, b->w) + m3dMulInternal(a->i, b->i) + m3dMulInternal(a->j, b->j) + m3dMulInternal(a->k, b->k);
+    M3dValue sign = d < 0 ? -1 : 1; // a plain factor like in m3dQuatSlerpPtr
+    M3dValue ot = slerpFastTInternal(d * sign, t);
+
+    M3dValue sa = M3D_VALUE(1) - ot;
+    M3dValue sb = ot * sign;
+
+    Quat r;
+    r.i = m3dMulInternal(a->i, sa) + m3dMulInternal(b->i, sb);
+    r.j = m3dMulInternal(a->j, sa) + m3dMulInternal(b->j, sb);
+    r.k = m3dMulInternal(a->k, sa) + m3dMulInternal(b->k, sb);
+    r.w = m3dMulInternal(a->w, sa) + m3dMulInternal(b->w, sb);
+
+    M3dValue inv = m3dDivInternal(M3D_VALUE(1), m3dSqrtInternal(m3dMulInternal(r.i, r.i) + m3dMulInternal(r.j, r.j) + m3dMulInternal(r.k, r.k) + m3dMulInternal(r.w, r.w)));
+
+    res->i = m3dMulInternal(r.i, inv);
+    res->j = m3dMulInternal(r.j, inv);
+    res->k = m3dMulInternal(r.k, inv);
+    res->w = m3dMulInternal(r.w, inv);
+}
+
+/** ---------------- batch multiply */
+
+/** each kernel keeps one quaternion per register and builds the product as
+    a.w * b + a.i * b.wkji + a.j * b.kwij + a.k * b.jiwk with the signs folded into the
+    permuted b, the terms add in the m3dQuatMulQuatPtr order so sse2 and avx are identical */
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+
+static size_t mulQuatSse2(Quat *res, const Quat *a, const Quat *b, size_t count)
+{
+    const __m128 signI = _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f);
+    const __m128 signJ = _mm_set_ps(-0.0f, -0.0f, 0.0f, 0.0f);
+    const __m128 signK = _mm_set_ps(-0.0f, 0.0f, 0.0f, -0.0f);
+
+    for(size_t n = 0; n < count; n++)
+    {
+        __m128 qa = _mm_loadu_ps(&a[n].i);
+        __m128 qb = _mm_loadu_ps(&b[n].i);
+
+        __m128 r = _mm_mul_ps(_mm_shuffle_ps(qa, qa, _MM_SHUFFLE(3, 3, 3, 3)), qb);
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(qa, qa, _MM_SHUFFLE(0, 0, 0, 0)),
+                                     _mm_xor_ps(_mm_shuffle_ps(qb, qb, _MM_SHUFFLE(0, 1, 2, 3)), signI)));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(qa, qa, _MM_SHUFFLE(1, 1, 1, 1)),
+                                     _mm_xor_ps(_mm_shuffle_ps(qb, qb, _MM_SHUFFLE(1, 0, 3, 2)), signJ)));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(qa, qa, _MM_SHUFFLE(2, 2, 2, 2)),
+                                     _mm_xor_ps(_mm_shuffle_ps(qb, qb, _MM_SHUFFLE(2, 3, 0, 1)), signK)));
+        _mm_storeu_ps(&res[n].i, r);
+    }
+
+    return count;
+}
+
+#elif defined(M3D_X86_DISPATCH)
+
+// a double quaternion is one ymm register, b.jiwk swaps within the 128 bit halves and b.kwij swaps the halves
+M3D_TARGET_AVX static size_t mulQuatAvx(Quat *res, const Quat *a, const Quat *b, size_t count)
+{
+    const __m256d signI = _mm256_set_pd(-0.0, 0.0, -0.0, 0.0);
+    const __m256d signJ = _mm256_set_pd(-0.0, -0.0, 0.0, 0.0);
+    const __m256d signK = _mm256_set_pd(-0.0, 0.0, 0.0, -0.0);
+
+    for(size_t n = 0; n < count; n++)
+    {
+        __m256d qb = _mm256_loadu_pd(&b[n].i);
+        __m256d bKwij = _mm256_permute2f128_pd(qb, qb, 0x01);
+        __m256d bJiwk = _mm256_permute_pd(qb, 0x5);
+        __m256d bWkji = _mm256_permute_pd(bKwij, 0x5);
+
+        __m256d r = _mm256_mul_pd(_mm256_broadcast_sd(&a[n].w), qb);
+        r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_broadcast_sd(&a[n].i), _mm256_xor_pd(bWkji, signI)));
+        r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_broadcast_sd(&a[n].j), _mm256_xor_pd(bKwij, signJ)));
+        r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_broadcast_sd(&a[n].k), _mm256_xor_pd(bJiwk, signK)));
+        _mm256_storeu_pd(&res[n].i, r);
+    }
+
+    return count;
+}
+
+// two quaternions per zmm register, the permutes work within each 256 bit half and an odd last one
+// is masked. avx-512 always has fma, so the terms are fused like the avx2 matrix kernels
+M3D_TARGET_AVX512 static size_t mulQuatAvx512(Quat *res, const Quat *a, const Quat *b, size_t count)
+{
+    // avx512f has no xor for doubles, the sign flips go through the integer form
+    const __m512i signI = _mm512_castpd_si512(_mm512_broadcast_f64x4(_mm256_set_pd(-0.0, 0.0, -0.0, 0.0)));
+    const __m512i signJ = _mm512_castpd_si512(_mm512_broadcast_f64x4(_mm256_set_pd(-0.0, -0.0, 0.0, 0.0)));
+    const __m512i signK = _mm512_castpd_si512(_mm512_broadcast_f64x4(_mm256_set_pd(-0.0, 0.0, 0.0, -0.0)));
+
+    for(size_t n = 0; n < count; n += 2)
+    {
+        __mmask8 lanes = n + 1 < count ? 0xFF : 0x0F;
+        __m512d qa = _mm512_maskz_loadu_pd(lanes, &a[n].i);
+        __m512d qb = _mm512_maskz_loadu_pd(lanes, &b[n].i);
+
+        __m512i bWkji = _mm512_castpd_si512(_mm512_permutex_pd(qb, _MM_SHUFFLE(0, 1, 2, 3)));
+        __m512i bKwij = _mm512_castpd_si512(_mm512_permutex_pd(qb, _MM_SHUFFLE(1, 0, 3, 2)));
+        __m512i bJiwk = _mm512_castpd_si512(_mm512_permutex_pd(qb, _MM_SHUFFLE(2, 3, 0, 1)));
+
+        __m512d r = _mm512_mul_pd(_mm512_permutex_pd(qa, 0xFF), qb);
+        r = _mm512_fmadd_pd(_mm512_permutex_pd(qa, 0x00), _mm512_castsi512_pd(_mm512_xor_si512(bWkji, signI)), r);
+        r = _mm512_fmadd_pd(_mm512_permutex_pd(qa, 0x55), _mm512_castsi512_pd(_mm512_xor_si512(bKwij, signJ)), r);
+        r = _mm512_fmadd_pd(_mm512_permutex_pd(qa, 0xAA), _mm512_castsi512_pd(_mm512_xor_si512(bJiwk, signK)), r);
+        _mm512_mask_storeu_pd(&res[n].i, lanes, r);
+    }
+
+    return count;
+}
+
+#endif // M3D_SSE2
+
+M3D_API void m3dQuatMulQuatArray(Quat *M3D_RESTRICT res, const Quat *a, const Quat *b, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t n = 0;
+    unsigned int cpu = m3dCpuFeatures();
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    if(cpu & M3D_CPU_SSE2)
+    {
+        n = mulQuatSse2(res, a, b, count);
+    }
+#elif defined(M3D_X86_DISPATCH)
+    if(cpu & M3D_CPU_AVX512)
+    {
+        n = mulQuatAvx512(res, a, b, count);
+    }
+    else if(cpu & M3D_CPU_AVX)
+    {
+        n = mulQuatAvx(res, a, b, count);
+    }
+#endif
+    (void)cpu;
+
+    for(; n < count; n++)
+    {
+        m3dQuatMulQuatPtr(&res[n], &a[n], &b[n]);
+    }
+}
+
+/** ---------------- batch rotation */
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+
+// 4 vectors at once, the same operations in the same order as m3dQuatRotateVec3Ptr
+static inline void rotateVec3x4Sse2(__m128 qi, __m128 qj, __m128 qk, __m128 qw, __m128 *x, __m128 *y, __m128 *z)
+{
+    const __m128 two = _mm_set1_ps(2.0f);
+
+    __m128 tx = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(qj, *z), _mm_mul_ps(qk, *y)), two);
+    __m128 ty = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(qk, *x), _mm_mul_ps(qi, *z)), two);
+    __m128 tz = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(qi, *y), _mm_mul_ps(qj, *x)), two);
+
+    *x = _mm_add_ps(_mm_add_ps(*x, _mm_mul_ps(qw, tx)), _mm_sub_ps(_mm_mul_ps(qj, tz), _mm_mul_ps(qk, ty)));
+    *y = _mm_add_ps(_mm_add_ps(*y, _mm_mul_ps(qw, ty)), _mm_sub_ps(_mm_mul_ps(qk, tx), _mm_mul_ps(qi, tz)));
+    *z = _mm_add_ps(_mm_add_ps(*z, _mm_mul_ps(qw, tz)), _mm_sub_ps(_mm_mul_ps(qi, ty), _mm_mul_ps(qj, tx)));
+}
+
+#endif // M3D_SSE2
+
+M3D_API void m3dQuatRotateVec3Array(Vec3 *M3D_RESTRICT res, Quat q, const Vec3 *v, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t n = 0;
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    __m128 qi = _mm_set1_ps(q.i);
+    __m128 qj = _mm_set1_ps(q.j);
+    __m128 qk = _mm_set1_ps(q.k);
+    __m128 qw = _mm_set1_ps(q.w);
+
+    for(size_t last = m3dGroupEndInternal(n, count, 4); n < last; n += 4)
+    {
+        __m128 x, y, z;
+        m3dLoadVec3x4Internal(&v[n].x, &x, &y, &z);
+        rotateVec3x4Sse2(qi, qj, qk, qw, &x, &y, &z);
+        m3dStoreVec3x4Internal(&res[n].x, x, y, z, 0);
+    }
+#endif
+
+    for(; n < count; n++)
+    {
+        m3dQuatRotateVec3Ptr(&res[n], &q, &v[n]);
+    }
+}
+
+M3D_API void m3dQuatArrayRotateVec3Array(Vec3 *M3D_RESTRICT res, const Quat *q, const Vec3 *v, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t n = 0;
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    for(size_t last = m3dGroupEndInternal(n, count, 4); n < last; n += 4)
+    {
+        __m128 qi = _mm_loadu_ps(&q[n].i);
+        __m128 qj = _mm_loadu_ps(&q[n + 1].i);
+        __m128 qk = _mm_loadu_ps(&q[n + 2].i);
+        __m128 qw = _mm_loadu_ps(&q[n + 3].i);
+
+        _MM_TRANSPOSE4_PS(qi, qj, qk, qw);
+
+        __m128 x, y, z;
+        m3dLoadVec3x4Internal(&v[n].x, &x, &y, &z);
+        rotateVec3x4Sse2(qi, qj, qk, qw, &x, &y, &z);
+        m3dStoreVec3x4Internal(&res[n].x, x, y, z, 0);
+    }
+#endif
+
+    for(; n < count; n++)
+    {
+        m3dQuatRotateVec3Ptr(&res[n], &q[n], &v[n]);
+    }
+}
+
+/** ---------------- batch slerp */
+
+M3D_API void m3dQuatSlerpArray(Quat *M3D_RESTRICT res, const Quat *a, const Quat *b, const M3dValue *t, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    for(size_t n = 0; n < count; n++)
+    {
+        m3dQuatSlerpPtr(&res[n], &a[n], &b[n], t[n]);
+    }
+}
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+
+// 4 blends per step, transposed so every component is its own register,
+// the same operations in the same order as m3dQuatSlerpFastPtr
+static size_t slerpFastSse2(Quat *res, const Quat *a, const Quat *b, const M3dValue *t, size_t count)
+{
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    size_t n = 0;
+
+    for(size_t last = m3dGroupEndInternal(n, count, 4); n < last; n += 4)
+    {
+        __m128 ai = _mm_loadu_ps(&a[n].i);
+        __m128 aj = _mm_loadu_ps(&a[n + 1].i);
+        __m128 ak = _mm_loadu_ps(&a[n + 2].i);
+        __m128 aw = _mm_loadu_ps(&a[n + 3].i);
+        __m128 bi = _mm_loadu_ps(&b[n].i);
+        __m128 bj = _mm_loadu_ps(&b[n + 1].i);
+        __m128 bk = _mm_loadu_ps(&b[n + 2].i);
+        __m128 bw = _mm_loadu_ps(&b[n + 3].i);
+
+        _MM_TRANSPOSE4_PS(ai, aj, ak, aw);
+        _MM_TRANSPOSE4_PS(bi, bj, bk, bw);
+
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(aw, bw), _mm_mul_ps(ai, bi)), _mm_mul_ps(aj, bj)), _mm_mul_ps(ak, bk));
+        __m128 sign = _mm_and_ps(d, signBit);
+        d = _mm_xor_ps(d, sign);
+
+        __m128 tt = _mm_loadu_ps(t + n);
+        __m128 th = _mm_sub_ps(tt, half);
+
+        __m128 ka = _mm_sub_ps(_mm_set1_ps(3.55645f), _mm_mul_ps(d, _mm_set1_ps(1.43519f)));
+        ka = _mm_add_ps(_mm_set1_ps(-3.2452f), _mm_mul_ps(d, ka));
+        ka = _mm_add_ps(_mm_set1_ps(1.0904f), _mm_mul_ps(d, ka));
+        __m128 kb = _mm_add_ps(_mm_set1_ps(-1.06021f), _mm_mul_ps(d, _mm_set1_ps(0.215638f)));
+        kb = _mm_add_ps(_mm_set1_ps(0.848013f), _mm_mul_ps(d, kb));
+        __m128 k = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ka, th), th), kb);
+        __m128 ot = _mm_add_ps(tt, _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(tt, th), _mm_sub_ps(tt, one)), k));
+
+        __m128 sa = _mm_sub_ps(one, ot);
+        __m128 sb = _mm_xor_ps(ot, sign);
+
+        __m128 ri = _mm_add_ps(_mm_mul_ps(ai, sa), _mm_mul_ps(bi, sb));
+        __m128 rj = _mm_add_ps(_mm_mul_ps(aj, sa), _mm_mul_ps(bj, sb));
+        __m128 rk = _mm_add_ps(_mm_mul_ps(ak, sa), _mm_mul_ps(bk, sb));
+        __m128 rw = _mm_add_ps(_mm_mul_ps(aw, sa), _mm_mul_ps(bw, sb));
+
+        __m128 len = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ri, ri), _mm_mul_ps(rj, rj)), _mm_mul_ps(rk, rk)), _mm_mul_ps(rw, rw));
+        __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(len));
+
+        ri = _mm_mul_ps(ri, inv);
+        rj = _mm_mul_ps(rj, inv);
+        rk = _mm_mul_ps(rk, inv);
+        rw = _mm_mul_ps(rw, inv);
+
+        _MM_TRANSPOSE4_PS(ri, rj, rk, rw);
+
+        _mm_storeu_ps(&res[n].i, ri);
+        _mm_storeu_ps(&res[n + 1].i, rj);
+        _mm_storeu_ps(&res[n + 2].i, rk);
+        _mm_storeu_ps(&res[n + 3].i, rw);
+    }
+
+    return n;
+}
+
+#endif // M3D_SSE2
+
+M3D_API void m3dQuatSlerpFastArray(Quat *M3D_RESTRICT res, const Quat *a, const Quat *b, const M3dValue *t, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t n = 0;
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    if(m3dCpuFeatures() & M3D_CPU_SSE2)
+    {
+        n = slerpFastSse2(res, a, b, t, count);
+    }
+#endif
+
+    for(; n < count; n++)
+    {
+        m3dQuatSlerpFastPtr(&res[n], &a[n], &b[n], t[n]);
+    }
+}
+
+/** ---------------- batch construction */
+
+M3D_API void m3dQuatAngleAxisArray(Quat *M3D_RESTRICT res, const M3dValue *r, const Vec3 *a, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t n = 0;
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    for(size_t last = m3dGroupEndInternal(n, count, 4); n < last; n += 4)
+    {
+        __m128 s, c, x, y, z;
+        m3dSinCos4Internal(_mm_mul_ps(_mm_loadu_ps(r + n), _mm_set1_ps(0.5f)), &s, &c);
+        m3dLoadVec3x4Internal(&a[n].x, &x, &y, &z);
+
+        m3dStoreQuatx4Internal(res + n, _mm_mul_ps(x, s), _mm_mul_ps(y, s), _mm_mul_ps(z, s), c);
+    }
+#endif
+
+    for(; n < count; n++)
+    {
+        res[n] = m3dQuatAngleAxis(r[n], a[n]);
+    }
+}
+
+M3D_API void m3dQuatFromEulerArray(Quat *M3D_RESTRICT res, const Vec3 *e, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t n = 0;
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    for(size_t last = m3dGroupEndInternal(n, count, 4); n < last; n += 4)
+    {
+        __m128 x, y, z, sx, cx, sy, cy, sz, cz;
+        m3dLoadVec3x4Internal(&e[n].x, &x, &y, &z);
+        m3dSinCos4Internal(_mm_mul_ps(x, half), &sx, &cx);
+        m3dSinCos4Internal(_mm_mul_ps(y, half), &sy, &cy);
+        m3dSinCos4Internal(_mm_mul_ps(z, half), &sz, &cz);
+
+        __m128 cycz = _mm_mul_ps(cy, cz);
+        __m128 sysz = _mm_mul_ps(sy, sz);
+        __m128 sycz = _mm_mul_ps(sy, cz);
+        __m128 cysz = _mm_mul_ps(cy, sz);
+
+        m3dStoreQuatx4Internal(res + n,
+                               _mm_sub_ps(_mm_mul_ps(sx, cycz), _mm_mul_ps(cx, sysz)),
+                               _mm_add_ps(_mm_mul_ps(cx, sycz), _mm_mul_ps(sx, cysz)),
+                               _mm_sub_ps(_mm_mul_ps(cx, cysz), _mm_mul_ps(sx, sycz)),
+                               _mm_add_ps(_mm_mul_ps(cx, cycz), _mm_mul_ps(sx, sysz)));
+    }
+#endif
+
+    for(; n < count; n++)
+    {
+        res[n] = m3dQuatFromEuler(e[n]);
+    }
+}
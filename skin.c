@@ -0,0 +1,161 @@
+#include "m3d/m3d.h"
+#include "internal.h"
+
+#ifndef M3D_FIXED
+
+// Mat4x4 and Mat3x4 both start with the three affine rows, so a palette is
+// read as rows of 4 values with 16 or 12 values from one bone to the next
+static inline const M3dValue *paletteInternal(const M3dSkin *s, size_t *stride)
+{
+    *stride = s->palette ? 16 : 12;
+    return s->palette ? &s->palette[0].m[0][0] : &s->affinePalette[0].m[0][0];
+}
+
+// rows = the weighted sum of the 4 bones of vertex n
+static inline void blendScalar(M3dValue (*rows)[4], const M3dSkin *s, const M3dValue *palette, size_t stride, size_t n)
+{
+    const uint16_t *b = s->bones + 4 * n;
+    const M3dValue *w = s->weights + 4 * n;
+
+    for(int i = 0; i < 12; i++)
+    {
+        rows[i / 4][i % 4] = palette[stride * b[0] + (size_t)i] * w[0];
+    }
+
+    for(int k = 1; k < 4; k++)
+    {
+        for(int i = 0; i < 12; i++)
+        {
+            rows[i / 4][i % 4] += palette[stride * b[k] + (size_t)i] * w[k];
+        }
+    }
+}
+
+static void linearSkinScalar(const M3dSkin *s, const M3dValue *palette, size_t stride, size_t begin, size_t end)
+{
+    for(size_t n = begin; n < end; n++)
+    {
+        M3dValue m[3][4];
+        blendScalar(m, s, palette, stride, n);
+
+        // copies first, the results may be written over the inputs
+        if(s->position)
+        {
+            Vec3 p = s->position[n];
+            s->resPosition[n].x = m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3];
+            s->resPosition[n].y = m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3];
+            s->resPosition[n].z = m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3];
+        }
+
+        if(s->normal)
+        {
+            Vec3 v = s->normal[n];
+            s->resNormal[n].x = m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z;
+            s->resNormal[n].y = m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z;
+            s->resNormal[n].z = m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z;
+        }
+    }
+}
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+
+// the 3 rows times each of the 4 vertices in v, summed across so the result is x, y and z
+// of the 4 vertices, the same order of operations as linearSkinScalar. directions leave out the
+// translation column instead of adding it times 0
+static inline void transformx4Internal(const __m128 (*rows)[3], const M3dValue *v, int point, M3dValue *res)
+{
+    __m128 p0, p1, p2, p3;
+    m3dLoadVec3x4Internal(v, &p0, &p1, &p2);
+    p3 = _mm_set1_ps(1.0f);
+
+    _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+
+    __m128 p[4] = {p0, p1, p2, p3};
+    __m128 out[3];
+
+    for(int r = 0; r < 3; r++)
+    {
+        __m128 a0 = _mm_mul_ps(rows[0][r], p[0]);
+        __m128 a1 = _mm_mul_ps(rows[1][r], p[1]);
+        __m128 a2 = _mm_mul_ps(rows[2][r], p[2]);
+        __m128 a3 = _mm_mul_ps(rows[3][r], p[3]);
+
+        _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+
+        out[r] = _mm_add_ps(_mm_add_ps(a0, a1), a2);
+        out[r] = point ? _mm_add_ps(out[r], a3) : out[r];
+    }
+
+    m3dStoreVec3x4Internal(res, out[0], out[1], out[2], 0);
+}
+
+// blending is one multiply add per row and bone on whole rows, 4 vertices per step so the
+// vertex streams load and store as whole registers
+static size_t linearSkinSse2(const M3dSkin *s, const M3dValue *palette, size_t stride, size_t begin, size_t end)
+{
+    size_t n = begin;
+
+    for(size_t last = m3dGroupEndInternal(n, end, 4); n < last; n += 4)
+    {
+        __m128 rows[4][3];
+
+        for(int v = 0; v < 4; v++)
+        {
+            const uint16_t *b = s->bones + 4 * (n + (size_t)v);
+            const M3dValue *w = s->weights + 4 * (n + (size_t)v);
+
+            for(int r = 0; r < 3; r++)
+            {
+                rows[v][r] = _mm_mul_ps(_mm_loadu_ps(palette + stride * b[0] + 4 * (size_t)r), _mm_set1_ps(w[0]));
+            }
+
+            for(int k = 1; k < 4; k++)
+            {
+                const M3dValue *bone = palette + stride * b[k];
+                __m128 wk = _mm_set1_ps(w[k]);
+
+                for(int r = 0; r < 3; r++)
+                {
+                    rows[v][r] = _mm_add_ps(rows[v][r], _mm_mul_ps(_mm_loadu_ps(bone + 4 * (size_t)r), wk));
+                }
+            }
+        }
+
+        if(s->position)
+        {
+            transformx4Internal((const __m128 (*)[3])rows, &s->position[n].x, 1, &s->resPosition[n].x);
+        }
+
+        if(s->normal)
+        {
+            transformx4Internal((const __m128 (*)[3])rows, &s->normal[n].x, 0, &s->resNormal[n].x);
+        }
+    }
+
+    return n;
+}
+
+#endif // M3D_SSE2
+
+M3D_API void m3dSkinUpdateRange(M3dSkin s, size_t begin, size_t end)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t stride;
+    const M3dValue *palette = paletteInternal(&s, &stride);
+    size_t n = begin;
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    n = linearSkinSse2(&s, palette, stride, begin, end);
+#endif
+
+    linearSkinScalar(&s, palette, stride, n, end);
+}
+
+M3D_API void m3dSkinUpdate(M3dSkin s)
+{
+    M3D_PROFILE_FUNCTION();
+    // every vertex only reads its own inputs, so the mesh can be split in any way
+    M3D_PARALLEL_BLOCKS(begin, end, 0, s.count, M3D_SKIN_PARALLEL_MIN, m3dSkinUpdateRange(s, begin, end));
+}
+
+#endif // M3D_FIXED
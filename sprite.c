@@ -0,0 +1,210 @@
+#include "m3d/m3d.h"
+#include "internal.h"
+#include <stdint.h>
+
+#ifndef M3D_FIXED
+
+// sprites per thread block of the quad batch, each one only writes 4 vertices
+#define SPRITE_PARALLEL_MIN 8192
+
+// T * R * S of one sprite, the rotation of m3dMat3x3RotatePtr with its columns scaled
+static inline void spriteRowsInternal(M3dValue (*rows)[3], M3dValue tx, M3dValue ty, M3dValue c, M3dValue sn, M3dValue sx, M3dValue sy)
+{
+    rows[0][0] = c * sx;
+    rows[0][1] = -sn * sy;
+    rows[0][2] = tx;
+    rows[1][0] = sn * sx;
+    rows[1][1] = c * sy;
+    rows[1][2] = ty;
+}
+
+M3D_API Mat3x3 m3dMat3x3FromTrs(Vec2 t, M3dValue r, Vec2 s)
+{
+    M3D_PROFILE_FUNCTION();
+    Mat3x3 res;
+
+    spriteRowsInternal(res.m, t.x, t.y, m3dCosInternal(r), m3dSinInternal(r), s.x, s.y);
+    res.m[2][0] = 0;
+    res.m[2][1] = 0;
+    res.m[2][2] = 1;
+
+    return res;
+}
+
+M3D_API void m3dMat3x3FromTrsSoa(Mat3x3 *M3D_RESTRICT res, Vec2Soa t, const M3dValue *r, Vec2Soa s)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t n = 0;
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    for(size_t last = m3dGroupEndInternal(n, t.count, 4); n < last; n += 4)
+    {
+        __m128 sn, c;
+        m3dSinCos4Internal(_mm_loadu_ps(r + n), &sn, &c);
+
+        __m128 sx = _mm_loadu_ps(s.x + n);
+        __m128 sy = _mm_loadu_ps(s.y + n);
+        M3dValue e[6][4];
+
+        _mm_storeu_ps(e[0], _mm_mul_ps(c, sx));
+        _mm_storeu_ps(e[1], _mm_mul_ps(_mm_xor_ps(sn, _mm_set1_ps(-0.0f)), sy));
+        _mm_storeu_ps(e[2], _mm_mul_ps(sn, sx));
+        _mm_storeu_ps(e[3], _mm_mul_ps(c, sy));
+
+        // a Mat3x3 is 9 values, so the 4 matrices are written element by element
+        for(int k = 0; k < 4; k++)
+        {
+            Mat3x3 *m = &res[n + (size_t)k];
+            m->m[0][0] = e[0][k];
+            m->m[0][1] = e[1][k];
+            m->m[0][2] = t.x[n + (size_t)k];
+            m->m[1][0] = e[2][k];
+            m->m[1][1] = e[3][k];
+            m->m[1][2] = t.y[n + (size_t)k];
+            m->m[2][0] = 0;
+            m->m[2][1] = 0;
+            m->m[2][2] = 1;
+        }
+    }
+#endif
+
+    for(; n < t.count; n++)
+    {
+        Vec2 tn = {t.x[n], t.y[n]};
+        Vec2 sn = {s.x[n], s.y[n]};
+        res[n] = m3dMat3x3FromTrs(tn, r[n], sn);
+    }
+}
+
+/** ---------------- quads */
+
+// camera * T * R * S as 2 rows, then the corners of the quad through them
+static void quadsScalar(const Mat3x3 *camera, Vec2 *res, Vec2Soa t, const M3dValue *r, Vec2Soa s,
+                        const Vec2 *corners, size_t begin, size_t end)
+{
+    const M3dValue (*cm)[3] = camera->m;
+
+    for(size_t n = begin; n < end; n++)
+    {
+        M3dValue l[2][3];
+        spriteRowsInternal(l, t.x[n], t.y[n], m3dCosInternal(r[n]), m3dSinInternal(r[n]), s.x[n], s.y[n]);
+
+        M3dValue a = cm[0][0] * l[0][0] + cm[0][1] * l[1][0];
+        M3dValue b = cm[0][0] * l[0][1] + cm[0][1] * l[1][1];
+        M3dValue e = cm[0][0] * l[0][2] + cm[0][1] * l[1][2] + cm[0][2];
+        M3dValue c = cm[1][0] * l[0][0] + cm[1][1] * l[1][0];
+        M3dValue d = cm[1][0] * l[0][1] + cm[1][1] * l[1][1];
+        M3dValue f = cm[1][0] * l[0][2] + cm[1][1] * l[1][2] + cm[1][2];
+
+        for(int k = 0; k < 4; k++)
+        {
+            res[4 * n + (size_t)k].x = a * corners[k].x + b * corners[k].y + e;
+            res[4 * n + (size_t)k].y = c * corners[k].x + d * corners[k].y + f;
+        }
+    }
+}
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+
+static inline void storeSpriteInternal(M3dValue *res, __m128 v, int stream)
+{
+    if(stream)
+    {
+        _mm_stream_ps(res, v);
+    }
+    else
+    {
+        _mm_storeu_ps(res, v);
+    }
+}
+
+// 4 sprites per step, every lane is one sprite through the operations of quadsScalar,
+// then the x and y registers of the corners are interleaved into 2 stores per sprite
+static size_t quadsSse2(const Mat3x3 *camera, Vec2 *res, Vec2Soa t, const M3dValue *r, Vec2Soa s,
+                        const Vec2 *corners, size_t begin, size_t end, int stream)
+{
+    const M3dValue (*cm)[3] = camera->m;
+    __m128 c00 = _mm_set1_ps(cm[0][0]), c01 = _mm_set1_ps(cm[0][1]), c02 = _mm_set1_ps(cm[0][2]);
+    __m128 c10 = _mm_set1_ps(cm[1][0]), c11 = _mm_set1_ps(cm[1][1]), c12 = _mm_set1_ps(cm[1][2]);
+    size_t n = begin;
+
+    for(size_t last = m3dGroupEndInternal(n, end, 4); n < last; n += 4)
+    {
+        __m128 sn, cs;
+        m3dSinCos4Internal(_mm_loadu_ps(r + n), &sn, &cs);
+
+        __m128 sx = _mm_loadu_ps(s.x + n);
+        __m128 sy = _mm_loadu_ps(s.y + n);
+        __m128 tx = _mm_loadu_ps(t.x + n);
+        __m128 ty = _mm_loadu_ps(t.y + n);
+
+        __m128 l00 = _mm_mul_ps(cs, sx);
+        __m128 l01 = _mm_mul_ps(_mm_xor_ps(sn, _mm_set1_ps(-0.0f)), sy);
+        __m128 l10 = _mm_mul_ps(sn, sx);
+        __m128 l11 = _mm_mul_ps(cs, sy);
+
+        __m128 a = _mm_add_ps(_mm_mul_ps(c00, l00), _mm_mul_ps(c01, l10));
+        __m128 b = _mm_add_ps(_mm_mul_ps(c00, l01), _mm_mul_ps(c01, l11));
+        __m128 e = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c00, tx), _mm_mul_ps(c01, ty)), c02);
+        __m128 c = _mm_add_ps(_mm_mul_ps(c10, l00), _mm_mul_ps(c11, l10));
+        __m128 d = _mm_add_ps(_mm_mul_ps(c10, l01), _mm_mul_ps(c11, l11));
+        __m128 f = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c10, tx), _mm_mul_ps(c11, ty)), c12);
+
+        M3dValue *o = &res[4 * n].x;
+
+        // two corners at a time, their xy for sprites 0 and 1 in lo and 2 and 3 in hi
+        // interleave into half the 8 values of every sprite
+        for(int k = 0; k < 4; k += 2)
+        {
+            __m128 u0 = _mm_set1_ps(corners[k].x), v0 = _mm_set1_ps(corners[k].y);
+            __m128 u1 = _mm_set1_ps(corners[k + 1].x), v1 = _mm_set1_ps(corners[k + 1].y);
+
+            __m128 x0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, u0), _mm_mul_ps(b, v0)), e);
+            __m128 y0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c, u0), _mm_mul_ps(d, v0)), f);
+            __m128 x1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, u1), _mm_mul_ps(b, v1)), e);
+            __m128 y1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c, u1), _mm_mul_ps(d, v1)), f);
+
+            __m128 lo0 = _mm_unpacklo_ps(x0, y0), hi0 = _mm_unpackhi_ps(x0, y0);
+            __m128 lo1 = _mm_unpacklo_ps(x1, y1), hi1 = _mm_unpackhi_ps(x1, y1);
+
+            storeSpriteInternal(o + 2 * k, _mm_movelh_ps(lo0, lo1), stream);
+            storeSpriteInternal(o + 8 + 2 * k, _mm_movehl_ps(lo1, lo0), stream);
+            storeSpriteInternal(o + 16 + 2 * k, _mm_movelh_ps(hi0, hi1), stream);
+            storeSpriteInternal(o + 24 + 2 * k, _mm_movehl_ps(hi1, hi0), stream);
+        }
+    }
+
+    return n;
+}
+
+#endif // M3D_SSE2
+
+static void quadsRangeInternal(const Mat3x3 *camera, Vec2 *res, Vec2Soa t, const M3dValue *r, Vec2Soa s,
+                               const Vec2 *corners, size_t begin, size_t end, unsigned int flags)
+{
+    size_t n = begin;
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    int stream = (flags & M3D_TRANSFORM_STREAM) && ((uintptr_t)res & 15) == 0;
+    n = quadsSse2(camera, res, t, r, s, corners, begin, end, stream);
+
+    if(stream)
+    {
+        _mm_sfence();
+    }
+#else
+    (void)flags;
+#endif
+
+    quadsScalar(camera, res, t, r, s, corners, n, end);
+}
+
+M3D_API void m3dMat3x3TransformSpriteQuads(Mat3x3 camera, Vec2 *M3D_RESTRICT res, Vec2Soa t, const M3dValue *r, Vec2Soa s,
+                                           const Vec2 *corners, unsigned int flags)
+{
+    M3D_PROFILE_FUNCTION();
+    M3D_PARALLEL_BLOCKS(begin, end, 0, t.count, SPRITE_PARALLEL_MIN,
+                        quadsRangeInternal(&camera, res, t, r, s, corners, begin, end, flags));
+}
+
+#endif // M3D_FIXED
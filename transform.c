@@ -0,0 +1,288 @@
+#include "m3d/m3d.h"
+#include "internal.h"
+#include <stdint.h>
+
+#ifndef M3D_FIXED
+
+#define STRIDED_AT(type, base, stride, i) ((type *)((char *)(base) + (stride) * (i)))
+#define STRIDED_AT_CONST(type, base, stride, i) ((const type *)((const char *)(base) + (stride) * (i)))
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+
+// elements to handle one at a time before res + i reaches a 16 byte boundary,
+// returns 0 when streaming was not asked for or the boundary can't be reached
+static size_t streamPeelInternal(const void *res, size_t size, size_t count, unsigned int flags)
+{
+    if(!(flags & M3D_TRANSFORM_STREAM))
+    {
+        return 0;
+    }
+
+    for(size_t i = 0; i < 4 && i < count; i++)
+    {
+        if((((uintptr_t)res + size * i) & 15) == 0)
+        {
+            return i;
+        }
+    }
+
+    return count;
+}
+
+#endif // M3D_SSE2
+
+/** ---------------- Mat4x4 */
+
+static void transformVec3Scalar(const Mat4x4 *m, Vec3 *res, size_t resStride, const Vec3 *v, size_t stride,
+                                size_t begin, size_t end, unsigned int flags)
+{
+    M3dValue w = (flags & M3D_TRANSFORM_DIRECTION) ? 0 : 1;
+
+    for(size_t i = begin; i < end; i++)
+    {
+        Vec3 p = *STRIDED_AT_CONST(Vec3, v, stride, i);
+        Vec3 r;
+
+        r.x = m->m[0][0] * p.x + m->m[0][1] * p.y + m->m[0][2] * p.z + m->m[0][3] * w;
+        r.y = m->m[1][0] * p.x + m->m[1][1] * p.y + m->m[1][2] * p.z + m->m[1][3] * w;
+        r.z = m->m[2][0] * p.x + m->m[2][1] * p.y + m->m[2][2] * p.z + m->m[2][3] * w;
+
+        if(flags & M3D_TRANSFORM_PERSPECTIVE)
+        {
+            M3dValue rw = m->m[3][0] * p.x + m->m[3][1] * p.y + m->m[3][2] * p.z + m->m[3][3] * w;
+            r.x /= rw;
+            r.y /= rw;
+            r.z /= rw;
+        }
+
+        *STRIDED_AT(Vec3, res, resStride, i) = r;
+    }
+}
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+
+// one row of m against 4 vectors at once, summed in the m3dMat4x4MulVec4 order
+static inline __m128 transformRowSse2(const M3dValue *row, __m128 x, __m128 y, __m128 z, char point)
+{
+    __m128 r = _mm_mul_ps(_mm_set1_ps(row[0]), x);
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(row[1]), y));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(row[2]), z));
+
+    return point ? _mm_add_ps(r, _mm_set1_ps(row[3])) : r;
+}
+
+// packed Vec3s, 4 per step, deinterleaved so each row is one multiply add chain
+static size_t transformVec3Sse2(const Mat4x4 *m, Vec3 *res, const Vec3 *v, size_t begin, size_t count, unsigned int flags)
+{
+    char point = !(flags & M3D_TRANSFORM_DIRECTION);
+    int stream = (flags & M3D_TRANSFORM_STREAM) && (((uintptr_t)(res + begin) & 15) == 0);
+    size_t i = begin;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        __m128 x, y, z;
+        m3dLoadVec3x4Internal(&v[i].x, &x, &y, &z);
+
+        __m128 rx = transformRowSse2(m->m[0], x, y, z, point);
+        __m128 ry = transformRowSse2(m->m[1], x, y, z, point);
+        __m128 rz = transformRowSse2(m->m[2], x, y, z, point);
+
+        if(flags & M3D_TRANSFORM_PERSPECTIVE)
+        {
+            __m128 rw = transformRowSse2(m->m[3], x, y, z, point);
+            rx = _mm_div_ps(rx, rw);
+            ry = _mm_div_ps(ry, rw);
+            rz = _mm_div_ps(rz, rw);
+        }
+
+        m3dStoreVec3x4Internal(&res[i].x, rx, ry, rz, stream);
+    }
+
+    return i;
+}
+
+#endif // M3D_SSE2
+
+M3D_API void m3dMat4x4TransformVec3Array(Mat4x4 m, Vec3 *res, size_t resStride, const Vec3 *v, size_t stride, size_t count, unsigned int flags)
+{
+    M3D_PROFILE_FUNCTION();
+    resStride = resStride ? resStride : sizeof(Vec3);
+    stride = stride ? stride : sizeof(Vec3);
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    if(resStride == sizeof(Vec3) && stride == sizeof(Vec3))
+    {
+        size_t peel = streamPeelInternal(res, sizeof(Vec3), count, flags);
+        transformVec3Scalar(&m, res, resStride, v, stride, 0, peel, flags);
+
+        size_t done = transformVec3Sse2(&m, res, v, peel, count, flags);
+        transformVec3Scalar(&m, res, resStride, v, stride, done, count, flags);
+
+        if(flags & M3D_TRANSFORM_STREAM)
+        {
+            _mm_sfence();
+        }
+
+        return;
+    }
+#endif
+
+    transformVec3Scalar(&m, res, resStride, v, stride, 0, count, flags);
+}
+
+M3D_API void m3dMat4x4TransformVec4Array(Mat4x4 m, Vec4 *res, size_t resStride, const Vec4 *v, size_t stride, size_t count, unsigned int flags)
+{
+    M3D_PROFILE_FUNCTION();
+    resStride = resStride ? resStride : sizeof(Vec4);
+    stride = stride ? stride : sizeof(Vec4);
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    // a Vec4 is one register, so no deinterleave is needed and any stride works
+    __m128 c0 = _mm_loadu_ps(m.m[0]);
+    __m128 c1 = _mm_loadu_ps(m.m[1]);
+    __m128 c2 = _mm_loadu_ps(m.m[2]);
+    __m128 c3 = _mm_loadu_ps(m.m[3]);
+
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+    for(size_t i = 0; i < count; i++)
+    {
+        __m128 p = _mm_loadu_ps(&STRIDED_AT_CONST(Vec4, v, stride, i)->x);
+        M3dValue *out = &STRIDED_AT(Vec4, res, resStride, i)->x;
+
+        __m128 r = _mm_mul_ps(c0, _mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0)));
+        r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1))));
+        r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2))));
+        r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3))));
+
+        if(flags & M3D_TRANSFORM_PERSPECTIVE)
+        {
+            r = _mm_div_ps(r, _mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3)));
+        }
+
+        if((flags & M3D_TRANSFORM_STREAM) && ((uintptr_t)out & 15) == 0)
+        {
+            _mm_stream_ps(out, r);
+        }
+        else
+        {
+            _mm_storeu_ps(out, r);
+        }
+    }
+
+    if(flags & M3D_TRANSFORM_STREAM)
+    {
+        _mm_sfence();
+    }
+#else
+    for(size_t i = 0; i < count; i++)
+    {
+        Vec4 r = m3dMat4x4MulVec4(m, *STRIDED_AT_CONST(Vec4, v, stride, i));
+
+        if(flags & M3D_TRANSFORM_PERSPECTIVE)
+        {
+            r.x /= r.w;
+            r.y /= r.w;
+            r.z /= r.w;
+            r.w /= r.w;
+        }
+
+        *STRIDED_AT(Vec4, res, resStride, i) = r;
+    }
+#endif
+}
+
+/** ---------------- Mat3x3 */
+
+M3D_API void m3dMat3x3TransformVec3Array(Mat3x3 m, Vec3 *res, size_t resStride, const Vec3 *v, size_t stride, size_t count, unsigned int flags)
+{
+    M3D_PROFILE_FUNCTION();
+    // the upper 3x3 of a Mat4x4 in direction mode is the same multiplication
+    m3dMat4x4TransformVec3Array(m3dMat4x4FromMat3x3(m), res, resStride, v, stride, count,
+                                M3D_TRANSFORM_DIRECTION | (flags & M3D_TRANSFORM_STREAM));
+}
+
+static void transformVec2Scalar(const Mat3x3 *m, Vec2 *res, size_t resStride, const Vec2 *v, size_t stride,
+                                size_t begin, size_t end, unsigned int flags)
+{
+    M3dValue w = (flags & M3D_TRANSFORM_DIRECTION) ? 0 : 1;
+
+    for(size_t i = begin; i < end; i++)
+    {
+        Vec2 p = *STRIDED_AT_CONST(Vec2, v, stride, i);
+        Vec2 r;
+
+        r.x = m->m[0][0] * p.x + m->m[0][1] * p.y + m->m[0][2] * w;
+        r.y = m->m[1][0] * p.x + m->m[1][1] * p.y + m->m[1][2] * w;
+
+        if(flags & M3D_TRANSFORM_PERSPECTIVE)
+        {
+            M3dValue rw = m->m[2][0] * p.x + m->m[2][1] * p.y + m->m[2][2] * w;
+            r.x /= rw;
+            r.y /= rw;
+        }
+
+        *STRIDED_AT(Vec2, res, resStride, i) = r;
+    }
+}
+
+M3D_API void m3dMat3x3TransformVec2Array(Mat3x3 m, Vec2 *res, size_t resStride, const Vec2 *v, size_t stride, size_t count, unsigned int flags)
+{
+    M3D_PROFILE_FUNCTION();
+    resStride = resStride ? resStride : sizeof(Vec2);
+    stride = stride ? stride : sizeof(Vec2);
+    size_t i = 0;
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    if(resStride == sizeof(Vec2) && stride == sizeof(Vec2))
+    {
+        size_t peel = streamPeelInternal(res, sizeof(Vec2), count, flags);
+        transformVec2Scalar(&m, res, resStride, v, stride, 0, peel, flags);
+
+        int stream = (flags & M3D_TRANSFORM_STREAM) && (((uintptr_t)(res + peel) & 15) == 0);
+        __m128 w = _mm_set1_ps((flags & M3D_TRANSFORM_DIRECTION) ? 0.0f : 1.0f);
+
+        // 4 Vec2s per step, split into x and y registers
+        for(i = peel; i < m3dGroupEndInternal(peel, count, 4); i += 4)
+        {
+            __m128 a = _mm_loadu_ps(&v[i].x);
+            __m128 b = _mm_loadu_ps(&v[i + 2].x);
+            __m128 x = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 y = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+
+            __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m[0][0]), x), _mm_mul_ps(_mm_set1_ps(m.m[0][1]), y)),
+                                   _mm_mul_ps(_mm_set1_ps(m.m[0][2]), w));
+            __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m[1][0]), x), _mm_mul_ps(_mm_set1_ps(m.m[1][1]), y)),
+                                   _mm_mul_ps(_mm_set1_ps(m.m[1][2]), w));
+
+            if(flags & M3D_TRANSFORM_PERSPECTIVE)
+            {
+                __m128 rw = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m[2][0]), x), _mm_mul_ps(_mm_set1_ps(m.m[2][1]), y)),
+                                       _mm_mul_ps(_mm_set1_ps(m.m[2][2]), w));
+                rx = _mm_div_ps(rx, rw);
+                ry = _mm_div_ps(ry, rw);
+            }
+
+            if(stream)
+            {
+                _mm_stream_ps(&res[i].x, _mm_unpacklo_ps(rx, ry));
+                _mm_stream_ps(&res[i + 2].x, _mm_unpackhi_ps(rx, ry));
+            }
+            else
+            {
+                _mm_storeu_ps(&res[i].x, _mm_unpacklo_ps(rx, ry));
+                _mm_storeu_ps(&res[i + 2].x, _mm_unpackhi_ps(rx, ry));
+            }
+        }
+
+        if(flags & M3D_TRANSFORM_STREAM)
+        {
+            _mm_sfence();
+        }
+    }
+#endif
+
+    transformVec2Scalar(&m, res, resStride, v, stride, i, count, flags);
+}
+
+#endif // M3D_FIXED
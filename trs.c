@@ -0,0 +1,188 @@
+#include "m3d/m3d.h"
+#include "internal.h"
+
+#ifndef M3D_FIXED
+
+// instances per thread block of the batch forms, one matrix is cheap to build
+#define TRS_PARALLEL_MIN 4096
+
+// T * R * S without any multiply: the rotation columns scaled by s and t in the last column,
+// rows are the top 3 rows of the result, the bottom one is always 0 0 0 1
+static inline void trsRowsInternal(M3dValue (*rows)[4], const Vec3 *t, const Quat *r, const Vec3 *s)
+{
+    M3dValue i2 = r->i * r->i * 2;
+    M3dValue j2 = r->j * r->j * 2;
+    M3dValue k2 = r->k * r->k * 2;
+
+    M3dValue ij = r->i * r->j * 2;
+    M3dValue jk = r->j * r->k * 2;
+    M3dValue ik = r->i * r->k * 2;
+
+    M3dValue iw = r->i * r->w * 2;
+    M3dValue jw = r->j * r->w * 2;
+    M3dValue kw = r->k * r->w * 2;
+
+    rows[0][0] = (1 - j2 - k2) * s->x;    rows[0][1] = (ij - kw) * s->y;        rows[0][2] = (ik + jw) * s->z;        rows[0][3] = t->x;
+    rows[1][0] = (ij + kw) * s->x;        rows[1][1] = (1 - i2 - k2) * s->y;    rows[1][2] = (jk - iw) * s->z;        rows[1][3] = t->y;
+    rows[2][0] = (ik - jw) * s->x;        rows[2][1] = (jk + iw) * s->y;        rows[2][2] = (1 - i2 - j2) * s->z;    rows[2][3] = t->z;
+}
+
+M3D_API void m3dMat4x4FromTrsPtr(Mat4x4 *M3D_RESTRICT res, const Vec3 *t, const Quat *r, const Vec3 *s)
+{
+    M3D_PROFILE_FUNCTION();
+    trsRowsInternal(res->m, t, r, s);
+
+    res->m[3][0] = 0;
+    res->m[3][1] = 0;
+    res->m[3][2] = 0;
+    res->m[3][3] = 1;
+}
+
+M3D_API Mat4x4 m3dMat4x4FromTrs(Vec3 t, Quat r, Vec3 s)
+{
+    M3D_PROFILE_FUNCTION();
+    Mat4x4 res;
+
+    m3dMat4x4FromTrsPtr(&res, &t, &r, &s);
+
+    return res;
+}
+
+M3D_API void m3dMat3x4FromTrsPtr(Mat3x4 *M3D_RESTRICT res, const Vec3 *t, const Quat *r, const Vec3 *s)
+{
+    M3D_PROFILE_FUNCTION();
+    trsRowsInternal(res->m, t, r, s);
+}
+
+M3D_API Mat3x4 m3dMat3x4FromTrs(Vec3 t, Quat r, Vec3 s)
+{
+    M3D_PROFILE_FUNCTION();
+    Mat3x4 res;
+
+    m3dMat3x4FromTrsPtr(&res, &t, &r, &s);
+
+    return res;
+}
+
+/** ---------------- batch forms */
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+
+// 4 instances per step with the operations of trsRowsInternal in the same order,
+// then rows[r][m] is row r of matrix n + m
+static inline void trsRowsx4Sse2(__m128 rows[3][4], const Vec3Soa *t, const QuatSoa *r, const Vec3Soa *s, size_t n)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+
+    __m128 qi = _mm_loadu_ps(r->i + n);
+    __m128 qj = _mm_loadu_ps(r->j + n);
+    __m128 qk = _mm_loadu_ps(r->k + n);
+    __m128 qw = _mm_loadu_ps(r->w + n);
+
+    __m128 i2 = _mm_mul_ps(_mm_mul_ps(qi, qi), two);
+    __m128 j2 = _mm_mul_ps(_mm_mul_ps(qj, qj), two);
+    __m128 k2 = _mm_mul_ps(_mm_mul_ps(qk, qk), two);
+
+    __m128 ij = _mm_mul_ps(_mm_mul_ps(qi, qj), two);
+    __m128 jk = _mm_mul_ps(_mm_mul_ps(qj, qk), two);
+    __m128 ik = _mm_mul_ps(_mm_mul_ps(qi, qk), two);
+
+    __m128 iw = _mm_mul_ps(_mm_mul_ps(qi, qw), two);
+    __m128 jw = _mm_mul_ps(_mm_mul_ps(qj, qw), two);
+    __m128 kw = _mm_mul_ps(_mm_mul_ps(qk, qw), two);
+
+    __m128 sx = _mm_loadu_ps(s->x + n);
+    __m128 sy = _mm_loadu_ps(s->y + n);
+    __m128 sz = _mm_loadu_ps(s->z + n);
+
+    rows[0][0] = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, j2), k2), sx);
+    rows[0][1] = _mm_mul_ps(_mm_sub_ps(ij, kw), sy);
+    rows[0][2] = _mm_mul_ps(_mm_add_ps(ik, jw), sz);
+    rows[0][3] = _mm_loadu_ps(t->x + n);
+
+    rows[1][0] = _mm_mul_ps(_mm_add_ps(ij, kw), sx);
+    rows[1][1] = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, i2), k2), sy);
+    rows[1][2] = _mm_mul_ps(_mm_sub_ps(jk, iw), sz);
+    rows[1][3] = _mm_loadu_ps(t->y + n);
+
+    rows[2][0] = _mm_mul_ps(_mm_sub_ps(ik, jw), sx);
+    rows[2][1] = _mm_mul_ps(_mm_add_ps(jk, iw), sy);
+    rows[2][2] = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, i2), j2), sz);
+    rows[2][3] = _mm_loadu_ps(t->z + n);
+
+    _MM_TRANSPOSE4_PS(rows[0][0], rows[0][1], rows[0][2], rows[0][3]);
+    _MM_TRANSPOSE4_PS(rows[1][0], rows[1][1], rows[1][2], rows[1][3]);
+    _MM_TRANSPOSE4_PS(rows[2][0], rows[2][1], rows[2][2], rows[2][3]);
+}
+
+#endif // M3D_SSE2
+
+// the matrices begin to end of res, stride values apart: 16 for a Mat4x4, which also gets
+// its bottom row, and 12 for a Mat3x4. one function for both so the 4 wide kernel inlines
+static void trsRangeInternal(M3dValue *res, size_t stride, Vec3Soa t, QuatSoa r, Vec3Soa s, size_t begin, size_t end)
+{
+    char bottom = stride == 16;
+    size_t n = begin;
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+    const __m128 bottomRow = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+
+    for(size_t last = m3dGroupEndInternal(n, end, 4); n < last; n += 4)
+    {
+        __m128 rows[3][4];
+        trsRowsx4Sse2(rows, &t, &r, &s, n);
+
+        for(int m = 0; m < 4; m++)
+        {
+            M3dValue *out = res + (n + (size_t)m) * stride;
+
+            _mm_storeu_ps(out, rows[0][m]);
+            _mm_storeu_ps(out + 4, rows[1][m]);
+            _mm_storeu_ps(out + 8, rows[2][m]);
+
+            if(bottom)
+            {
+                _mm_storeu_ps(out + 12, bottomRow);
+            }
+        }
+    }
+#endif
+
+    for(; n < end; n++)
+    {
+        M3dValue (*out)[4] = (M3dValue (*)[4])(res + n * stride);
+        Vec3 tn = {t.x[n], t.y[n], t.z[n]};
+        Quat rn = {r.i[n], r.j[n], r.k[n], r.w[n]};
+        Vec3 sn = {s.x[n], s.y[n], s.z[n]};
+
+        trsRowsInternal(out, &tn, &rn, &sn);
+
+        if(bottom)
+        {
+            out[3][0] = 0;
+            out[3][1] = 0;
+            out[3][2] = 0;
+            out[3][3] = 1;
+        }
+    }
+}
+
+static void trsSoaInternal(M3dValue *res, size_t stride, Vec3Soa t, QuatSoa r, Vec3Soa s)
+{
+    M3D_PARALLEL_BLOCKS(begin, end, 0, t.count, TRS_PARALLEL_MIN, trsRangeInternal(res, stride, t, r, s, begin, end));
+}
+
+M3D_API void m3dMat4x4FromTrsSoa(Mat4x4 *M3D_RESTRICT res, Vec3Soa t, QuatSoa r, Vec3Soa s)
+{
+    M3D_PROFILE_FUNCTION();
+    trsSoaInternal(&res->m[0][0], 16, t, r, s);
+}
+
+M3D_API void m3dMat3x4FromTrsSoa(Mat3x4 *M3D_RESTRICT res, Vec3Soa t, QuatSoa r, Vec3Soa s)
+{
+    M3D_PROFILE_FUNCTION();
+    trsSoaInternal(&res->m[0][0], 12, t, r, s);
+}
+
+#endif // M3D_FIXED
@@ -1,138 +1,175 @@
 #include "m3d/m3d.h"
+#include "internal.h"
 #include <math.h>
 
-M3dValue m3dVec2Angle(Vec2 a, Vec2 b)
+M3D_API M3dValue m3dVec2Angle(Vec2 a, Vec2 b)
 {
+    M3D_PROFILE_FUNCTION();
+#ifdef M3D_FIXED
+    // the dot of the unit vectors, a and b can be too long to multiply in range
+    return m3dAcosInternal(m3dVec2Dot(m3dVec2Normalized(a), m3dVec2Normalized(b)));
+#else
     M3dValue numerator = m3dVec2Dot(a, b);
-    M3dValue denominator = m3dVec2Length(a) * m3dVec2Length(b);
+    M3dValue denominator = m3dMulInternal(m3dVec2Length(a), m3dVec2Length(b));
 
-    return acos(numerator / denominator);
+    return m3dAcosInternal(m3dDivInternal(numerator, denominator));
+#endif // M3D_FIXED
 }
 
-M3dValue m3dVec2Distance(Vec2 a, Vec2 b)
+M3D_API M3dValue m3dVec2Distance(Vec2 a, Vec2 b)
 {
+    M3D_PROFILE_FUNCTION();
     return m3dVec2Length(m3dVec2SubVec2(b, a));
 }
 
-M3dValue m3dVec2Dot(Vec2 a, Vec2 b)
+M3D_API M3dValue m3dVec2Dot(Vec2 a, Vec2 b)
 {
-    return a.x * b.x + a.y * b.y;
+    M3D_PROFILE_FUNCTION();
+    return m3dMulInternal(a.x, b.x) + m3dMulInternal(a.y, b.y);
 }
 
-M3dValue m3dVec2Length(Vec2 v)
+M3D_API M3dValue m3dVec2Length(Vec2 v)
 {
-    return sqrt(m3dVec2LengthSqr(v));
+    M3D_PROFILE_FUNCTION();
+#ifdef M3D_FIXED
+    return m3dFixedLengthInternal(&v.x, 2);
+#else
+    return m3dSqrtInternal(m3dVec2LengthSqr(v));
+#endif // M3D_FIXED
 }
 
-M3dValue m3dVec2LengthSqr(Vec2 v)
+M3D_API M3dValue m3dVec2LengthSqr(Vec2 v)
 {
-    return v.x * v.x + v.y * v.y;
+    M3D_PROFILE_FUNCTION();
+    return m3dMulInternal(v.x, v.x) + m3dMulInternal(v.y, v.y);
 }
 
-Vec2 m3dVec2Lerp(Vec2 a, Vec2 b, M3dValue t)
+M3D_API Vec2 m3dVec2Lerp(Vec2 a, Vec2 b, M3dValue t)
 {
+    M3D_PROFILE_FUNCTION();
     a.x = m3d1DLerp(a.x, b.x, t);
     a.y = m3d1DLerp(a.y, b.y, t);
     return a;
 }
 
-Vec2 m3dVec2Max(Vec2 a, Vec2 b)
+M3D_API Vec2 m3dVec2Max(Vec2 a, Vec2 b)
 {
-    a.x = fmax(a.x, b.x);
-    a.y = fmax(a.y, b.y);
+    M3D_PROFILE_FUNCTION();
+    a.x = m3dMaxInternal(a.x, b.x);
+    a.y = m3dMaxInternal(a.y, b.y);
 
     return a;
 }
 
-Vec2 m3dVec2Min(Vec2 a, Vec2 b)
+M3D_API Vec2 m3dVec2Min(Vec2 a, Vec2 b)
 {
-    a.x = fmin(a.x, b.x);
-    a.y = fmin(a.y, b.y);
+    M3D_PROFILE_FUNCTION();
+    a.x = m3dMinInternal(a.x, b.x);
+    a.y = m3dMinInternal(a.y, b.y);
 
     return a;
 }
 
-Vec2 m3dVec2Normalized(Vec2 v)
+M3D_API Vec2 m3dVec2Normalized(Vec2 v)
 {
+    M3D_PROFILE_FUNCTION();
+#if defined(M3D_FIXED)
+    m3dFixedNormalizeInternal(&v.x, 2);
+    return v;
+#elif defined(M3D_FAST_MATH)
+    return m3dVec2MulValue(v, m3dRsqrtInternal(m3dVec2LengthSqr(v)));
+#else
     M3dValue length = m3dVec2Length(v);
     return m3dVec2DivValue(v, length);
+#endif // M3D_FAST_MATH
 }
 
-Vec2 m3dVec2Reflect(Vec2 v, Vec2 n)
+M3D_API Vec2 m3dVec2Reflect(Vec2 v, Vec2 n)
 {
-    M3dValue numerator = m3dVec2Dot(m3dVec2MulValue(v, 2), n);
-    Vec2 a = m3dVec2MulValue(n, numerator / m3dVec2LengthSqr(n));
+    M3D_PROFILE_FUNCTION();
+    M3dValue numerator = m3dVec2Dot(m3dVec2MulValue(v, M3D_VALUE(2)), n);
+    Vec2 a = m3dVec2MulValue(n, m3dDivInternal(numerator, m3dVec2LengthSqr(n)));
 
     return m3dVec2SubVec2(v, a);
 }
 
-Vec2 m3dVec2Slerp(Vec2 a, Vec2 b, M3dValue t)
+M3D_API Vec2 m3dVec2Slerp(Vec2 a, Vec2 b, M3dValue t)
 {
+    M3D_PROFILE_FUNCTION();
      M3dValue dot = m3dVec2Dot(a, b);
-     dot = m3d1DClamp(dot, -1.0f, 1.0f);
-     M3dValue theta = acos(dot)* t;
+     dot = m3d1DClamp(dot, M3D_VALUE(-1), M3D_VALUE(1));
+     M3dValue theta = m3dMulInternal(m3dAcosInternal(dot), t);
      Vec2 offset = m3dVec2SubVec2(b, m3dVec2MulValue(a, dot));
      offset = m3dVec2Normalized(offset);
-     return m3dVec2AddVec2(m3dVec2MulValue(a, cos(theta)), m3dVec2MulValue(offset, sin(theta)));
+     return m3dVec2AddVec2(m3dVec2MulValue(a, m3dCosInternal(theta)), m3dVec2MulValue(offset, m3dSinInternal(theta)));
 }
 
-Vec2 m3dVec2AddVec2(Vec2 a, Vec2 b)
+M3D_API Vec2 m3dVec2AddVec2(Vec2 a, Vec2 b)
 {
+    M3D_PROFILE_FUNCTION();
     a.x += b.x;
     a.y += b.y;
     return a;
 }
 
-Vec2 m3dVec2AddValue(Vec2 a, M3dValue b)
+M3D_API Vec2 m3dVec2AddValue(Vec2 a, M3dValue b)
 {
+    M3D_PROFILE_FUNCTION();
     a.x += b;
     a.y += b;
     return a;
 }
 
-Vec2 m3dVec2SubVec2(Vec2 a, Vec2 b)
+M3D_API Vec2 m3dVec2SubVec2(Vec2 a, Vec2 b)
 {
+    M3D_PROFILE_FUNCTION();
     a.x -= b.x;
     a.y -= b.y;
     return a;
 }
 
-Vec2 m3dVec2SubValue(Vec2 a, M3dValue b)
+M3D_API Vec2 m3dVec2SubValue(Vec2 a, M3dValue b)
 {
+    M3D_PROFILE_FUNCTION();
     a.x -= b;
     a.y -= b;
     return a;
 }
 
-Vec2 m3dVec2MulVec2(Vec2 a, Vec2 b)
+M3D_API Vec2 m3dVec2MulVec2(Vec2 a, Vec2 b)
 {
-    a.x *= b.x;
-    a.y *= b.y;
+    M3D_PROFILE_FUNCTION();
+    a.x = m3dMulInternal(a.x, b.x);
+    a.y = m3dMulInternal(a.y, b.y);
     return a;
 }
 
-Vec2 m3dVec2MulValue(Vec2 a, M3dValue b)
+M3D_API Vec2 m3dVec2MulValue(Vec2 a, M3dValue b)
 {
-    a.x *= b;
-    a.y *= b;
+    M3D_PROFILE_FUNCTION();
+    a.x = m3dMulInternal(a.x, b);
+    a.y = m3dMulInternal(a.y, b);
     return a;
 }
 
-Vec2 m3dVec2DivVec2(Vec2 a, Vec2 b)
+M3D_API Vec2 m3dVec2DivVec2(Vec2 a, Vec2 b)
 {
-    a.x /= b.x;
-    a.y /= b.y;
+    M3D_PROFILE_FUNCTION();
+    a.x = m3dDivInternal(a.x, b.x);
+    a.y = m3dDivInternal(a.y, b.y);
     return a;
 }
 
-Vec2 m3dVec2DivValue(Vec2 a, M3dValue b)
+M3D_API Vec2 m3dVec2DivValue(Vec2 a, M3dValue b)
 {
-    a.x /= b;
-    a.y /= b;
+    M3D_PROFILE_FUNCTION();
+    a.x = m3dDivInternal(a.x, b);
+    a.y = m3dDivInternal(a.y, b);
     return a;
 }
 
-char m3dVec2Equal(Vec2 a, Vec2 b)
+M3D_API char m3dVec2Equal(Vec2 a, Vec2 b)
 {
+    M3D_PROFILE_FUNCTION();
     return a.x == b.x && a.y == b.y;
 }
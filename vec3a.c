@@ -0,0 +1,387 @@
+#include "m3d/m3d.h"
+#include "internal.h"
+
+#ifndef M3D_FIXED
+
+/** The by value forms are plain c. x86-64 passes a Vec3A in two registers, which the
+    compiler keeps the fields in, while an sse load of the argument would read back a half
+    written stack slot. The Ptr forms load the aligned vectors into one register each.
+    The 0 in w stays 0 through every operation, divisions mask it back */
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+
+#define VEC3A_SSE2
+
+static inline __m128 xyzMaskInternal(void)
+{
+    return _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+}
+
+// x + y + z of m, w is 0, in lane 0
+static inline __m128 sum3Internal(__m128 m)
+{
+    __m128 s = _mm_add_ps(m, _mm_movehl_ps(m, m));
+    return _mm_add_ss(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1)));
+}
+
+#endif // M3D_SSE2 && !M3D_DOUBLE
+
+M3D_API Vec3A m3dVec3AFromVec3(Vec3 v)
+{
+    M3D_PROFILE_FUNCTION();
+    Vec3A res = {v.x, v.y, v.z, 0};
+    return res;
+}
+
+M3D_API Vec3 m3dVec3AToVec3(Vec3A v)
+{
+    M3D_PROFILE_FUNCTION();
+    Vec3 res = {v.x, v.y, v.z};
+    return res;
+}
+
+M3D_API Vec3A m3dVec3AAddVec3A(Vec3A a, Vec3A b)
+{
+    M3D_PROFILE_FUNCTION();
+    a.x += b.x;
+    a.y += b.y;
+    a.z += b.z;
+    return a;
+}
+
+M3D_API Vec3A m3dVec3AAddValue(Vec3A a, M3dValue b)
+{
+    M3D_PROFILE_FUNCTION();
+    a.x += b;
+    a.y += b;
+    a.z += b;
+    return a;
+}
+
+M3D_API Vec3A m3dVec3ASubVec3A(Vec3A a, Vec3A b)
+{
+    M3D_PROFILE_FUNCTION();
+    a.x -= b.x;
+    a.y -= b.y;
+    a.z -= b.z;
+    return a;
+}
+
+M3D_API Vec3A m3dVec3ASubValue(Vec3A a, M3dValue b)
+{
+    M3D_PROFILE_FUNCTION();
+    a.x -= b;
+    a.y -= b;
+    a.z -= b;
+    return a;
+}
+
+M3D_API Vec3A m3dVec3AMulVec3A(Vec3A a, Vec3A b)
+{
+    M3D_PROFILE_FUNCTION();
+    a.x *= b.x;
+    a.y *= b.y;
+    a.z *= b.z;
+    return a;
+}
+
+M3D_API Vec3A m3dVec3AMulValue(Vec3A a, M3dValue b)
+{
+    M3D_PROFILE_FUNCTION();
+    a.x *= b;
+    a.y *= b;
+    a.z *= b;
+    return a;
+}
+
+M3D_API Vec3A m3dVec3ADivVec3A(Vec3A a, Vec3A b)
+{
+    M3D_PROFILE_FUNCTION();
+    a.x /= b.x;
+    a.y /= b.y;
+    a.z /= b.z;
+    return a;
+}
+
+M3D_API Vec3A m3dVec3ADivValue(Vec3A a, M3dValue b)
+{
+    M3D_PROFILE_FUNCTION();
+    a.x /= b;
+    a.y /= b;
+    a.z /= b;
+    return a;
+}
+
+M3D_API Vec3A m3dVec3AMin(Vec3A a, Vec3A b)
+{
+    M3D_PROFILE_FUNCTION();
+    a.x = m3dMinInternal(a.x, b.x);
+    a.y = m3dMinInternal(a.y, b.y);
+    a.z = m3dMinInternal(a.z, b.z);
+    return a;
+}
+
+M3D_API Vec3A m3dVec3AMax(Vec3A a, Vec3A b)
+{
+    M3D_PROFILE_FUNCTION();
+    a.x = m3dMaxInternal(a.x, b.x);
+    a.y = m3dMaxInternal(a.y, b.y);
+    a.z = m3dMaxInternal(a.z, b.z);
+    return a;
+}
+
+M3D_API Vec3A m3dVec3ALerp(Vec3A a, Vec3A b, M3dValue t)
+{
+    M3D_PROFILE_FUNCTION();
+    a.x += (b.x - a.x) * t;
+    a.y += (b.y - a.y) * t;
+    a.z += (b.z - a.z) * t;
+    return a;
+}
+
+M3D_API Vec3A m3dVec3ACross(Vec3A a, Vec3A b)
+{
+    M3D_PROFILE_FUNCTION();
+    Vec3A res = {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x, 0};
+    return res;
+}
+
+M3D_API M3dValue m3dVec3ADot(Vec3A a, Vec3A b)
+{
+    M3D_PROFILE_FUNCTION();
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+M3D_API M3dValue m3dVec3ALengthSqr(Vec3A v)
+{
+    M3D_PROFILE_FUNCTION();
+    return m3dVec3ADot(v, v);
+}
+
+M3D_API M3dValue m3dVec3ALength(Vec3A v)
+{
+    M3D_PROFILE_FUNCTION();
+    return m3dSqrtInternal(m3dVec3ADot(v, v));
+}
+
+M3D_API M3dValue m3dVec3ADistance(Vec3A a, Vec3A b)
+{
+    M3D_PROFILE_FUNCTION();
+    return m3dVec3ALength(m3dVec3ASubVec3A(b, a));
+}
+
+M3D_API Vec3A m3dVec3ANormalized(Vec3A v)
+{
+    M3D_PROFILE_FUNCTION();
+#ifdef M3D_FAST_MATH
+    return m3dVec3AMulValue(v, m3dRsqrtInternal(m3dVec3ALengthSqr(v)));
+#else
+    return m3dVec3ADivValue(v, m3dVec3ALength(v));
+#endif // M3D_FAST_MATH
+}
+
+M3D_API M3dValue m3dVec3AAngle(Vec3A a, Vec3A b)
+{
+    M3D_PROFILE_FUNCTION();
+    return m3dAcosInternal(m3dVec3ADot(a, b) / (m3dVec3ALength(a) * m3dVec3ALength(b)));
+}
+
+M3D_API Vec3A m3dVec3AReflect(Vec3A v, Vec3A n)
+{
+    M3D_PROFILE_FUNCTION();
+    M3dValue scale = 2 * m3dVec3ADot(v, n) / m3dVec3ALengthSqr(n);
+    return m3dVec3ASubVec3A(v, m3dVec3AMulValue(n, scale));
+}
+
+M3D_API Vec3A m3dVec3ASlerp(Vec3A a, Vec3A b, M3dValue t)
+{
+    M3D_PROFILE_FUNCTION();
+    M3dValue dot = m3d1DClamp(m3dVec3ADot(a, b), -1, 1);
+    M3dValue theta = m3dAcosInternal(dot) * t;
+    Vec3A offset = m3dVec3ANormalized(m3dVec3ASubVec3A(b, m3dVec3AMulValue(a, dot)));
+
+    return m3dVec3AAddVec3A(m3dVec3AMulValue(a, m3dCosInternal(theta)), m3dVec3AMulValue(offset, m3dSinInternal(theta)));
+}
+
+M3D_API char m3dVec3AEqual(Vec3A a, Vec3A b)
+{
+    M3D_PROFILE_FUNCTION();
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+/** ---------------- Ptr forms */
+
+M3D_API void m3dVec3AAddVec3APtr(Vec3A *res, const Vec3A *a, const Vec3A *b)
+{
+    M3D_PROFILE_FUNCTION();
+#ifdef VEC3A_SSE2
+    _mm_store_ps(&res->x, _mm_add_ps(_mm_load_ps(&a->x), _mm_load_ps(&b->x)));
+#else
+    *res = m3dVec3AAddVec3A(*a, *b);
+#endif // VEC3A_SSE2
+}
+
+M3D_API void m3dVec3ASubVec3APtr(Vec3A *res, const Vec3A *a, const Vec3A *b)
+{
+    M3D_PROFILE_FUNCTION();
+#ifdef VEC3A_SSE2
+    _mm_store_ps(&res->x, _mm_sub_ps(_mm_load_ps(&a->x), _mm_load_ps(&b->x)));
+#else
+    *res = m3dVec3ASubVec3A(*a, *b);
+#endif // VEC3A_SSE2
+}
+
+M3D_API void m3dVec3AMulVec3APtr(Vec3A *res, const Vec3A *a, const Vec3A *b)
+{
+    M3D_PROFILE_FUNCTION();
+#ifdef VEC3A_SSE2
+    _mm_store_ps(&res->x, _mm_mul_ps(_mm_load_ps(&a->x), _mm_load_ps(&b->x)));
+#else
+    *res = m3dVec3AMulVec3A(*a, *b);
+#endif // VEC3A_SSE2
+}
+
+M3D_API void m3dVec3AMulValuePtr(Vec3A *res, const Vec3A *a, M3dValue b)
+{
+    M3D_PROFILE_FUNCTION();
+#ifdef VEC3A_SSE2
+    _mm_store_ps(&res->x, _mm_mul_ps(_mm_load_ps(&a->x), _mm_set1_ps(b)));
+#else
+    *res = m3dVec3AMulValue(*a, b);
+#endif // VEC3A_SSE2
+}
+
+M3D_API void m3dVec3AMinPtr(Vec3A *res, const Vec3A *a, const Vec3A *b)
+{
+    M3D_PROFILE_FUNCTION();
+#ifdef VEC3A_SSE2
+    _mm_store_ps(&res->x, _mm_min_ps(_mm_load_ps(&a->x), _mm_load_ps(&b->x)));
+#else
+    *res = m3dVec3AMin(*a, *b);
+#endif // VEC3A_SSE2
+}
+
+M3D_API void m3dVec3AMaxPtr(Vec3A *res, const Vec3A *a, const Vec3A *b)
+{
+    M3D_PROFILE_FUNCTION();
+#ifdef VEC3A_SSE2
+    _mm_store_ps(&res->x, _mm_max_ps(_mm_load_ps(&a->x), _mm_load_ps(&b->x)));
+#else
+    *res = m3dVec3AMax(*a, *b);
+#endif // VEC3A_SSE2
+}
+
+M3D_API void m3dVec3ALerpPtr(Vec3A *res, const Vec3A *a, const Vec3A *b, M3dValue t)
+{
+    M3D_PROFILE_FUNCTION();
+#ifdef VEC3A_SSE2
+    __m128 ra = _mm_load_ps(&a->x);
+    _mm_store_ps(&res->x, _mm_add_ps(ra, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&b->x), ra), _mm_set1_ps(t))));
+#else
+    *res = m3dVec3ALerp(*a, *b, t);
+#endif // VEC3A_SSE2
+}
+
+M3D_API void m3dVec3ACrossPtr(Vec3A *res, const Vec3A *a, const Vec3A *b)
+{
+    M3D_PROFILE_FUNCTION();
+#ifdef VEC3A_SSE2
+    // a * b.yzx - a.yzx * b, then rotated back by one lane
+    __m128 ra = _mm_load_ps(&a->x);
+    __m128 rb = _mm_load_ps(&b->x);
+    __m128 aYzx = _mm_shuffle_ps(ra, ra, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 bYzx = _mm_shuffle_ps(rb, rb, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 c = _mm_sub_ps(_mm_mul_ps(ra, bYzx), _mm_mul_ps(aYzx, rb));
+    _mm_store_ps(&res->x, _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1)));
+#else
+    *res = m3dVec3ACross(*a, *b);
+#endif // VEC3A_SSE2
+}
+
+M3D_API M3dValue m3dVec3ADotPtr(const Vec3A *a, const Vec3A *b)
+{
+    M3D_PROFILE_FUNCTION();
+#ifdef VEC3A_SSE2
+    return _mm_cvtss_f32(sum3Internal(_mm_mul_ps(_mm_load_ps(&a->x), _mm_load_ps(&b->x))));
+#else
+    return m3dVec3ADot(*a, *b);
+#endif // VEC3A_SSE2
+}
+
+M3D_API void m3dVec3ANormalizedPtr(Vec3A *res, const Vec3A *v)
+{
+    M3D_PROFILE_FUNCTION();
+#ifdef VEC3A_SSE2
+    __m128 r = _mm_load_ps(&v->x);
+    __m128 lengthSqr = sum3Internal(_mm_mul_ps(r, r));
+    lengthSqr = _mm_shuffle_ps(lengthSqr, lengthSqr, _MM_SHUFFLE(0, 0, 0, 0));
+#ifdef M3D_FAST_MATH
+    // rsqrt and one newton step, as m3dRsqrtInternal
+    __m128 e = _mm_rsqrt_ps(lengthSqr);
+    e = _mm_mul_ps(e, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), lengthSqr), _mm_mul_ps(e, e))));
+    // a zero vector gives inf * 0 in w, masked back to 0 like the division below
+    _mm_store_ps(&res->x, _mm_and_ps(_mm_mul_ps(r, e), xyzMaskInternal()));
+#else
+    _mm_store_ps(&res->x, _mm_and_ps(_mm_div_ps(r, _mm_sqrt_ps(lengthSqr)), xyzMaskInternal()));
+#endif // M3D_FAST_MATH
+#else
+    *res = m3dVec3ANormalized(*v);
+#endif // VEC3A_SSE2
+}
+
+/** ---------------- conversions */
+
+M3D_API void m3dVec3AFromVec3Array(Vec3A *M3D_RESTRICT res, const Vec3 *v, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t n = 0;
+
+#ifdef VEC3A_SSE2
+    // 4 packed Vec3s are 3 loads, the padding lane of each is cleared
+    for(size_t last = m3dGroupEndInternal(n, count, 4); n < last; n += 4)
+    {
+        __m128 x, y, z;
+        m3dLoadVec3x4Internal(&v[n].x, &x, &y, &z);
+        __m128 w = _mm_setzero_ps();
+
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+
+        _mm_store_ps(&res[n].x, x);
+        _mm_store_ps(&res[n + 1].x, y);
+        _mm_store_ps(&res[n + 2].x, z);
+        _mm_store_ps(&res[n + 3].x, w);
+    }
+#endif // VEC3A_SSE2
+
+    for(; n < count; n++)
+    {
+        res[n] = m3dVec3AFromVec3(v[n]);
+    }
+}
+
+M3D_API void m3dVec3AToVec3Array(Vec3 *M3D_RESTRICT res, const Vec3A *v, size_t count)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t n = 0;
+
+#ifdef VEC3A_SSE2
+    for(size_t last = m3dGroupEndInternal(n, count, 4); n < last; n += 4)
+    {
+        __m128 x = _mm_load_ps(&v[n].x);
+        __m128 y = _mm_load_ps(&v[n + 1].x);
+        __m128 z = _mm_load_ps(&v[n + 2].x);
+        __m128 w = _mm_load_ps(&v[n + 3].x);
+
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+
+        m3dStoreVec3x4Internal(&res[n].x, x, y, z, 0);
+    }
+#endif // VEC3A_SSE2
+
+    for(; n < count; n++)
+    {
+        res[n] = m3dVec3AToVec3(v[n]);
+    }
+}
+
+#endif // M3D_FIXED
@@ -1,7 +1,9 @@
 #include "m3d/m3d.h"
+#include "internal.h"
 
-Vec4 m3dVec4AddVec4(Vec4 a, Vec4 b)
+M3D_API Vec4 m3dVec4AddVec4(Vec4 a, Vec4 b)
 {
+    M3D_PROFILE_FUNCTION();
     a.x += b.x;
     a.y += b.y;
     a.z += b.z;
@@ -9,8 +11,9 @@ Vec4 m3dVec4AddVec4(Vec4 a, Vec4 b)
     return a;
 }
 
-Vec4 m3dVec4AddValue(Vec4 a, M3dValue b)
+M3D_API Vec4 m3dVec4AddValue(Vec4 a, M3dValue b)
 {
+    M3D_PROFILE_FUNCTION();
     a.x += b;
     a.y += b;
     a.z += b;
@@ -18,8 +21,9 @@ Vec4 m3dVec4AddValue(Vec4 a, M3dValue b)
     return a;
 }
 
-Vec4 m3dVec4SubVec4(Vec4 a, Vec4 b)
+M3D_API Vec4 m3dVec4SubVec4(Vec4 a, Vec4 b)
 {
+    M3D_PROFILE_FUNCTION();
     a.x -= b.x;
     a.y -= b.y;
     a.z -= b.z;
@@ -27,8 +31,9 @@ Vec4 m3dVec4SubVec4(Vec4 a, Vec4 b)
     return a;
 }
 
-Vec4 m3dVec4SubValue(Vec4 a, M3dValue b)
+M3D_API Vec4 m3dVec4SubValue(Vec4 a, M3dValue b)
 {
+    M3D_PROFILE_FUNCTION();
     a.x -= b;
     a.y -= b;
     a.z -= b;
@@ -36,43 +41,48 @@ Vec4 m3dVec4SubValue(Vec4 a, M3dValue b)
     return a;
 }
 
-Vec4 m3dVec4MulVec4(Vec4 a, Vec4 b)
+M3D_API Vec4 m3dVec4MulVec4(Vec4 a, Vec4 b)
 {
-    a.x *= b.x;
-    a.y *= b.y;
-    a.z *= b.z;
-    a.w *= b.w;
+    M3D_PROFILE_FUNCTION();
+    a.x = m3dMulInternal(a.x, b.x);
+    a.y = m3dMulInternal(a.y, b.y);
+    a.z = m3dMulInternal(a.z, b.z);
+    a.w = m3dMulInternal(a.w, b.w);
     return a;
 }
 
-Vec4 m3dVec4MulValue(Vec4 a, M3dValue b)
+M3D_API Vec4 m3dVec4MulValue(Vec4 a, M3dValue b)
 {
-    a.x *= b;
-    a.y *= b;
-    a.z *= b;
-    a.w *= b;
+    M3D_PROFILE_FUNCTION();
+    a.x = m3dMulInternal(a.x, b);
+    a.y = m3dMulInternal(a.y, b);
+    a.z = m3dMulInternal(a.z, b);
+    a.w = m3dMulInternal(a.w, b);
     return a;
 }
 
-Vec4 m3dVec4DivVec4(Vec4 a, Vec4 b)
+M3D_API Vec4 m3dVec4DivVec4(Vec4 a, Vec4 b)
 {
-    a.x /= b.x;
-    a.y /= b.y;
-    a.z /= b.z;
-    a.w /= b.w;
+    M3D_PROFILE_FUNCTION();
+    a.x = m3dDivInternal(a.x, b.x);
+    a.y = m3dDivInternal(a.y, b.y);
+    a.z = m3dDivInternal(a.z, b.z);
+    a.w = m3dDivInternal(a.w, b.w);
     return a;
 }
 
-Vec4 m3dVec4DivValue(Vec4 a, M3dValue b)
+M3D_API Vec4 m3dVec4DivValue(Vec4 a, M3dValue b)
 {
-    a.x /= b;
-    a.y /= b;
-    a.z /= b;
-    a.w /= b;
+    M3D_PROFILE_FUNCTION();
+    a.x = m3dDivInternal(a.x, b);
+    a.y = m3dDivInternal(a.y, b);
+    a.z = m3dDivInternal(a.z, b);
+    a.w = m3dDivInternal(a.w, b);
     return a;
 }
 
-char m3dVec4Equal(Vec4 a, Vec4 b)
+M3D_API char m3dVec4Equal(Vec4 a, Vec4 b)
 {
+    M3D_PROFILE_FUNCTION();
     return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w;
 }
@@ -0,0 +1,1152 @@
+#include "m3d/m3d.h"
+#include "internal.h"
+
+#ifndef M3D_FIXED
+
+// each component is processed as its own stream. The compiler will not vectorize
+// the plain loops at -O2 since the streams may alias, so the bulk of every stream
+// goes through explicit kernels first and the loops only finish the rest. Float
+// builds use avx when the cpu has it and sse2 otherwise, double builds, where sse2
+// is only 2 lanes, use avx or avx-512
+
+#if defined(M3D_X86_DISPATCH) && defined(M3D_DOUBLE)
+
+#define SOA_WIDE
+
+// the avx-512 kernels mask the last partial vector, so they always handle the whole stream
+static inline int soaWidthInternal(void)
+{
+    unsigned int cpu = m3dCpuFeatures();
+
+    return (cpu & M3D_CPU_AVX512) ? 8 : (cpu & M3D_CPU_AVX) ? 4 : 0;
+}
+
+static inline __mmask8 soaTailInternal(size_t i, size_t count)
+{
+    return count - i >= 8 ? 0xFF : (__mmask8)((1u << (count - i)) - 1);
+}
+
+M3D_TARGET_AVX static size_t soaAddAvx(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        _mm256_storeu_pd(res + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+
+    return i;
+}
+
+M3D_TARGET_AVX static size_t soaSubAvx(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        _mm256_storeu_pd(res + i, _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+
+    return i;
+}
+
+M3D_TARGET_AVX static size_t soaMulAvx(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        _mm256_storeu_pd(res + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+
+    return i;
+}
+
+M3D_TARGET_AVX static size_t soaMulValueAvx(M3dValue *res, const M3dValue *a, M3dValue b, size_t count)
+{
+    __m256d v = _mm256_set1_pd(b);
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        _mm256_storeu_pd(res + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), v));
+    }
+
+    return i;
+}
+
+M3D_TARGET_AVX static size_t soaDivAvx(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        _mm256_storeu_pd(res + i, _mm256_div_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+
+    return i;
+}
+
+M3D_TARGET_AVX static size_t soaDivValueAvx(M3dValue *res, const M3dValue *a, M3dValue b, size_t count)
+{
+    __m256d v = _mm256_set1_pd(b);
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        _mm256_storeu_pd(res + i, _mm256_div_pd(_mm256_loadu_pd(a + i), v));
+    }
+
+    return i;
+}
+
+// no fused multiply add, so the results stay those of the plain loop
+M3D_TARGET_AVX static size_t soaLerpAvx(M3dValue *res, const M3dValue *a, const M3dValue *b, M3dValue t, size_t count)
+{
+    __m256d s = _mm256_set1_pd(1 - t);
+    __m256d v = _mm256_set1_pd(t);
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        __m256d r = _mm256_mul_pd(s, _mm256_loadu_pd(a + i));
+        _mm256_storeu_pd(res + i, _mm256_add_pd(r, _mm256_mul_pd(_mm256_loadu_pd(b + i), v)));
+    }
+
+    return i;
+}
+
+M3D_TARGET_AVX static size_t soaSqrtAvx(M3dValue *res, const M3dValue *a, size_t count)
+{
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        _mm256_storeu_pd(res + i, _mm256_sqrt_pd(_mm256_loadu_pd(a + i)));
+    }
+
+    return i;
+}
+
+// sums the products in component order, like the plain loop
+M3D_TARGET_AVX static size_t soaDotAvx(M3dValue *res, const M3dValue *const *a, const M3dValue *const *b, int n, size_t count)
+{
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        __m256d r = _mm256_mul_pd(_mm256_loadu_pd(a[0] + i), _mm256_loadu_pd(b[0] + i));
+
+        for(int c = 1; c < n; c++)
+        {
+            r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_loadu_pd(a[c] + i), _mm256_loadu_pd(b[c] + i)));
+        }
+
+        _mm256_storeu_pd(res + i, r);
+    }
+
+    return i;
+}
+
+M3D_TARGET_AVX static size_t soaCrossAvx(Vec3Soa res, Vec3Soa a, Vec3Soa b, size_t count)
+{
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        __m256d ax = _mm256_loadu_pd(a.x + i), ay = _mm256_loadu_pd(a.y + i), az = _mm256_loadu_pd(a.z + i);
+        __m256d bx = _mm256_loadu_pd(b.x + i), by = _mm256_loadu_pd(b.y + i), bz = _mm256_loadu_pd(b.z + i);
+
+        _mm256_storeu_pd(res.x + i, _mm256_sub_pd(_mm256_mul_pd(ay, bz), _mm256_mul_pd(az, by)));
+        _mm256_storeu_pd(res.y + i, _mm256_sub_pd(_mm256_mul_pd(az, bx), _mm256_mul_pd(ax, bz)));
+        _mm256_storeu_pd(res.z + i, _mm256_sub_pd(_mm256_mul_pd(ax, by), _mm256_mul_pd(ay, bx)));
+    }
+
+    return i;
+}
+
+M3D_TARGET_AVX512 static size_t soaAddAvx512(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    for(size_t i = 0; i < count; i += 8)
+    {
+        __mmask8 lanes = soaTailInternal(i, count);
+        __m512d r = _mm512_add_pd(_mm512_maskz_loadu_pd(lanes, a + i), _mm512_maskz_loadu_pd(lanes, b + i));
+        _mm512_mask_storeu_pd(res + i, lanes, r);
+    }
+
+    return count;
+}
+
+M3D_TARGET_AVX512 static size_t soaSubAvx512(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    for(size_t i = 0; i < count; i += 8)
+    {
+        __mmask8 lanes = soaTailInternal(i, count);
+        __m512d r = _mm512_sub_pd(_mm512_maskz_loadu_pd(lanes, a + i), _mm512_maskz_loadu_pd(lanes, b + i));
+        _mm512_mask_storeu_pd(res + i, lanes, r);
+    }
+
+    return count;
+}
+
+M3D_TARGET_AVX512 static size_t soaMulAvx512(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    for(size_t i = 0; i < count; i += 8)
+    {
+        __mmask8 lanes = soaTailInternal(i, count);
+        __m512d r = _mm512_mul_pd(_mm512_maskz_loadu_pd(lanes, a + i), _mm512_maskz_loadu_pd(lanes, b + i));
+        _mm512_mask_storeu_pd(res + i, lanes, r);
+    }
+
+    return count;
+}
+
+M3D_TARGET_AVX512 static size_t soaMulValueAvx512(M3dValue *res, const M3dValue *a, M3dValue b, size_t count)
+{
+    __m512d v = _mm512_set1_pd(b);
+
+    for(size_t i = 0; i < count; i += 8)
+    {
+        __mmask8 lanes = soaTailInternal(i, count);
+        _mm512_mask_storeu_pd(res + i, lanes, _mm512_mul_pd(_mm512_maskz_loadu_pd(lanes, a + i), v));
+    }
+
+    return count;
+}
+
+M3D_TARGET_AVX512 static size_t soaDivAvx512(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    for(size_t i = 0; i < count; i += 8)
+    {
+        __mmask8 lanes = soaTailInternal(i, count);
+        __m512d r = _mm512_div_pd(_mm512_maskz_loadu_pd(lanes, a + i), _mm512_maskz_loadu_pd(lanes, b + i));
+        _mm512_mask_storeu_pd(res + i, lanes, r);
+    }
+
+    return count;
+}
+
+M3D_TARGET_AVX512 static size_t soaDivValueAvx512(M3dValue *res, const M3dValue *a, M3dValue b, size_t count)
+{
+    __m512d v = _mm512_set1_pd(b);
+
+    for(size_t i = 0; i < count; i += 8)
+    {
+        __mmask8 lanes = soaTailInternal(i, count);
+        _mm512_mask_storeu_pd(res + i, lanes, _mm512_div_pd(_mm512_maskz_loadu_pd(lanes, a + i), v));
+    }
+
+    return count;
+}
+
+// avx-512 always has fma, the b * t term is fused so it rounds once less than the plain loop
+M3D_TARGET_AVX512 static size_t soaLerpAvx512(M3dValue *res, const M3dValue *a, const M3dValue *b, M3dValue t, size_t count)
+{
+    __m512d s = _mm512_set1_pd(1 - t);
+    __m512d v = _mm512_set1_pd(t);
+
+    for(size_t i = 0; i < count; i += 8)
+    {
+        __mmask8 lanes = soaTailInternal(i, count);
+        __m512d r = _mm512_mul_pd(s, _mm512_maskz_loadu_pd(lanes, a + i));
+        r = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(lanes, b + i), v, r);
+        _mm512_mask_storeu_pd(res + i, lanes, r);
+    }
+
+    return count;
+}
+
+M3D_TARGET_AVX512 static size_t soaSqrtAvx512(M3dValue *res, const M3dValue *a, size_t count)
+{
+    for(size_t i = 0; i < count; i += 8)
+    {
+        __mmask8 lanes = soaTailInternal(i, count);
+        _mm512_mask_storeu_pd(res + i, lanes, _mm512_sqrt_pd(_mm512_maskz_loadu_pd(lanes, a + i)));
+    }
+
+    return count;
+}
+
+// separate multiplies and adds, not fused, so the results match the plain loop
+M3D_TARGET_AVX512 static size_t soaDotAvx512(M3dValue *res, const M3dValue *const *a, const M3dValue *const *b, int n, size_t count)
+{
+    for(size_t i = 0; i < count; i += 8)
+    {
+        __mmask8 lanes = soaTailInternal(i, count);
+        __m512d r = _mm512_mul_pd(_mm512_maskz_loadu_pd(lanes, a[0] + i), _mm512_maskz_loadu_pd(lanes, b[0] + i));
+
+        for(int c = 1; c < n; c++)
+        {
+            r = _mm512_add_pd(r, _mm512_mul_pd(_mm512_maskz_loadu_pd(lanes, a[c] + i), _mm512_maskz_loadu_pd(lanes, b[c] + i)));
+        }
+
+        _mm512_mask_storeu_pd(res + i, lanes, r);
+    }
+
+    return count;
+}
+
+M3D_TARGET_AVX512 static size_t soaCrossAvx512(Vec3Soa res, Vec3Soa a, Vec3Soa b, size_t count)
+{
+    for(size_t i = 0; i < count; i += 8)
+    {
+        __mmask8 lanes = soaTailInternal(i, count);
+        __m512d ax = _mm512_maskz_loadu_pd(lanes, a.x + i), ay = _mm512_maskz_loadu_pd(lanes, a.y + i), az = _mm512_maskz_loadu_pd(lanes, a.z + i);
+        __m512d bx = _mm512_maskz_loadu_pd(lanes, b.x + i), by = _mm512_maskz_loadu_pd(lanes, b.y + i), bz = _mm512_maskz_loadu_pd(lanes, b.z + i);
+
+        _mm512_mask_storeu_pd(res.x + i, lanes, _mm512_sub_pd(_mm512_mul_pd(ay, bz), _mm512_mul_pd(az, by)));
+        _mm512_mask_storeu_pd(res.y + i, lanes, _mm512_sub_pd(_mm512_mul_pd(az, bx), _mm512_mul_pd(ax, bz)));
+        _mm512_mask_storeu_pd(res.z + i, lanes, _mm512_sub_pd(_mm512_mul_pd(ax, by), _mm512_mul_pd(ay, bx)));
+    }
+
+    return count;
+}
+
+#endif // M3D_X86_DISPATCH && M3D_DOUBLE
+
+#if defined(M3D_SSE2) && !defined(M3D_DOUBLE)
+
+#define SOA_SSE2
+
+// the sse2 kernels run the avx one first when the cpu has it, neither fuses
+// multiply adds so every lane matches the plain loop
+#ifdef M3D_X86_DISPATCH
+#define SOA_AVX(call) ((m3dCpuFeatures() & M3D_CPU_AVX) ? (call) : 0)
+
+M3D_TARGET_AVX static size_t soaAddAvx(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 8); i < last; i += 8)
+    {
+        _mm256_storeu_ps(res + i, _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+
+    return i;
+}
+
+M3D_TARGET_AVX static size_t soaSubAvx(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 8); i < last; i += 8)
+    {
+        _mm256_storeu_ps(res + i, _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+
+    return i;
+}
+
+M3D_TARGET_AVX static size_t soaMulAvx(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 8); i < last; i += 8)
+    {
+        _mm256_storeu_ps(res + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+
+    return i;
+}
+
+M3D_TARGET_AVX static size_t soaDivAvx(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 8); i < last; i += 8)
+    {
+        _mm256_storeu_ps(res + i, _mm256_div_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+
+    return i;
+}
+
+M3D_TARGET_AVX static size_t soaMulValueAvx(M3dValue *res, const M3dValue *a, M3dValue b, size_t count)
+{
+    __m256 v = _mm256_set1_ps(b);
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 8); i < last; i += 8)
+    {
+        _mm256_storeu_ps(res + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), v));
+    }
+
+    return i;
+}
+
+M3D_TARGET_AVX static size_t soaDivValueAvx(M3dValue *res, const M3dValue *a, M3dValue b, size_t count)
+{
+    __m256 v = _mm256_set1_ps(b);
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 8); i < last; i += 8)
+    {
+        _mm256_storeu_ps(res + i, _mm256_div_ps(_mm256_loadu_ps(a + i), v));
+    }
+
+    return i;
+}
+
+M3D_TARGET_AVX static size_t soaLerpAvx(M3dValue *res, const M3dValue *a, const M3dValue *b, M3dValue t, size_t count)
+{
+    __m256 s = _mm256_set1_ps(1 - t);
+    __m256 v = _mm256_set1_ps(t);
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 8); i < last; i += 8)
+    {
+        __m256 r = _mm256_mul_ps(s, _mm256_loadu_ps(a + i));
+        _mm256_storeu_ps(res + i, _mm256_add_ps(r, _mm256_mul_ps(_mm256_loadu_ps(b + i), v)));
+    }
+
+    return i;
+}
+
+M3D_TARGET_AVX static size_t soaSqrtAvx(M3dValue *res, const M3dValue *a, size_t count)
+{
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 8); i < last; i += 8)
+    {
+        _mm256_storeu_ps(res + i, _mm256_sqrt_ps(_mm256_loadu_ps(a + i)));
+    }
+
+    return i;
+}
+
+// sums the products in component order, like the plain loop
+M3D_TARGET_AVX static size_t soaDotAvx(M3dValue *res, const M3dValue *const *a, const M3dValue *const *b, int n, size_t count)
+{
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 8); i < last; i += 8)
+    {
+        __m256 r = _mm256_mul_ps(_mm256_loadu_ps(a[0] + i), _mm256_loadu_ps(b[0] + i));
+
+        for(int c = 1; c < n; c++)
+        {
+            r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_loadu_ps(a[c] + i), _mm256_loadu_ps(b[c] + i)));
+        }
+
+        _mm256_storeu_ps(res + i, r);
+    }
+
+    return i;
+}
+
+M3D_TARGET_AVX static size_t soaCrossAvx(Vec3Soa res, Vec3Soa a, Vec3Soa b, size_t count)
+{
+    size_t i = 0;
+
+    for(size_t last = m3dGroupEndInternal(i, count, 8); i < last; i += 8)
+    {
+        __m256 ax = _mm256_loadu_ps(a.x + i), ay = _mm256_loadu_ps(a.y + i), az = _mm256_loadu_ps(a.z + i);
+        __m256 bx = _mm256_loadu_ps(b.x + i), by = _mm256_loadu_ps(b.y + i), bz = _mm256_loadu_ps(b.z + i);
+
+        _mm256_storeu_ps(res.x + i, _mm256_sub_ps(_mm256_mul_ps(ay, bz), _mm256_mul_ps(az, by)));
+        _mm256_storeu_ps(res.y + i, _mm256_sub_ps(_mm256_mul_ps(az, bx), _mm256_mul_ps(ax, bz)));
+        _mm256_storeu_ps(res.z + i, _mm256_sub_ps(_mm256_mul_ps(ax, by), _mm256_mul_ps(ay, bx)));
+    }
+
+    return i;
+}
+#else
+#define SOA_AVX(call) 0
+#endif // M3D_X86_DISPATCH
+
+static size_t soaAddSse2(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    size_t i = SOA_AVX(soaAddAvx(res, a, b, count));
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        _mm_storeu_ps(res + i, _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+
+    return i;
+}
+
+static size_t soaSubSse2(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    size_t i = SOA_AVX(soaSubAvx(res, a, b, count));
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        _mm_storeu_ps(res + i, _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+
+    return i;
+}
+
+static size_t soaMulSse2(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    size_t i = SOA_AVX(soaMulAvx(res, a, b, count));
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        _mm_storeu_ps(res + i, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+
+    return i;
+}
+
+static size_t soaDivSse2(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    size_t i = SOA_AVX(soaDivAvx(res, a, b, count));
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        _mm_storeu_ps(res + i, _mm_div_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+
+    return i;
+}
+
+static size_t soaMulValueSse2(M3dValue *res, const M3dValue *a, M3dValue b, size_t count)
+{
+    __m128 v = _mm_set1_ps(b);
+    size_t i = SOA_AVX(soaMulValueAvx(res, a, b, count));
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        _mm_storeu_ps(res + i, _mm_mul_ps(_mm_loadu_ps(a + i), v));
+    }
+
+    return i;
+}
+
+static size_t soaDivValueSse2(M3dValue *res, const M3dValue *a, M3dValue b, size_t count)
+{
+    __m128 v = _mm_set1_ps(b);
+    size_t i = SOA_AVX(soaDivValueAvx(res, a, b, count));
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        _mm_storeu_ps(res + i, _mm_div_ps(_mm_loadu_ps(a + i), v));
+    }
+
+    return i;
+}
+
+static size_t soaLerpSse2(M3dValue *res, const M3dValue *a, const M3dValue *b, M3dValue t, size_t count)
+{
+    __m128 s = _mm_set1_ps(1 - t);
+    __m128 v = _mm_set1_ps(t);
+    size_t i = SOA_AVX(soaLerpAvx(res, a, b, t, count));
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        __m128 r = _mm_mul_ps(s, _mm_loadu_ps(a + i));
+        _mm_storeu_ps(res + i, _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(b + i), v)));
+    }
+
+    return i;
+}
+
+static size_t soaSqrtSse2(M3dValue *res, const M3dValue *a, size_t count)
+{
+    size_t i = SOA_AVX(soaSqrtAvx(res, a, count));
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        _mm_storeu_ps(res + i, _mm_sqrt_ps(_mm_loadu_ps(a + i)));
+    }
+
+    return i;
+}
+
+static size_t soaDotSse2(M3dValue *res, const M3dValue *const *a, const M3dValue *const *b, int n, size_t count)
+{
+    size_t i = SOA_AVX(soaDotAvx(res, a, b, n, count));
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        __m128 r = _mm_mul_ps(_mm_loadu_ps(a[0] + i), _mm_loadu_ps(b[0] + i));
+
+        for(int c = 1; c < n; c++)
+        {
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(a[c] + i), _mm_loadu_ps(b[c] + i)));
+        }
+
+        _mm_storeu_ps(res + i, r);
+    }
+
+    return i;
+}
+
+static size_t soaCrossSse2(Vec3Soa res, Vec3Soa a, Vec3Soa b, size_t count)
+{
+    size_t i = SOA_AVX(soaCrossAvx(res, a, b, count));
+
+    for(size_t last = m3dGroupEndInternal(i, count, 4); i < last; i += 4)
+    {
+        __m128 ax = _mm_loadu_ps(a.x + i), ay = _mm_loadu_ps(a.y + i), az = _mm_loadu_ps(a.z + i);
+        __m128 bx = _mm_loadu_ps(b.x + i), by = _mm_loadu_ps(b.y + i), bz = _mm_loadu_ps(b.z + i);
+
+        _mm_storeu_ps(res.x + i, _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by)));
+        _mm_storeu_ps(res.y + i, _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz)));
+        _mm_storeu_ps(res.z + i, _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx)));
+    }
+
+    return i;
+}
+
+#endif // M3D_SSE2 && !M3D_DOUBLE
+
+static void soaAddInternal(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    size_t i = 0;
+
+#ifdef SOA_WIDE
+    int width = soaWidthInternal();
+    i = width == 8 ? soaAddAvx512(res, a, b, count) : width == 4 ? soaAddAvx(res, a, b, count) : 0;
+#elif defined(SOA_SSE2)
+    i = soaAddSse2(res, a, b, count);
+#endif
+
+    for(; i < count; i++)
+    {
+        res[i] = a[i] + b[i];
+    }
+}
+
+static void soaSubInternal(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    size_t i = 0;
+
+#ifdef SOA_WIDE
+    int width = soaWidthInternal();
+    i = width == 8 ? soaSubAvx512(res, a, b, count) : width == 4 ? soaSubAvx(res, a, b, count) : 0;
+#elif defined(SOA_SSE2)
+    i = soaSubSse2(res, a, b, count);
+#endif
+
+    for(; i < count; i++)
+    {
+        res[i] = a[i] - b[i];
+    }
+}
+
+static void soaMulInternal(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    size_t i = 0;
+
+#ifdef SOA_WIDE
+    int width = soaWidthInternal();
+    i = width == 8 ? soaMulAvx512(res, a, b, count) : width == 4 ? soaMulAvx(res, a, b, count) : 0;
+#elif defined(SOA_SSE2)
+    i = soaMulSse2(res, a, b, count);
+#endif
+
+    for(; i < count; i++)
+    {
+        res[i] = a[i] * b[i];
+    }
+}
+
+static void soaMulValueInternal(M3dValue *res, const M3dValue *a, M3dValue b, size_t count)
+{
+    size_t i = 0;
+
+#ifdef SOA_WIDE
+    int width = soaWidthInternal();
+    i = width == 8 ? soaMulValueAvx512(res, a, b, count) : width == 4 ? soaMulValueAvx(res, a, b, count) : 0;
+#elif defined(SOA_SSE2)
+    i = soaMulValueSse2(res, a, b, count);
+#endif
+
+    for(; i < count; i++)
+    {
+        res[i] = a[i] * b;
+    }
+}
+
+static void soaDivInternal(M3dValue *res, const M3dValue *a, const M3dValue *b, size_t count)
+{
+    size_t i = 0;
+
+#ifdef SOA_WIDE
+    int width = soaWidthInternal();
+    i = width == 8 ? soaDivAvx512(res, a, b, count) : width == 4 ? soaDivAvx(res, a, b, count) : 0;
+#elif defined(SOA_SSE2)
+    i = soaDivSse2(res, a, b, count);
+#endif
+
+    for(; i < count; i++)
+    {
+        res[i] = a[i] / b[i];
+    }
+}
+
+static void soaDivValueInternal(M3dValue *res, const M3dValue *a, M3dValue b, size_t count)
+{
+    size_t i = 0;
+
+#ifdef SOA_WIDE
+    int width = soaWidthInternal();
+    i = width == 8 ? soaDivValueAvx512(res, a, b, count) : width == 4 ? soaDivValueAvx(res, a, b, count) : 0;
+#elif defined(SOA_SSE2)
+    i = soaDivValueSse2(res, a, b, count);
+#endif
+
+    for(; i < count; i++)
+    {
+        res[i] = a[i] / b;
+    }
+}
+
+static void soaLerpInternal(M3dValue *res, const M3dValue *a, const M3dValue *b, M3dValue t, size_t count)
+{
+    M3dValue s = 1 - t;
+    size_t i = 0;
+
+#ifdef SOA_WIDE
+    int width = soaWidthInternal();
+    i = width == 8 ? soaLerpAvx512(res, a, b, t, count) : width == 4 ? soaLerpAvx(res, a, b, t, count) : 0;
+#elif defined(SOA_SSE2)
+    i = soaLerpSse2(res, a, b, t, count);
+#endif
+
+    for(; i < count; i++)
+    {
+        res[i] = s * a[i] + b[i] * t;
+    }
+}
+
+// libm sqrt has to set errno, which stops the compiler from vectorizing it
+static void soaSqrtInternal(M3dValue *res, const M3dValue *a, size_t count)
+{
+    size_t i = 0;
+
+#ifdef SOA_WIDE
+    int width = soaWidthInternal();
+    i = width == 8 ? soaSqrtAvx512(res, a, count) : width == 4 ? soaSqrtAvx(res, a, count) : 0;
+#elif defined(SOA_SSE2)
+    i = soaSqrtSse2(res, a, count);
+#endif
+
+#if defined(M3D_SSE2) && defined(M3D_DOUBLE)
+    for(size_t last = m3dGroupEndInternal(i, count, 2); i < last; i += 2)
+    {
+        _mm_storeu_pd(res + i, _mm_sqrt_pd(_mm_loadu_pd(a + i)));
+    }
+#endif
+
+    for(; i < count; i++)
+    {
+        res[i] = m3dSqrtInternal(a[i]);
+    }
+}
+
+// the dot and cross streams read several components per element, so they have their own kernels.
+// these return where the kernels stopped, the callers finish the rest with the plain loop
+static size_t soaDotKernelInternal(M3dValue *res, const M3dValue *const *a, const M3dValue *const *b, int n, size_t count)
+{
+#ifdef SOA_WIDE
+    int width = soaWidthInternal();
+    return width == 8 ? soaDotAvx512(res, a, b, n, count) : width == 4 ? soaDotAvx(res, a, b, n, count) : 0;
+#elif defined(SOA_SSE2)
+    return soaDotSse2(res, a, b, n, count);
+#else
+    (void)res;
+    (void)a;
+    (void)b;
+    (void)n;
+    (void)count;
+    return 0;
+#endif
+}
+
+static size_t soaCrossKernelInternal(Vec3Soa res, Vec3Soa a, Vec3Soa b, size_t count)
+{
+#ifdef SOA_WIDE
+    int width = soaWidthInternal();
+    return width == 8 ? soaCrossAvx512(res, a, b, count) : width == 4 ? soaCrossAvx(res, a, b, count) : 0;
+#elif defined(SOA_SSE2)
+    return soaCrossSse2(res, a, b, count);
+#else
+    (void)res;
+    (void)a;
+    (void)b;
+    (void)count;
+    return 0;
+#endif
+}
+
+#define SOA_BLOCK 256
+
+/** ---------------- Vec2 */
+
+M3D_API void m3dVec2SoaFromArray(Vec2Soa res, const Vec2 *v)
+{
+    M3D_PROFILE_FUNCTION();
+    for(size_t i = 0; i < res.count; i++)
+    {
+        res.x[i] = v[i].x;
+        res.y[i] = v[i].y;
+    }
+}
+
+M3D_API void m3dVec2SoaToArray(Vec2 *res, Vec2Soa v)
+{
+    M3D_PROFILE_FUNCTION();
+    for(size_t i = 0; i < v.count; i++)
+    {
+        res[i].x = v.x[i];
+        res[i].y = v.y[i];
+    }
+}
+
+M3D_API void m3dVec2SoaAddVec2Soa(Vec2Soa res, Vec2Soa a, Vec2Soa b)
+{
+    M3D_PROFILE_FUNCTION();
+    soaAddInternal(res.x, a.x, b.x, a.count);
+    soaAddInternal(res.y, a.y, b.y, a.count);
+}
+
+M3D_API void m3dVec2SoaSubVec2Soa(Vec2Soa res, Vec2Soa a, Vec2Soa b)
+{
+    M3D_PROFILE_FUNCTION();
+    soaSubInternal(res.x, a.x, b.x, a.count);
+    soaSubInternal(res.y, a.y, b.y, a.count);
+}
+
+M3D_API void m3dVec2SoaMulVec2Soa(Vec2Soa res, Vec2Soa a, Vec2Soa b)
+{
+    M3D_PROFILE_FUNCTION();
+    soaMulInternal(res.x, a.x, b.x, a.count);
+    soaMulInternal(res.y, a.y, b.y, a.count);
+}
+
+M3D_API void m3dVec2SoaMulValue(Vec2Soa res, Vec2Soa a, M3dValue b)
+{
+    M3D_PROFILE_FUNCTION();
+    soaMulValueInternal(res.x, a.x, b, a.count);
+    soaMulValueInternal(res.y, a.y, b, a.count);
+}
+
+M3D_API void m3dVec2SoaDivValue(Vec2Soa res, Vec2Soa a, M3dValue b)
+{
+    M3D_PROFILE_FUNCTION();
+    soaDivValueInternal(res.x, a.x, b, a.count);
+    soaDivValueInternal(res.y, a.y, b, a.count);
+}
+
+M3D_API void m3dVec2SoaLerp(Vec2Soa res, Vec2Soa a, Vec2Soa b, M3dValue t)
+{
+    M3D_PROFILE_FUNCTION();
+    soaLerpInternal(res.x, a.x, b.x, t, a.count);
+    soaLerpInternal(res.y, a.y, b.y, t, a.count);
+}
+
+M3D_API void m3dVec2SoaDot(M3dValue *res, Vec2Soa a, Vec2Soa b)
+{
+    M3D_PROFILE_FUNCTION();
+    const M3dValue *ac[2] = {a.x, a.y};
+    const M3dValue *bc[2] = {b.x, b.y};
+    size_t i = soaDotKernelInternal(res, ac, bc, 2, a.count);
+
+    for(; i < a.count; i++)
+    {
+        res[i] = a.x[i] * b.x[i] + a.y[i] * b.y[i];
+    }
+}
+
+M3D_API void m3dVec2SoaLengthSqr(M3dValue *res, Vec2Soa v)
+{
+    M3D_PROFILE_FUNCTION();
+    m3dVec2SoaDot(res, v, v);
+}
+
+M3D_API void m3dVec2SoaLength(M3dValue *res, Vec2Soa v)
+{
+    M3D_PROFILE_FUNCTION();
+    m3dVec2SoaDot(res, v, v);
+    soaSqrtInternal(res, res, v.count);
+}
+
+M3D_API void m3dVec2SoaNormalized(Vec2Soa res, Vec2Soa v)
+{
+    M3D_PROFILE_FUNCTION();
+    M3dValue length[SOA_BLOCK];
+
+    for(size_t block = 0; block < v.count; block += SOA_BLOCK)
+    {
+        Vec2Soa part = v;
+        part.count = v.count - block < SOA_BLOCK ? v.count - block : SOA_BLOCK;
+        part.x += block;
+        part.y += block;
+
+        m3dVec2SoaLength(length, part);
+
+        soaDivInternal(res.x + block, part.x, length, part.count);
+        soaDivInternal(res.y + block, part.y, length, part.count);
+    }
+}
+
+/** ---------------- Vec3 */
+
+M3D_API void m3dVec3SoaFromArray(Vec3Soa res, const Vec3 *v)
+{
+    M3D_PROFILE_FUNCTION();
+    for(size_t i = 0; i < res.count; i++)
+    {
+        res.x[i] = v[i].x;
+        res.y[i] = v[i].y;
+        res.z[i] = v[i].z;
+    }
+}
+
+M3D_API void m3dVec3SoaToArray(Vec3 *res, Vec3Soa v)
+{
+    M3D_PROFILE_FUNCTION();
+    for(size_t i = 0; i < v.count; i++)
+    {
+        res[i].x = v.x[i];
+        res[i].y = v.y[i];
+        res[i].z = v.z[i];
+    }
+}
+
+M3D_API void m3dVec3SoaAddVec3Soa(Vec3Soa res, Vec3Soa a, Vec3Soa b)
+{
+    M3D_PROFILE_FUNCTION();
+    soaAddInternal(res.x, a.x, b.x, a.count);
+    soaAddInternal(res.y, a.y, b.y, a.count);
+    soaAddInternal(res.z, a.z, b.z, a.count);
+}
+
+M3D_API void m3dVec3SoaSubVec3Soa(Vec3Soa res, Vec3Soa a, Vec3Soa b)
+{
+    M3D_PROFILE_FUNCTION();
+    soaSubInternal(res.x, a.x, b.x, a.count);
+    soaSubInternal(res.y, a.y, b.y, a.count);
+    soaSubInternal(res.z, a.z, b.z, a.count);
+}
+
+M3D_API void m3dVec3SoaMulVec3Soa(Vec3Soa res, Vec3Soa a, Vec3Soa b)
+{
+    M3D_PROFILE_FUNCTION();
+    soaMulInternal(res.x, a.x, b.x, a.count);
+    soaMulInternal(res.y, a.y, b.y, a.count);
+    soaMulInternal(res.z, a.z, b.z, a.count);
+}
+
+M3D_API void m3dVec3SoaMulValue(Vec3Soa res, Vec3Soa a, M3dValue b)
+{
+    M3D_PROFILE_FUNCTION();
+    soaMulValueInternal(res.x, a.x, b, a.count);
+    soaMulValueInternal(res.y, a.y, b, a.count);
+    soaMulValueInternal(res.z, a.z, b, a.count);
+}
+
+M3D_API void m3dVec3SoaDivValue(Vec3Soa res, Vec3Soa a, M3dValue b)
+{
+    M3D_PROFILE_FUNCTION();
+    soaDivValueInternal(res.x, a.x, b, a.count);
+    soaDivValueInternal(res.y, a.y, b, a.count);
+    soaDivValueInternal(res.z, a.z, b, a.count);
+}
+
+M3D_API void m3dVec3SoaLerp(Vec3Soa res, Vec3Soa a, Vec3Soa b, M3dValue t)
+{
+    M3D_PROFILE_FUNCTION();
+    soaLerpInternal(res.x, a.x, b.x, t, a.count);
+    soaLerpInternal(res.y, a.y, b.y, t, a.count);
+    soaLerpInternal(res.z, a.z, b.z, t, a.count);
+}
+
+M3D_API void m3dVec3SoaCross(Vec3Soa res, Vec3Soa a, Vec3Soa b)
+{
+    M3D_PROFILE_FUNCTION();
+    size_t i = soaCrossKernelInternal(res, a, b, a.count);
+
+    // every component is read before any is written, res may be the storage of a or b
+    for(; i < a.count; i++)
+    {
+        M3dValue ax = a.x[i], ay = a.y[i], az = a.z[i];
+        M3dValue bx = b.x[i], by = b.y[i], bz = b.z[i];
+
+        res.x[i] = ay * bz - az * by;
+        res.y[i] = az * bx - ax * bz;
+        res.z[i] = ax * by - ay * bx;
+    }
+}
+
+M3D_API void m3dVec3SoaDot(M3dValue *res, Vec3Soa a, Vec3Soa b)
+{
+    M3D_PROFILE_FUNCTION();
+    const M3dValue *ac[3] = {a.x, a.y, a.z};
+    const M3dValue *bc[3] = {b.x, b.y, b.z};
+    size_t i = soaDotKernelInternal(res, ac, bc, 3, a.count);
+
+    for(; i < a.count; i++)
+    {
+        res[i] = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i];
+    }
+}
+
+M3D_API void m3dVec3SoaLengthSqr(M3dValue *res, Vec3Soa v)
+{
+    M3D_PROFILE_FUNCTION();
+    m3dVec3SoaDot(res, v, v);
+}
+
+M3D_API void m3dVec3SoaLength(M3dValue *res, Vec3Soa v)
+{
+    M3D_PROFILE_FUNCTION();
+    m3dVec3SoaDot(res, v, v);
+    soaSqrtInternal(res, res, v.count);
+}
+
+M3D_API void m3dVec3SoaNormalized(Vec3Soa res, Vec3Soa v)
+{
+    M3D_PROFILE_FUNCTION();
+    M3dValue length[SOA_BLOCK];
+
+    for(size_t block = 0; block < v.count; block += SOA_BLOCK)
+    {
+        Vec3Soa part = v;
+        part.count = v.count - block < SOA_BLOCK ? v.count - block : SOA_BLOCK;
+        part.x += block;
+        part.y += block;
+        part.z += block;
+
+        m3dVec3SoaLength(length, part);
+
+        soaDivInternal(res.x + block, part.x, length, part.count);
+        soaDivInternal(res.y + block, part.y, length, part.count);
+        soaDivInternal(res.z + block, part.z, length, part.count);
+    }
+}
+
+/** ---------------- Vec4 */
+
+M3D_API void m3dVec4SoaFromArray(Vec4Soa res, const Vec4 *v)
+{
+    M3D_PROFILE_FUNCTION();
+    for(size_t i = 0; i < res.count; i++)
+    {
+        res.x[i] = v[i].x;
+        res.y[i] = v[i].y;
+        res.z[i] = v[i].z;
+        res.w[i] = v[i].w;
+    }
+}
+
+M3D_API void m3dVec4SoaToArray(Vec4 *res, Vec4Soa v)
+{
+    M3D_PROFILE_FUNCTION();
+    for(size_t i = 0; i < v.count; i++)
+    {
+        res[i].x = v.x[i];
+        res[i].y = v.y[i];
+        res[i].z = v.z[i];
+        res[i].w = v.w[i];
+    }
+}
+
+M3D_API void m3dVec4SoaAddVec4Soa(Vec4Soa res, Vec4Soa a, Vec4Soa b)
+{
+    M3D_PROFILE_FUNCTION();
+    soaAddInternal(res.x, a.x, b.x, a.count);
+    soaAddInternal(res.y, a.y, b.y, a.count);
+    soaAddInternal(res.z, a.z, b.z, a.count);
+    soaAddInternal(res.w, a.w, b.w, a.count);
+}
+
+M3D_API void m3dVec4SoaSubVec4Soa(Vec4Soa res, Vec4Soa a, Vec4Soa b)
+{
+    M3D_PROFILE_FUNCTION();
+    soaSubInternal(res.x, a.x, b.x, a.count);
+    soaSubInternal(res.y, a.y, b.y, a.count);
+    soaSubInternal(res.z, a.z, b.z, a.count);
+    soaSubInternal(res.w, a.w, b.w, a.count);
+}
+
+M3D_API void m3dVec4SoaMulVec4Soa(Vec4Soa res, Vec4Soa a, Vec4Soa b)
+{
+    M3D_PROFILE_FUNCTION();
+    soaMulInternal(res.x, a.x, b.x, a.count);
+    soaMulInternal(res.y, a.y, b.y, a.count);
+    soaMulInternal(res.z, a.z, b.z, a.count);
+    soaMulInternal(res.w, a.w, b.w, a.count);
+}
+
+M3D_API void m3dVec4SoaMulValue(Vec4Soa res, Vec4Soa a, M3dValue b)
+{
+    M3D_PROFILE_FUNCTION();
+    soaMulValueInternal(res.x, a.x, b, a.count);
+    soaMulValueInternal(res.y, a.y, b, a.count);
+    soaMulValueInternal(res.z, a.z, b, a.count);
+    soaMulValueInternal(res.w, a.w, b, a.count);
+}
+
+M3D_API void m3dVec4SoaDivValue(Vec4Soa res, Vec4Soa a, M3dValue b)
+{
+    M3D_PROFILE_FUNCTION();
+    soaDivValueInternal(res.x, a.x, b, a.count);
+    soaDivValueInternal(res.y, a.y, b, a.count);
+    soaDivValueInternal(res.z, a.z, b, a.count);
+    soaDivValueInternal(res.w, a.w, b, a.count);
+}
+
+M3D_API void m3dVec4SoaLerp(Vec4Soa res, Vec4Soa a, Vec4Soa b, M3dValue t)
+{
+    M3D_PROFILE_FUNCTION();
+    soaLerpInternal(res.x, a.x, b.x, t, a.count);
+    soaLerpInternal(res.y, a.y, b.y, t, a.count);
+    soaLerpInternal(res.z, a.z, b.z, t, a.count);
+    soaLerpInternal(res.w, a.w, b.w, t, a.count);
+}
+
+M3D_API void m3dVec4SoaDot(M3dValue *res, Vec4Soa a, Vec4Soa b)
+{
+    M3D_PROFILE_FUNCTION();
+    const M3dValue *ac[4] = {a.x, a.y, a.z, a.w};
+    const M3dValue *bc[4] = {b.x, b.y, b.z, b.w};
+    size_t i = soaDotKernelInternal(res, ac, bc, 4, a.count);
+
+    for(; i < a.count; i++)
+    {
+        res[i] = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i] + a.w[i] * b.w[i];
+    }
+}
+
+M3D_API void m3dVec4SoaLengthSqr(M3dValue *res, Vec4Soa v)
+{
+    M3D_PROFILE_FUNCTION();
+    m3dVec4SoaDot(res, v, v);
+}
+
+M3D_API void m3dVec4SoaLength(M3dValue *res, Vec4Soa v)
+{
+    M3D_PROFILE_FUNCTION();
+    m3dVec4SoaDot(res, v, v);
+    soaSqrtInternal(res, res, v.count);
+}
+
+M3D_API void m3dVec4SoaNormalized(Vec4Soa res, Vec4Soa v)
+{
+    M3D_PROFILE_FUNCTION();
+    M3dValue length[SOA_BLOCK];
+
+    for(size_t block = 0; block < v.count; block += SOA_BLOCK)
+    {
+        Vec4Soa part = v;
+        part.count = v.count - block < SOA_BLOCK ? v.count - block : SOA_BLOCK;
+        part.x += block;
+        part.y += block;
+        part.z += block;
+        part.w += block;
+
+        m3dVec4SoaLength(length, part);
+
+        soaDivInternal(res.x + block, part.x, length, part.count);
+        soaDivInternal(res.y + block, part.y, length, part.count);
+        soaDivInternal(res.z + block, part.z, length, part.count);
+        soaDivInternal(res.w + block, part.w, length, part.count);
+    }
+}
+
+#endif // M3D_FIXED